@@ -0,0 +1,171 @@
+/*
+	Copyright 2009 Arizona State University
+	
+	This file is part of Sirens.
+	
+	Sirens is free software: you can redistribute it and/or modify it under the terms 
+	of the GNU Lesser General Public License as  published by the Free Software 
+	Foundation, either version 3 of the License, or (at your option) any later version.
+	
+	Sirens is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+	without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR 
+	PURPOSE.  See the GNU General Public License for more details.
+	
+	You should have received a copy of the GNU Lesser General Public License along
+	with Sirens. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "Feature.h"
+#include "support/AlignedMemory.h"
+
+#include <algorithm>
+#include <cstring>
+using namespace std;
+
+namespace Sirens {
+	Feature::Feature(string feature_name, int capacity) {
+		name = feature_name;
+		
+		history = NULL;
+		storage = NULL;
+		normalizedHistory = NULL;
+		historySize = 0;
+		historyCapacity = 0;
+		normalizedCapacity = 0;
+		normalizedSize = 0;
+		normalizedMin = 0;
+		normalizedMax = 0;
+		
+		if (capacity > 0)
+			reserve(capacity);
+	}
+	
+	Feature::~Feature() {
+		freeAligned(storage);
+		freeAligned(normalizedHistory);
+	}
+	
+	/*-------------*
+	 * Attributes. *
+	 *-------------*/
+	
+	string Feature::getName() {
+		return name;
+	}
+	
+	void Feature::setName(string value) {
+		name = value;
+	}
+	
+	SegmentationParameters* Feature::getSegmentationParameters() {
+		return &segmentationParameters;
+	}
+	
+	/*----------*
+	 * History. *
+	 *----------*/
+	
+	// Make sure the feature owns storage for at least capacity frames, keeping what is already there.
+	void Feature::reserve(int capacity) {
+		if (history == storage && capacity <= historyCapacity)
+			return;
+		
+		float* new_storage = allocateAligned<float>(capacity);
+		
+		if (historySize > 0)
+			memcpy(new_storage, history, historySize * sizeof(float));
+		
+		freeAligned(storage);
+		
+		storage = new_storage;
+		history = storage;
+		historyCapacity = capacity;
+	}
+	
+	void Feature::addHistoryFrame(float value) {
+		addHistoryFrames(&value, 1);
+	}
+	
+	void Feature::addHistoryFrames(const float* values, int count) {
+		if (history != storage || historySize + count > historyCapacity)
+			reserve(max(historySize + count, max(2 * historyCapacity, 1024)));
+		
+		memcpy(storage + historySize, values, count * sizeof(float));
+		historySize += count;
+	}
+	
+	void Feature::setExternalHistory(const float* values, int size) {
+		history = values;
+		historySize = size;
+		normalizedSize = 0;
+	}
+	
+	void Feature::clearHistory() {
+		history = storage;
+		historySize = 0;
+		normalizedSize = 0;
+	}
+	
+	int Feature::getHistorySize() {
+		return historySize;
+	}
+	
+	float Feature::getHistoryFrame(int frame) {
+		normalize();
+		return normalizedHistory[frame];
+	}
+	
+	FeatureSpan Feature::getHistory(int start, int length) {
+		start = max(0, min(start, historySize));
+		
+		FeatureSpan span;
+		span.values = history + start;
+		span.size = length < 0 ? historySize - start : min(length, historySize - start);
+		return span;
+	}
+	
+	FeatureSpan Feature::getNormalizedHistory(int start, int length) {
+		normalize();
+		start = max(0, min(start, historySize));
+		
+		FeatureSpan span;
+		span.values = normalizedHistory + start;
+		span.size = length < 0 ? historySize - start : min(length, historySize - start);
+		return span;
+	}
+	
+	// Bring the normalized column up to date. Only frames added since the last call are normalized, unless the range changed.
+	void Feature::normalize() {
+		double min_value = segmentationParameters.getMinFeatureValue();
+		double max_value = segmentationParameters.getMaxFeatureValue();
+		
+		if (min_value != normalizedMin || max_value != normalizedMax) {
+			normalizedSize = 0;
+			normalizedMin = min_value;
+			normalizedMax = max_value;
+		}
+		
+		if (normalizedSize == historySize)
+			return;
+		
+		if (historySize > normalizedCapacity) {
+			float* new_normalized_history = allocateAligned<float>(max(historySize, 2 * normalizedCapacity));
+			
+			if (normalizedSize > 0)
+				memcpy(new_normalized_history, normalizedHistory, normalizedSize * sizeof(float));
+			
+			freeAligned(normalizedHistory);
+			
+			normalizedHistory = new_normalized_history;
+			normalizedCapacity = max(historySize, 2 * normalizedCapacity);
+		}
+		
+		float offset = min_value;
+		float scale = max_value != min_value ? 1.0 / (max_value - min_value) : 1.0;
+		
+		for (int i = normalizedSize; i < historySize; i++)
+			normalizedHistory[i] = (history[i] - offset) * scale;
+		
+		normalizedSize = historySize;
+	}
+}
@@ -0,0 +1,99 @@
+/*
+	Copyright 2009 Arizona State University
+	
+	This file is part of Sirens.
+	
+	Sirens is free software: you can redistribute it and/or modify it under the terms 
+	of the GNU Lesser General Public License as  published by the Free Software 
+	Foundation, either version 3 of the License, or (at your option) any later version.
+	
+	Sirens is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+	without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR 
+	PURPOSE.  See the GNU General Public License for more details.
+	
+	You should have received a copy of the GNU Lesser General Public License along
+	with Sirens. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef __FEATURE_H__
+#define __FEATURE_H__
+
+#include "segmentation/SegmentationParameters.h"
+
+#include <string>
+using namespace std;
+
+/*
+	A feature's trajectory over time, as the segmenter sees it.
+	
+	History is stored as one contiguous column per feature, aligned to a cache line, so that the segmenter
+	(or anything else) can read blocks of frames through a FeatureSpan rather than one value at a time.
+	
+	Values are stored as given. The segmenter works on values normalized between the feature's
+	SegmentationParameters::getMinFeatureValue and getMaxFeatureValue; these are computed for the whole
+	column at once by getNormalizedHistory and kept until new frames are added or the range changes.
+*/
+
+namespace Sirens {
+	// A read-only view of a contiguous range of frames.
+	struct FeatureSpan {
+		const float* values;
+		int size;
+		
+		const float* begin() const { return values; }
+		const float* end() const { return values + size; }
+		float operator[](int index) const { return values[index]; }
+	};
+	
+	class Feature {
+	protected:
+		string name;
+		SegmentationParameters segmentationParameters;
+		
+		// Raw history column. This is either storage owned by the feature, or an external column (see setExternalHistory.)
+		const float* history;
+		float* storage;
+		int historySize;
+		int historyCapacity;
+		
+		// Normalized history column, and the range it was normalized with.
+		float* normalizedHistory;
+		int normalizedCapacity;
+		int normalizedSize;
+		double normalizedMin;
+		double normalizedMax;
+		
+		void reserve(int capacity);
+		void normalize();
+		
+	public:
+		Feature(string feature_name = "", int capacity = 0);
+		virtual ~Feature();
+		
+		Feature(const Feature&) = delete;
+		Feature& operator=(const Feature&) = delete;
+		
+		string getName();
+		void setName(string value);
+		
+		SegmentationParameters* getSegmentationParameters();
+		
+		// History.
+		void addHistoryFrame(float value);
+		void addHistoryFrames(const float* values, int count);
+		void clearHistory();
+		
+		// Use a column that lives elsewhere (e.g. a memory-mapped file) without copying it. It must outlive the feature,
+		// or at least its use as external history. Adding frames afterward copies the column into the feature's own storage.
+		void setExternalHistory(const float* values, int size);
+		
+		int getHistorySize();
+		float getHistoryFrame(int frame);				// Normalized value of a single frame.
+		
+		// Frames from start (clamped to the column), up to length of them or to the end if length is negative.
+		FeatureSpan getHistory(int start = 0, int length = -1);
+		FeatureSpan getNormalizedHistory(int start = 0, int length = -1);
+	};
+}
+
+#endif
@@ -0,0 +1,248 @@
+/*
+	Copyright 2009 Arizona State University
+	
+	This file is part of Sirens.
+	
+	Sirens is free software: you can redistribute it and/or modify it under the terms 
+	of the GNU Lesser General Public License as  published by the Free Software 
+	Foundation, either version 3 of the License, or (at your option) any later version.
+	
+	Sirens is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+	without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR 
+	PURPOSE.  See the GNU General Public License for more details.
+	
+	You should have received a copy of the GNU Lesser General Public License along
+	with Sirens. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "FeatureCache.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#include <dirent.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <utime.h>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/file.h>
+#endif
+
+using namespace std;
+
+namespace Sirens {
+	static const char* FeatureCacheExtension = ".features";
+	
+	/*---------------*
+	 * Content hash. *
+	 *---------------*/
+	
+	ContentHash::ContentHash() {
+		hashes[0] = 14695981039346656037ULL;
+		hashes[1] = 9650029242287828579ULL;
+	}
+	
+	void ContentHash::add(const void* data, size_t bytes) {
+		const unsigned char* item = (const unsigned char*) data;
+		
+		for (size_t i = 0; i < bytes; i++) {
+			hashes[0] = (hashes[0] ^ item[i]) * 1099511628211ULL;
+			hashes[1] = (hashes[1] ^ item[i]) * 1099511628211ULL;
+			hashes[1] ^= hashes[1] >> 29;
+		}
+	}
+	
+	void ContentHash::add(const float* samples, size_t count) {
+		add((const void*) samples, count * sizeof(float));
+	}
+	
+	// Strings are length-prefixed so that adjacent fields cannot run into each other.
+	void ContentHash::add(const string& value) {
+		uint64_t length = value.size();
+		
+		add((const void*) &length, sizeof(length));
+		add((const void*) value.data(), value.size());
+	}
+	
+	string ContentHash::toString() {
+		char text[33];
+		snprintf(text, sizeof(text), "%016llx%016llx", (unsigned long long) hashes[0], (unsigned long long) hashes[1]);
+		
+		return text;
+	}
+	
+	/*--------*
+	 * Cache. *
+	 *--------*/
+	
+	FeatureCache::FeatureCache(string cache_directory, uint64_t size_budget) {
+		directory = cache_directory;
+		sizeBudget = size_budget;
+	}
+	
+	string FeatureCache::getKey(const string& audio_hash, double sample_rate, const string& plugin_identifier,
+		int plugin_version, const map<string, float>& parameters, int block_size, int step_size) {
+		ContentHash hash;
+		char number[64];
+		
+		hash.add(audio_hash);
+		hash.add(plugin_identifier);
+		
+		snprintf(number, sizeof(number), "%.17g/%d/%d/%d", sample_rate, plugin_version, block_size, step_size);
+		hash.add(string(number));
+		
+		// The map is ordered by identifier, so the key does not depend on the order parameters were set in.
+		for (map<string, float>::const_iterator item = parameters.begin(); item != parameters.end(); item++) {
+			snprintf(number, sizeof(number), "%.9g", item->second);
+			hash.add(item->first);
+			hash.add(string(number));
+		}
+		
+		return hash.toString();
+	}
+	
+	string FeatureCache::getEntryPath(const string& key) {
+		return directory + "/" + key + FeatureCacheExtension;
+	}
+	
+	// Unique per process and per call, so concurrent writers of the same entry, in other processes or other threads of
+	// this one, do not collide.
+	string FeatureCache::getTemporaryPath(const string& key) {
+		static atomic<unsigned long> writers(0);
+		
+		char suffix[64];
+		snprintf(suffix, sizeof(suffix), ".%ld.%lu.tmp", (long) getpid(), writers.fetch_add(1));
+		
+		return directory + "/" + key + suffix;
+	}
+	
+	bool FeatureCache::lookup(const string& key, FeatureFileReader& reader) {
+		string path = getEntryPath(key);
+		
+		if (!reader.open(path))
+			return false;
+		
+		// Mark as recently used.
+		utime(path.c_str(), NULL);
+		return true;
+	}
+	
+	bool FeatureCache::begin(const string& key, FeatureFileWriter& writer, double sample_rate, int step_size, int block_size) {
+		return writer.open(getTemporaryPath(key), sample_rate, step_size, block_size);
+	}
+	
+	bool FeatureCache::commit(const string& key, FeatureFileWriter& writer) {
+		string temporary_path = writer.getPath();
+		
+		bool success = writer.close() && rename(temporary_path.c_str(), getEntryPath(key).c_str()) == 0;
+		
+		if (!success)
+			remove(temporary_path.c_str());
+		else
+			evict(key);
+		
+		return success;
+	}
+	
+	struct FeatureCacheEntry {
+		string path;
+		uint64_t size;
+		time_t lastUsed;
+	};
+	
+	static bool SortLeastRecentlyUsed(const FeatureCacheEntry& entry1, const FeatureCacheEntry& entry2) {
+		return entry1.lastUsed < entry2.lastUsed;
+	}
+	
+	static vector<FeatureCacheEntry> getEntries(const string& directory) {
+		vector<FeatureCacheEntry> entries;
+		DIR* listing = opendir(directory.c_str());
+		
+		if (listing == NULL)
+			return entries;
+		
+		size_t extension_length = strlen(FeatureCacheExtension);
+		
+		while (struct dirent* item = readdir(listing)) {
+			string name = item->d_name;
+			
+			if (name.size() <= extension_length || name.compare(name.size() - extension_length, extension_length, FeatureCacheExtension) != 0)
+				continue;
+			
+			FeatureCacheEntry entry;
+			struct stat status;
+			
+			entry.path = directory + "/" + name;
+			
+			if (stat(entry.path.c_str(), &status) == 0) {
+				entry.size = status.st_size;
+				entry.lastUsed = status.st_mtime;
+				entries.push_back(entry);
+			}
+		}
+		
+		closedir(listing);
+		return entries;
+	}
+	
+	void FeatureCache::evict(const string& keep_key) {
+#ifndef _WIN32
+		// Only one process evicts at a time; if another one is already at it, leave it to them.
+		string lock_path = directory + "/.lock";
+		int lock = open(lock_path.c_str(), O_RDWR | O_CREAT, 0644);
+		
+		if (lock < 0)
+			return;
+		
+		if (flock(lock, LOCK_EX | LOCK_NB) != 0) {
+			close(lock);
+			return;
+		}
+#endif
+		
+		vector<FeatureCacheEntry> entries = getEntries(directory);
+		uint64_t size = 0;
+		
+		for (size_t i = 0; i < entries.size(); i++)
+			size += entries[i].size;
+		
+		if (size > sizeBudget) {
+			sort(entries.begin(), entries.end(), SortLeastRecentlyUsed);
+			
+			string keep_path = keep_key.empty() ? "" : getEntryPath(keep_key);
+			
+			for (size_t i = 0; i < entries.size() && size > sizeBudget; i++) {
+				if (entries[i].path != keep_path && remove(entries[i].path.c_str()) == 0)
+					size -= entries[i].size;
+			}
+		}
+		
+#ifndef _WIN32
+		flock(lock, LOCK_UN);
+		close(lock);
+#endif
+	}
+	
+	uint64_t FeatureCache::getSize() {
+		vector<FeatureCacheEntry> entries = getEntries(directory);
+		uint64_t size = 0;
+		
+		for (size_t i = 0; i < entries.size(); i++)
+			size += entries[i].size;
+		
+		return size;
+	}
+	
+	uint64_t FeatureCache::getSizeBudget() {
+		return sizeBudget;
+	}
+	
+	void FeatureCache::setSizeBudget(uint64_t value) {
+		sizeBudget = value;
+	}
+}
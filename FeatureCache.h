@@ -0,0 +1,109 @@
+/*
+	Copyright 2009 Arizona State University
+	
+	This file is part of Sirens.
+	
+	Sirens is free software: you can redistribute it and/or modify it under the terms 
+	of the GNU Lesser General Public License as  published by the Free Software 
+	Foundation, either version 3 of the License, or (at your option) any later version.
+	
+	Sirens is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+	without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR 
+	PURPOSE.  See the GNU General Public License for more details.
+	
+	You should have received a copy of the GNU Lesser General Public License along
+	with Sirens. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef __FEATURECACHE_H__
+#define __FEATURECACHE_H__
+
+#include "FeatureFile.h"
+
+#include <map>
+#include <stdint.h>
+#include <string>
+using namespace std;
+
+/*
+	On-disk cache of extracted features.
+	
+	Each entry is a feature file (see FeatureFile.h) holding the output of one plugin on one piece of audio.
+	Entries are keyed by a hash of the audio content together with everything that affects the output:
+	input sample rate, plugin identifier, plugin version, parameter values, block size, and step size. Changing
+	any of these (including bumping a plugin's version when its output changes) simply misses the cache.
+	
+	The cache directory may be shared by several processes:
+		- Entries are written to a temporary file and renamed into place, so readers never see a partial
+		  entry, and two processes storing the same entry just replace one another's identical result.
+		- Looking up an entry marks it as recently used by updating its modification time.
+		- After each store, the least recently used entries are removed until the cache fits in its size
+		  budget. Only one process evicts at a time (the others skip it.) Entries that are removed while
+		  mapped by a reader remain readable until the reader closes them.
+	
+	Usage:
+		ContentHash audio_hash;
+		audio_hash.add(samples, count);
+		
+		string key = FeatureCache::getKey(audio_hash.toString(), sample_rate, "loudness", 1, parameters, 1024, 512);
+		
+		FeatureFileReader reader;
+		
+		if (!cache.lookup(key, reader)) {
+			FeatureFileWriter writer;
+			cache.begin(key, writer, sample_rate, 512, 1024);
+			... extract, writer.addFrames(...) ...
+			cache.commit(key, writer);
+			cache.lookup(key, reader);
+		}
+*/
+
+namespace Sirens {
+	// 128-bit FNV-1a hash (two independent 64-bit lanes) of arbitrary data, built incrementally.
+	class ContentHash {
+	protected:
+		uint64_t hashes[2];
+		
+	public:
+		ContentHash();
+		
+		void add(const void* data, size_t bytes);
+		void add(const float* samples, size_t count);
+		void add(const string& value);
+		
+		string toString();
+	};
+	
+	class FeatureCache {
+	protected:
+		string directory;
+		uint64_t sizeBudget;
+		
+		string getEntryPath(const string& key);
+		string getTemporaryPath(const string& key);
+		
+	public:
+		FeatureCache(string cache_directory, uint64_t size_budget);
+		
+		// Key for one plugin's output on a piece of audio, identified by the hash of its content and its sample rate
+		// (the same samples at another rate are different audio to the plugins.)
+		static string getKey(const string& audio_hash, double sample_rate, const string& plugin_identifier,
+			int plugin_version, const map<string, float>& parameters, int block_size, int step_size);
+		
+		// Open a cached entry. Returns false on a miss.
+		bool lookup(const string& key, FeatureFileReader& reader);
+		
+		// Start writing a new entry, and make it visible to other lookups once written.
+		bool begin(const string& key, FeatureFileWriter& writer, double sample_rate, int step_size, int block_size);
+		bool commit(const string& key, FeatureFileWriter& writer);
+		
+		// Remove least recently used entries until the cache fits in its size budget, except for the entry with keep_key.
+		void evict(const string& keep_key = "");
+		
+		uint64_t getSize();
+		uint64_t getSizeBudget();
+		void setSizeBudget(uint64_t value);
+	};
+}
+
+#endif
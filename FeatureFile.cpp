@@ -0,0 +1,345 @@
+/*
+	Copyright 2009 Arizona State University
+	
+	This file is part of Sirens.
+	
+	Sirens is free software: you can redistribute it and/or modify it under the terms 
+	of the GNU Lesser General Public License as  published by the Free Software 
+	Foundation, either version 3 of the License, or (at your option) any later version.
+	
+	Sirens is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+	without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR 
+	PURPOSE.  See the GNU General Public License for more details.
+	
+	You should have received a copy of the GNU Lesser General Public License along
+	with Sirens. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "FeatureFile.h"
+#include "support/AlignedMemory.h"
+
+#include <cstring>
+
+#ifdef _WIN32
+#include <fstream>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+namespace Sirens {
+	static const char FeatureFileMagic[8] = "SIRENSF";
+	static const uint32_t FeatureFileVersion = 1;
+	static const uint64_t FeatureFileAlignment = 64;
+	
+	static_assert(sizeof(FeatureFileHeader) == 64, "FeatureFileHeader must be 64 bytes.");
+	static_assert(sizeof(FeatureFileColumn) == 256, "FeatureFileColumn must be 256 bytes.");
+	
+	static uint64_t alignOffset(uint64_t offset) {
+		return (offset + FeatureFileAlignment - 1) & ~(FeatureFileAlignment - 1);
+	}
+	
+	static bool writePadding(FILE* file, uint64_t from, uint64_t to) {
+		char zeros[FeatureFileAlignment] = {0};
+		return to == from || fwrite(zeros, 1, to - from, file) == to - from;
+	}
+	
+	/*---------*
+	 * Writer. *
+	 *---------*/
+	
+	FeatureFileWriter::FeatureFileWriter() {
+		memset(&header, 0, sizeof(FeatureFileHeader));
+	}
+	
+	FeatureFileWriter::~FeatureFileWriter() {
+		for (int i = 0; i < int(spools.size()); i++) {
+			if (spools[i] != NULL) {
+				fclose(spools[i]);
+				remove(getSpoolPath(i).c_str());
+			}
+		}
+	}
+	
+	string FeatureFileWriter::getSpoolPath(int column) {
+		char suffix[32];
+		snprintf(suffix, sizeof(suffix), ".column%d", column);
+		
+		return path + suffix;
+	}
+	
+	bool FeatureFileWriter::open(string file_path, double sample_rate, int step_size, int block_size) {
+		path = file_path;
+		
+		memset(&header, 0, sizeof(FeatureFileHeader));
+		memcpy(header.magic, FeatureFileMagic, sizeof(header.magic));
+		header.version = FeatureFileVersion;
+		header.sampleRate = sample_rate;
+		header.stepSize = step_size;
+		header.blockSize = block_size;
+		
+		return !path.empty();
+	}
+	
+	string FeatureFileWriter::getPath() {
+		return path;
+	}
+	
+	int FeatureFileWriter::addFeature(string name, string parameters) {
+		FeatureFileColumn column;
+		memset(&column, 0, sizeof(FeatureFileColumn));
+		
+		strncpy(column.name, name.c_str(), sizeof(column.name) - 1);
+		strncpy(column.parameters, parameters.c_str(), sizeof(column.parameters) - 1);
+		
+		FILE* spool = fopen(getSpoolPath(columns.size()).c_str(), "w+b");
+		
+		if (spool == NULL)
+			return -1;
+		
+		columns.push_back(column);
+		spools.push_back(spool);
+		
+		return columns.size() - 1;
+	}
+	
+	bool FeatureFileWriter::addFrames(int column, const float* values, int count) {
+		if (count < 0 || column < 0 || column >= int(spools.size()) || spools[column] == NULL)
+			return false;
+		
+		if (fwrite(values, sizeof(float), count, spools[column]) != size_t(count))
+			return false;
+		
+		columns[column].frames += count;
+		return true;
+	}
+	
+	bool FeatureFileWriter::addFrame(int column, float value) {
+		return addFrames(column, &value, 1);
+	}
+	
+	bool FeatureFileWriter::close() {
+		// Every column needs its spool; they are all gone if the file has already been closed.
+		for (int i = 0; i < int(spools.size()); i++) {
+			if (spools[i] == NULL)
+				return false;
+		}
+		
+		FILE* file = fopen(path.c_str(), "wb");
+		
+		if (file == NULL)
+			return false;
+		
+		// Lay out the columns.
+		header.featureCount = columns.size();
+		header.frameCount = 0;
+		
+		uint64_t offset = alignOffset(sizeof(FeatureFileHeader) + columns.size() * sizeof(FeatureFileColumn));
+		
+		for (int i = 0; i < int(columns.size()); i++) {
+			columns[i].offset = offset;
+			offset = alignOffset(offset + columns[i].frames * sizeof(float));
+			
+			if (columns[i].frames > header.frameCount)
+				header.frameCount = columns[i].frames;
+		}
+		
+		bool success = fwrite(&header, sizeof(FeatureFileHeader), 1, file) == 1;
+		
+		if (success && columns.size() > 0)
+			success = fwrite(&columns[0], sizeof(FeatureFileColumn), columns.size(), file) == columns.size();
+		
+		uint64_t position = sizeof(FeatureFileHeader) + columns.size() * sizeof(FeatureFileColumn);
+		
+		// Copy each spooled column into place.
+		vector<char> buffer(1 << 16);
+		
+		for (int i = 0; success && i < int(columns.size()); i++) {
+			success = writePadding(file, position, columns[i].offset);
+			position = columns[i].offset;
+			
+			rewind(spools[i]);
+			
+			size_t read;
+			
+			while (success && (read = fread(&buffer[0], 1, buffer.size(), spools[i])) > 0) {
+				success = fwrite(&buffer[0], 1, read, file) == read;
+				position += read;
+			}
+			
+			fclose(spools[i]);
+			remove(getSpoolPath(i).c_str());
+			spools[i] = NULL;
+		}
+		
+		if (success)
+			success = writePadding(file, position, alignOffset(position));
+		
+		success = fclose(file) == 0 && success;
+		
+		// Don't leave a truncated file behind.
+		if (!success)
+			remove(path.c_str());
+		
+		return success;
+	}
+	
+	/*---------*
+	 * Reader. *
+	 *---------*/
+	
+	FeatureFileReader::FeatureFileReader() {
+		data = NULL;
+		size = 0;
+		mapped = false;
+		header = NULL;
+		columns = NULL;
+	}
+	
+	FeatureFileReader::~FeatureFileReader() {
+		close();
+	}
+	
+	bool FeatureFileReader::open(string file_path) {
+		close();
+		
+#ifdef _WIN32
+		// No mmap; read the file into aligned memory instead.
+		ifstream file(file_path.c_str(), ios::binary | ios::ate);
+		
+		if (!file)
+			return false;
+		
+		size = file.tellg();
+		char* buffer = allocateAligned<char>(size);
+		
+		file.seekg(0);
+		file.read(buffer, size);
+		data = buffer;
+		
+		if (!file) {
+			close();
+			return false;
+		}
+#else
+		int descriptor = ::open(file_path.c_str(), O_RDONLY);
+		
+		if (descriptor < 0)
+			return false;
+		
+		struct stat status;
+		
+		if (fstat(descriptor, &status) != 0 || status.st_size == 0) {
+			::close(descriptor);
+			return false;
+		}
+		
+		size = status.st_size;
+		void* map = mmap(NULL, size, PROT_READ, MAP_SHARED, descriptor, 0);
+		::close(descriptor);
+		
+		if (map == MAP_FAILED) {
+			size = 0;
+			return false;
+		}
+		
+		data = (const char*) map;
+		mapped = true;
+#endif
+		
+		// Validate the header and column table.
+		header = (const FeatureFileHeader*) data;
+		columns = (const FeatureFileColumn*) (data + sizeof(FeatureFileHeader));
+		
+		bool valid = size >= sizeof(FeatureFileHeader) &&
+			memcmp(header->magic, FeatureFileMagic, sizeof(header->magic)) == 0 &&
+			header->version == FeatureFileVersion &&
+			size >= sizeof(FeatureFileHeader) + header->featureCount * sizeof(FeatureFileColumn);
+		
+		for (int i = 0; valid && i < int(header->featureCount); i++)
+			valid = columns[i].offset % FeatureFileAlignment == 0 && columns[i].offset + columns[i].frames * sizeof(float) <= size;
+		
+		if (!valid) {
+			close();
+			return false;
+		}
+		
+		for (int i = 0; i < int(header->featureCount); i++) {
+			Feature* feature = new Feature(getFeatureName(i));
+			feature->setExternalHistory(getColumn(i).values, getColumn(i).size);
+			features.push_back(feature);
+		}
+		
+		return true;
+	}
+	
+	void FeatureFileReader::close() {
+		for (int i = 0; i < int(features.size()); i++)
+			delete features[i];
+		
+		features.clear();
+		
+		if (data != NULL) {
+#ifdef _WIN32
+			freeAligned((void*) data);
+#else
+			if (mapped)
+				munmap((void*) data, size);
+#endif
+		}
+		
+		data = NULL;
+		size = 0;
+		mapped = false;
+		header = NULL;
+		columns = NULL;
+	}
+	
+	double FeatureFileReader::getSampleRate() {
+		return header != NULL ? header->sampleRate : 0;
+	}
+	
+	int FeatureFileReader::getStepSize() {
+		return header != NULL ? header->stepSize : 0;
+	}
+	
+	int FeatureFileReader::getBlockSize() {
+		return header != NULL ? header->blockSize : 0;
+	}
+	
+	int FeatureFileReader::getFeatureCount() {
+		return header != NULL ? header->featureCount : 0;
+	}
+	
+	int FeatureFileReader::getFrameCount() {
+		return header != NULL ? header->frameCount : 0;
+	}
+	
+	string FeatureFileReader::getFeatureName(int column) {
+		return string(columns[column].name, strnlen(columns[column].name, sizeof(columns[column].name)));
+	}
+	
+	string FeatureFileReader::getFeatureParameters(int column) {
+		return string(columns[column].parameters, strnlen(columns[column].parameters, sizeof(columns[column].parameters)));
+	}
+	
+	FeatureSpan FeatureFileReader::getColumn(int column) {
+		FeatureSpan span;
+		span.values = (const float*) (data + columns[column].offset);
+		span.size = columns[column].frames;
+		return span;
+	}
+	
+	Feature* FeatureFileReader::getFeature(int column) {
+		return features[column];
+	}
+	
+	void FeatureFileReader::addToFeatureSet(FeatureSet* feature_set) {
+		for (int i = 0; i < int(features.size()); i++)
+			feature_set->addFeature(features[i]);
+	}
+}
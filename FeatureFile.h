@@ -0,0 +1,132 @@
+/*
+	Copyright 2009 Arizona State University
+	
+	This file is part of Sirens.
+	
+	Sirens is free software: you can redistribute it and/or modify it under the terms 
+	of the GNU Lesser General Public License as  published by the Free Software 
+	Foundation, either version 3 of the License, or (at your option) any later version.
+	
+	Sirens is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+	without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR 
+	PURPOSE.  See the GNU General Public License for more details.
+	
+	You should have received a copy of the GNU Lesser General Public License along
+	with Sirens. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef __FEATUREFILE_H__
+#define __FEATUREFILE_H__
+
+#include "Feature.h"
+#include "FeatureSet.h"
+
+#include <cstdio>
+#include <stdint.h>
+#include <string>
+#include <vector>
+using namespace std;
+
+/*
+	Binary feature files.
+	
+	A compact format for passing extracted features to segmentation without going through text. All
+	values are in host byte order (files are not meant to move between big- and little-endian machines.)
+	
+		FeatureFileHeader							64 bytes
+		FeatureFileColumn x featureCount			256 bytes each
+		padding to a 64-byte boundary
+		column 0: float32 x frames, padded to a 64-byte boundary
+		column 1: ...
+	
+	Each column holds one feature's values for every frame, so a reader can map the file and hand each
+	column to a Feature (Feature::setExternalHistory) as-is, with no copying or parsing.
+	
+	FeatureFileWriter can be fed a frame (or several) at a time, in any order across features. Columns
+	are spooled to temporary files next to the output until FeatureFileWriter::close assembles the
+	file, so memory use does not grow with the length of the recording.
+*/
+
+namespace Sirens {
+	struct FeatureFileHeader {
+		char magic[8];				// "SIRENSF" and a terminating zero.
+		uint32_t version;
+		uint32_t featureCount;
+		uint64_t frameCount;		// Frames in the longest column.
+		double sampleRate;			// Sample rate of the audio the features were extracted from.
+		uint32_t stepSize;			// Samples between frames.
+		uint32_t blockSize;			// Samples per analysis block.
+		char reserved[24];
+	};
+	
+	struct FeatureFileColumn {
+		char name[64];				// Feature (e.g. plugin output) identifier.
+		char parameters[176];		// Plugin parameters, as "identifier=value" pairs separated by ";".
+		uint64_t offset;			// Start of the column, in bytes from the start of the file.
+		uint64_t frames;			// Number of values in the column.
+	};
+	
+	class FeatureFileWriter {
+	protected:
+		string path;
+		FeatureFileHeader header;
+		vector<FeatureFileColumn> columns;
+		vector<FILE*> spools;
+		
+		string getSpoolPath(int column);
+		
+	public:
+		FeatureFileWriter();
+		~FeatureFileWriter();
+		
+		bool open(string file_path, double sample_rate, int step_size, int block_size);
+		string getPath();
+		
+		// Add a column, returning its index.
+		int addFeature(string name, string parameters = "");
+		
+		// Append values to the end of a column.
+		bool addFrames(int column, const float* values, int count);
+		bool addFrame(int column, float value);
+		
+		// Write the file. Nothing is written to file_path until this is called.
+		bool close();
+	};
+	
+	class FeatureFileReader {
+	protected:
+		const char* data;
+		size_t size;
+		bool mapped;
+		
+		const FeatureFileHeader* header;
+		const FeatureFileColumn* columns;
+		
+		vector<Feature*> features;
+		
+	public:
+		FeatureFileReader();
+		~FeatureFileReader();
+		
+		bool open(string file_path);
+		void close();
+		
+		double getSampleRate();
+		int getStepSize();
+		int getBlockSize();
+		int getFeatureCount();
+		int getFrameCount();
+		
+		string getFeatureName(int column);
+		string getFeatureParameters(int column);
+		FeatureSpan getColumn(int column);
+		
+		// A feature whose history is the mapped column. Features are owned by the reader and valid until it is closed.
+		Feature* getFeature(int column);
+		
+		// Add every column in the file to a feature set.
+		void addToFeatureSet(FeatureSet* feature_set);
+	};
+}
+
+#endif
@@ -0,0 +1,50 @@
+/*
+	Copyright 2009 Arizona State University
+	
+	This file is part of Sirens.
+	
+	Sirens is free software: you can redistribute it and/or modify it under the terms 
+	of the GNU Lesser General Public License as  published by the Free Software 
+	Foundation, either version 3 of the License, or (at your option) any later version.
+	
+	Sirens is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+	without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR 
+	PURPOSE.  See the GNU General Public License for more details.
+	
+	You should have received a copy of the GNU Lesser General Public License along
+	with Sirens. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "FeatureSet.h"
+
+namespace Sirens {
+	FeatureSet::FeatureSet() {
+	}
+	
+	FeatureSet::~FeatureSet() {
+	}
+	
+	void FeatureSet::addFeature(Feature* feature) {
+		features.push_back(feature);
+	}
+	
+	const vector<Feature*>& FeatureSet::getFeatures() {
+		return features;
+	}
+	
+	int FeatureSet::getFeatureCount() {
+		return features.size();
+	}
+	
+	int FeatureSet::getMinHistorySize() {
+		if (features.size() == 0)
+			return 0;
+		
+		int size = features[0]->getHistorySize();
+		
+		for (int i = 1; i < int(features.size()); i++)
+			size = size < features[i]->getHistorySize() ? size : features[i]->getHistorySize();
+		
+		return size;
+	}
+}
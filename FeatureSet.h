@@ -0,0 +1,45 @@
+/*
+	Copyright 2009 Arizona State University
+	
+	This file is part of Sirens.
+	
+	Sirens is free software: you can redistribute it and/or modify it under the terms 
+	of the GNU Lesser General Public License as  published by the Free Software 
+	Foundation, either version 3 of the License, or (at your option) any later version.
+	
+	Sirens is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+	without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR 
+	PURPOSE.  See the GNU General Public License for more details.
+	
+	You should have received a copy of the GNU Lesser General Public License along
+	with Sirens. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef __FEATURESET_H__
+#define __FEATURESET_H__
+
+#include "Feature.h"
+
+#include <vector>
+using namespace std;
+
+namespace Sirens {
+	// The features that are segmented together. Features are not owned by the set.
+	class FeatureSet {
+	protected:
+		vector<Feature*> features;
+		
+	public:
+		FeatureSet();
+		~FeatureSet();
+		
+		void addFeature(Feature* feature);
+		const vector<Feature*>& getFeatures();
+		int getFeatureCount();
+		
+		// Number of frames every feature has, i.e. how many frames can be segmented.
+		int getMinHistorySize();
+	};
+}
+
+#endif
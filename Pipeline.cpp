@@ -0,0 +1,365 @@
+/*
+	Copyright 2009 Arizona State University
+	
+	This file is part of Sirens.
+	
+	Sirens is free software: you can redistribute it and/or modify it under the terms 
+	of the GNU Lesser General Public License as  published by the Free Software 
+	Foundation, either version 3 of the License, or (at your option) any later version.
+	
+	Sirens is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+	without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR 
+	PURPOSE.  See the GNU General Public License for more details.
+	
+	You should have received a copy of the GNU Lesser General Public License along
+	with Sirens. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "Pipeline.h"
+#include "features/Loudness.h"
+#include "features/TemporalSparsity.h"
+#include "features/SpectralSparsity.h"
+#include "features/SpectralCentroid.h"
+#include "features/TransientIndex.h"
+#include "features/Harmonicity.h"
+#include "support/AlignedMemory.h"
+#include "support/Instrumentation.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+using namespace std;
+
+static const double PI = 2 * asin(1.0);
+
+namespace Sirens {
+	Pipeline::Pipeline(float sample_rate, int step_size, int block_size, int hops, int queue_frames) :
+		freeHops(hops), capturedHops(hops), fft(block_size), frames(queue_frames),
+		running(false), extracting(false),
+		capturedHopCount(0), overrunCount(0), droppedSampleCount(0), backpressureCount(0),
+		frameCount(0), segmentationCount(0), totalLatency(0), maximumLatency(0) {
+		sampleRate = sample_rate;
+		stepSize = step_size;
+		blockSize = block_size;
+		segmentWindow = 1000;
+		segmentInterval = 100;
+		
+		plugins[0] = new Loudness(sampleRate);
+		plugins[1] = new TemporalSparsity(sampleRate);
+		plugins[2] = new SpectralSparsity(sampleRate);
+		plugins[3] = new SpectralCentroid(sampleRate);
+		plugins[4] = new TransientIndex(sampleRate);
+		plugins[5] = new Harmonicity(sampleRate);
+		
+		size_t batch_outputs = 1;
+		
+		for (int i = 0; i < FeatureCount; i++) {
+			processors[i] = dynamic_cast<BatchProcessor*>(plugins[i]);
+			batch_outputs = max(batch_outputs, processors[i]->getBatchOutputCount());
+			
+			spectral[i] = plugins[i]->getInputDomain() == Vamp::Plugin::FrequencyDomain;
+			features[i] = new Feature(plugins[i]->getIdentifier());
+			featureSet.addFeature(features[i]);
+		}
+		
+		batchOutput = allocateAligned<float>(batch_outputs);
+		
+		segmenter.setFeatureSet(&featureSet);
+		
+		// Every hop starts out free. The queues hold the whole pool, so handing hops between threads never fails.
+		hopCount = hops;
+		hopMemory = allocateAligned<float>(hopCount * stepSize);
+		currentHop = -1;
+		hopFill = 0;
+		
+		for (int i = 0; i < hopCount; i++)
+			freeHops.push(i);
+		
+		block = allocateAligned<float>(blockSize);
+		windowedBlock = allocateAligned<float>(blockSize);
+		spectrum = allocateAligned<float>(blockSize / 2 + 1);
+		window = allocateAligned<float>(blockSize);
+		
+		for (int i = 0; i < blockSize; i++) {
+			block[i] = 0;
+			window[i] = 0.5 - 0.5 * cos(2 * PI * i / blockSize);
+		}
+		
+		framesExtracted = 0;
+		framesAdded = 0;
+		framesSinceSegmentation = 0;
+	}
+	
+	Pipeline::~Pipeline() {
+		stop();
+		
+		for (int i = 0; i < FeatureCount; i++) {
+			delete plugins[i];
+			delete features[i];
+		}
+		
+		freeAligned(hopMemory);
+		freeAligned(block);
+		freeAligned(windowedBlock);
+		freeAligned(spectrum);
+		freeAligned(window);
+		freeAligned(batchOutput);
+	}
+	
+	/*----------------*
+	 * Configuration. *
+	 *----------------*/
+	
+	Vamp::Plugin* Pipeline::getPlugin(int index) {
+		return plugins[index];
+	}
+	
+	Feature* Pipeline::getFeature(int index) {
+		return features[index];
+	}
+	
+	Segmenter* Pipeline::getSegmenter() {
+		return &segmenter;
+	}
+	
+	void Pipeline::setListener(Listener value) {
+		listener = value;
+	}
+	
+	void Pipeline::setSegmentWindow(int frames) {
+		segmentWindow = frames > 1 ? frames : 1;
+	}
+	
+	void Pipeline::setSegmentInterval(int frames) {
+		segmentInterval = frames > 1 ? frames : 1;
+	}
+	
+	/*------------*
+	 * Threading. *
+	 *------------*/
+	
+	bool Pipeline::start() {
+		if (running || stepSize < 1 || stepSize > blockSize || !FFT::isPowerOfTwo(blockSize))
+			return false;
+		
+		// Spectral plugins take the magnitudes of bins 0 to blockSize / 2.
+		for (int i = 0; i < FeatureCount; i++) {
+			if (!plugins[i]->initialise(1, stepSize, spectral[i] ? blockSize / 2 + 1 : blockSize))
+				return false;
+		}
+		
+		windowHistory.assign(FeatureCount, vector<float>(2 * segmentWindow, 0));
+		framesExtracted = 0;
+		framesAdded = 0;
+		framesSinceSegmentation = 0;
+		
+		running = true;
+		extracting = true;
+		
+		featureThread = thread(&Pipeline::runFeatures, this);
+		segmenterThread = thread(&Pipeline::runSegmenter, this);
+		
+		return true;
+	}
+	
+	void Pipeline::stop() {
+		if (!running)
+			return;
+		
+		running.store(false, memory_order_release);
+		
+		featureThread.join();
+		segmenterThread.join();
+	}
+	
+	long long Pipeline::getTime() {
+		return chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now().time_since_epoch()).count();
+	}
+	
+	// Back off while a queue is empty (or full): yield at first, then sleep, so an idle stage costs next to nothing.
+	void Pipeline::wait(int& idle) {
+		if (idle < 64)
+			this_thread::yield();
+		else
+			this_thread::sleep_for(chrono::microseconds(100));
+		
+		idle ++;
+	}
+	
+	/*----------*
+	 * Capture. *
+	 *----------*/
+	
+	bool Pipeline::pushSamples(const float* samples, int count) {
+		while (count > 0) {
+			if (currentHop < 0) {
+				if (!freeHops.pop(currentHop)) {
+					currentHop = -1;
+					overrunCount.fetch_add(1, memory_order_relaxed);
+					droppedSampleCount.fetch_add(count, memory_order_relaxed);
+					return false;
+				}
+				
+				hopFill = 0;
+			}
+			
+			int length = count < stepSize - hopFill ? count : stepSize - hopFill;
+			memcpy(hopMemory + currentHop * stepSize + hopFill, samples, length * sizeof(float));
+			
+			hopFill += length;
+			samples += length;
+			count -= length;
+			
+			if (hopFill == stepSize) {
+				CapturedHop hop;
+				hop.index = currentHop;
+				hop.captureTime = getTime();
+				
+				capturedHops.push(hop);
+				capturedHopCount.fetch_add(1, memory_order_relaxed);
+				currentHop = -1;
+			}
+		}
+		
+		return true;
+	}
+	
+	/*-----------*
+	 * Features. *
+	 *-----------*/
+	
+	void Pipeline::runFeatures() {
+		int idle = 0;
+		
+		while (true) {
+			// Read before popping, so that every hop queued before stop() is seen.
+			bool stopping = !running.load(memory_order_acquire);
+			CapturedHop hop;
+			
+			if (capturedHops.pop(hop)) {
+				idle = 0;
+				
+				// Slide the new hop into the block, and give the hop straight back to the capture thread.
+				memmove(block, block + stepSize, (blockSize - stepSize) * sizeof(float));
+				memcpy(block + blockSize - stepSize, hopMemory + hop.index * stepSize, stepSize * sizeof(float));
+				freeHops.push(hop.index);
+				
+				FeatureFrame frame;
+				frame.captureTime = hop.captureTime;
+				extractFeatures(frame);
+				
+				while (!frames.push(frame)) {
+					backpressureCount.fetch_add(1, memory_order_relaxed);
+					wait(idle);
+				}
+				
+				idle = 0;
+			} else if (stopping)
+				break;
+			else
+				wait(idle);
+		}
+		
+		extracting.store(false, memory_order_release);
+	}
+	
+	void Pipeline::extractFeatures(FeatureFrame& frame) {
+		SIRENS_TIME_SCOPE("Pipeline::extractFeatures", blockSize * sizeof(float));
+		
+		for (int i = 0; i < blockSize; i++)
+			windowedBlock[i] = block[i] * window[i];
+		
+		fft.magnitudes(windowedBlock, spectrum);
+		
+		for (int i = 0; i < FeatureCount; i++) {
+			processors[i]->processBatch(spectral[i] ? spectrum : block, 1, batchOutput);
+			frame.values[i] = batchOutput[0];
+		}
+		
+		framesExtracted ++;
+	}
+	
+	/*---------------*
+	 * Segmentation. *
+	 *---------------*/
+	
+	void Pipeline::runSegmenter() {
+		int idle = 0;
+		
+		while (true) {
+			bool stopping = !extracting.load(memory_order_acquire);
+			FeatureFrame frame;
+			
+			if (frames.pop(frame)) {
+				idle = 0;
+				
+				long long latency = getTime() - frame.captureTime;
+				long long maximum = maximumLatency.load(memory_order_relaxed);
+				
+				totalLatency.fetch_add(latency, memory_order_relaxed);
+				
+				while (latency > maximum && !maximumLatency.compare_exchange_weak(maximum, latency, memory_order_relaxed));
+				
+				addFrame(frame);
+				frameCount.fetch_add(1, memory_order_relaxed);
+				
+				if (framesSinceSegmentation >= segmentInterval)
+					segmentWindowFrames();
+			} else if (stopping)
+				break;
+			else
+				wait(idle);
+		}
+		
+		if (framesSinceSegmentation > 0)
+			segmentWindowFrames();
+	}
+	
+	// Frame k is stored at k % segmentWindow and again segmentWindow after that, so the last segmentWindow frames are
+	// always contiguous, starting at (frames - segmentWindow) % segmentWindow.
+	void Pipeline::addFrame(const FeatureFrame& frame) {
+		int position = framesAdded % segmentWindow;
+		
+		for (int i = 0; i < FeatureCount; i++) {
+			windowHistory[i][position] = frame.values[i];
+			windowHistory[i][position + segmentWindow] = frame.values[i];
+		}
+		
+		framesAdded ++;
+		framesSinceSegmentation ++;
+	}
+	
+	void Pipeline::segmentWindowFrames() {
+		SIRENS_TIME_SCOPE("Pipeline::segmentWindowFrames", 0);
+		
+		int length = framesAdded < segmentWindow ? framesAdded : segmentWindow;
+		long long first_frame = framesAdded - length;
+		int start = first_frame % segmentWindow;
+		
+		for (int i = 0; i < FeatureCount; i++) {
+			features[i]->clearHistory();
+			features[i]->addHistoryFrames(&windowHistory[i][start], length);
+		}
+		
+		segmenter.segment();
+		segmentationCount.fetch_add(1, memory_order_relaxed);
+		framesSinceSegmentation = 0;
+		
+		if (listener)
+			listener(&segmenter, first_frame);
+	}
+	
+	PipelineStatistics Pipeline::getStatistics() {
+		PipelineStatistics statistics;
+		statistics.capturedHops = capturedHopCount;
+		statistics.overruns = overrunCount;
+		statistics.droppedSamples = droppedSampleCount;
+		statistics.backpressureWaits = backpressureCount;
+		statistics.frames = frameCount;
+		statistics.segmentations = segmentationCount;
+		statistics.averageLatency = statistics.frames > 0 ? totalLatency / double(statistics.frames) / 1e9 : 0;
+		statistics.maximumLatency = maximumLatency / 1e9;
+		return statistics;
+	}
+}
@@ -0,0 +1,175 @@
+/*
+	Copyright 2009 Arizona State University
+	
+	This file is part of Sirens.
+	
+	Sirens is free software: you can redistribute it and/or modify it under the terms 
+	of the GNU Lesser General Public License as  published by the Free Software 
+	Foundation, either version 3 of the License, or (at your option) any later version.
+	
+	Sirens is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+	without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR 
+	PURPOSE.  See the GNU General Public License for more details.
+	
+	You should have received a copy of the GNU Lesser General Public License along
+	with Sirens. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef __PIPELINE_H__
+#define __PIPELINE_H__
+
+#include "Feature.h"
+#include "FeatureSet.h"
+#include "segmentation/Segmenter.h"
+#include "support/BatchProcessor.h"
+#include "support/SpscQueue.h"
+#include "support/FFT.h"
+
+#include <vamp-sdk/Plugin.h>
+
+#include <atomic>
+#include <functional>
+#include <thread>
+#include <vector>
+using namespace std;
+
+/*
+	Live analysis: audio capture, feature extraction, and segmentation, each on its own thread.
+	
+	The capture thread (typically an audio callback) hands samples to pushSamples(), which copies them into hops of
+	one step from a preallocated pool and queues them; it never locks, allocates, or waits. If no hop is free because
+	the later stages have fallen behind, the samples are dropped and counted as an overrun.
+	
+	The feature thread slides the hops into a block, takes its spectrum, and runs the six Sirens features on it
+	(Loudness, TemporalSparsity, SpectralSparsity, SpectralCentroid, TransientIndex, Harmonicity), queueing one frame
+	of feature values per step. The plugins are called through their batch entry points (see BatchProcessor), which
+	write the values straight into the frame rather than building a FeatureSet for every block. When the segmenter falls behind and that queue is full, the feature thread waits
+	(counted as backpressure), which in turn holds hops back from the capture thread.
+	
+	The segmenter thread collects frames and, every segmentInterval frames, segments the last segmentWindow frames
+	and calls the listener with the Segmenter. The Segmenter works on whole sequences rather than frame by frame, so
+	segmentation is of a sliding window; the Segmenter reuses its buffers between runs (see Segmenter::reset.)
+	
+	Stages are connected by SpscQueues, so there are no locks anywhere between capture and segmentation. Plugins,
+	features' segmentation parameters, and the segmenter can be configured before start().
+	
+	The Pipeline is for hosts, not part of the plugin: "make host" builds it into a static library with the code it
+	uses (see the Makefile.)
+*/
+
+namespace Sirens {
+	struct PipelineStatistics {
+		unsigned long long capturedHops;		// Hops queued by the capture thread.
+		unsigned long long overruns;			// Calls to pushSamples that had to drop samples.
+		unsigned long long droppedSamples;		// Samples dropped by overruns.
+		unsigned long long backpressureWaits;	// Times the feature thread found the frame queue full.
+		unsigned long long frames;				// Frames of features extracted.
+		unsigned long long segmentations;		// Times the window was segmented.
+		double averageLatency;					// Seconds from a hop being queued to its frame reaching the segmenter.
+		double maximumLatency;
+	};
+	
+	class Pipeline {
+	public:
+		static const int FeatureCount = 6;
+		
+		typedef function<void(Segmenter* segmenter, long long first_frame)> Listener;
+		
+	private:
+		struct CapturedHop {
+			int index;
+			long long captureTime;
+		};
+		
+		struct FeatureFrame {
+			float values[FeatureCount];
+			long long captureTime;
+		};
+		
+		float sampleRate;
+		int stepSize;
+		int blockSize;
+		int segmentWindow;
+		int segmentInterval;
+		
+		// Stage bodies.
+		Vamp::Plugin* plugins[FeatureCount];
+		BatchProcessor* processors[FeatureCount];	// The same plugins.
+		Feature* features[FeatureCount];
+		FeatureSet featureSet;
+		Segmenter segmenter;
+		Listener listener;
+		
+		// Capture: a pool of hops, the one being filled, and the queues to and from the feature thread.
+		float* hopMemory;
+		int hopCount;
+		int currentHop;
+		int hopFill;
+		SpscQueue<int> freeHops;
+		SpscQueue<CapturedHop> capturedHops;
+		
+		// Features: the block being analyzed and its spectrum.
+		float* block;
+		float* windowedBlock;
+		float* spectrum;
+		float* window;
+		bool spectral[FeatureCount];		// Whether each plugin takes the spectrum rather than the block.
+		float* batchOutput;					// Every value of one plugin for one block; the first is the feature's.
+		FFT fft;
+		SpscQueue<FeatureFrame> frames;
+		long long framesExtracted;
+		
+		// Segmentation: the last segmentWindow frames of each feature, stored twice over so that they are always
+		// contiguous (see addFrame.)
+		vector<vector<float> > windowHistory;
+		long long framesAdded;
+		int framesSinceSegmentation;
+		
+		thread featureThread;
+		thread segmenterThread;
+		atomic<bool> running;		// Cleared by stop(): the feature thread finishes the queued hops and exits.
+		atomic<bool> extracting;	// Cleared by the feature thread as it exits: the segmenter thread then does the same.
+		
+		atomic<unsigned long long> capturedHopCount, overrunCount, droppedSampleCount, backpressureCount;
+		atomic<unsigned long long> frameCount, segmentationCount;
+		atomic<long long> totalLatency, maximumLatency;
+		
+		static long long getTime();
+		static void wait(int& idle);
+		
+		void runFeatures();
+		void runSegmenter();
+		void extractFeatures(FeatureFrame& frame);
+		void addFrame(const FeatureFrame& frame);
+		void segmentWindowFrames();
+		
+	public:
+		// blockSize must be a power of two, and no smaller than stepSize. hops is the size of the capture pool, and
+		// queueFrames the number of frames that can wait for the segmenter.
+		Pipeline(float sample_rate, int step_size = 512, int block_size = 1024, int hops = 64, int queue_frames = 1024);
+		~Pipeline();
+		
+		Pipeline(const Pipeline&) = delete;
+		Pipeline& operator=(const Pipeline&) = delete;
+		
+		// Configuration, before start().
+		Vamp::Plugin* getPlugin(int index);
+		Feature* getFeature(int index);
+		Segmenter* getSegmenter();
+		void setListener(Listener value);
+		void setSegmentWindow(int frames);
+		void setSegmentInterval(int frames);
+		
+		bool start();
+		
+		// Let the queued samples through every stage, then stop the threads.
+		void stop();
+		
+		// Capture thread only. Returns false if some of the samples had to be dropped.
+		bool pushSamples(const float* samples, int count);
+		
+		PipelineStatistics getStatistics();
+	};
+}
+
+#endif
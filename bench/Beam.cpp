@@ -0,0 +1,112 @@
+#include "SyntheticInput.h"
+
+#include "../Feature.h"
+#include "../FeatureSet.h"
+#include "../segmentation/Segmenter.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+using namespace std;
+using namespace Sirens;
+
+/*
+	Speed and accuracy of Segmenter's beam search (see Segmenter.h) on synthetic feature columns (see SyntheticInput.)
+
+	For 5 and 6 features, the columns are segmented exactly, and then with each beam width. Reported per width are the
+	speedup over exact segmentation, the average number of live states, the fraction of frames whose global mode
+	differs from the exact result (Segmenter::getModeDisagreement), the precision and recall of its segment boundaries
+	within BoundaryTolerance frames of exact ones, and how much higher its path cost is.
+
+	Usage: beam [frames] [widths...]
+*/
+
+static const int DefaultFrames = 3000;
+static const int DefaultWidths[] = { 4, 8, 16, 32, 64, 128, 256 };
+static const int FeatureCounts[] = { 5, 6 };
+static const int BoundaryTolerance = 3;
+static const unsigned int Seed = 1;
+
+static double getSeconds(chrono::steady_clock::time_point start) {
+	return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+static void setParameters(SegmentationParameters* parameters) {
+	parameters->setMinFeatureValue(0);
+	parameters->setMaxFeatureValue(1);
+	parameters->setPLagPlus(0.1);
+	parameters->setPLagMinus(0.1);
+	parameters->setAlpha(0.15);
+	parameters->setR(0.0005);
+	parameters->setCStayOff(0.0001);
+	parameters->setCStayOn(0.0001);
+	parameters->setCTurnOn(0.1);
+	parameters->setCTurningOn(0.1);
+	parameters->setCTurnOff(0.1);
+	parameters->setCNewSegment(0.1);
+}
+
+int main(int argc, char** argv) {
+	int frames = argc > 1 ? atoi(argv[1]) : DefaultFrames;
+	vector<int> widths;
+
+	for (int i = 2; i < argc; i++)
+		widths.push_back(atoi(argv[i]));
+
+	if (widths.empty())
+		widths.assign(DefaultWidths, DefaultWidths + sizeof(DefaultWidths) / sizeof(DefaultWidths[0]));
+
+	if (frames <= 0) {
+		fprintf(stderr, "usage: %s [frames] [widths...]\n", argv[0]);
+		return 2;
+	}
+
+	for (size_t c = 0; c < sizeof(FeatureCounts) / sizeof(FeatureCounts[0]); c++) {
+		int feature_count = FeatureCounts[c];
+		vector<float> values;
+		makeSyntheticFeatures(frames, feature_count, Seed, values);
+
+		vector<Feature*> features;
+		FeatureSet feature_set;
+
+		for (int f = 0; f < feature_count; f++) {
+			features.push_back(new Feature("", frames));
+			features[f]->addHistoryFrames(&values[(size_t) f * frames], frames);
+			setParameters(features[f]->getSegmentationParameters());
+			feature_set.addFeature(features[f]);
+		}
+
+		Segmenter segmenter(0.01, 0.01);
+		segmenter.setFeatureSet(&feature_set);
+
+		chrono::steady_clock::time_point start = chrono::steady_clock::now();
+		segmenter.segment();
+		double exact_time = getSeconds(start);
+
+		vector<int> exact_modes = segmenter.getModes();
+		double exact_cost = segmenter.getPathCost();
+
+		printf("%d features, %d frames: exact %.3f s\n", feature_count, frames, exact_time);
+		printf("%8s%10s%10s%12s%11s%9s%12s\n", "width", "speedup", "live", "disagree", "precision", "recall", "cost");
+
+		for (size_t w = 0; w < widths.size(); w++) {
+			segmenter.setBeamWidth(widths[w]);
+
+			start = chrono::steady_clock::now();
+			segmenter.segment();
+			double time = getSeconds(start);
+
+			const vector<int>& modes = segmenter.getModes();
+			BoundaryAgreement agreement = Segmenter::compareBoundaries(exact_modes, modes, BoundaryTolerance);
+
+			printf("%8d%9.1fx%10.1f%11.2f%%%11.3f%9.3f%+12.1f\n", widths[w], exact_time / time, segmenter.getAverageLiveStates(),
+				100 * Segmenter::getModeDisagreement(exact_modes, modes), agreement.getPrecision(), agreement.getRecall(),
+				segmenter.getPathCost() - exact_cost);
+		}
+
+		for (int f = 0; f < feature_count; f++)
+			delete features[f];
+	}
+
+	return 0;
+}
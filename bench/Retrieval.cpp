@@ -0,0 +1,184 @@
+#include "SyntheticInput.h"
+
+#include "../retrieval/SegmentDescriptor.h"
+#include "../retrieval/SoundIndex.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+using namespace std;
+using namespace Sirens;
+
+/*
+	Check and benchmark of SoundIndex on a synthetic corpus (see SyntheticInput.)
+
+	The index is built over the corpus and queried with held-out descriptors from the same distribution, once on one
+	thread and once on several (one per hardware thread unless given), as build() and batch queries split their work
+	with runParallel. Every result is checked against a brute-force scan of the whole corpus, with the same
+	normalization: the k distances must agree rank by rank, so the index finds exactly the k nearest neighbours up to
+	ties. The run fails (exit status 1) if any query does not.
+
+	Reported are the build time, the time per query for the index and for the scan, and the fraction of the corpus
+	the index compares a query with.
+
+	Usage: retrieval [descriptors] [queries] [k] [threads]
+*/
+
+static const int DefaultDescriptors = 20000;
+static const int DefaultQueries = 500;
+static const int DefaultK = 10;
+static const int Features = 6;				// Descriptors as for a feature set of this many features.
+static const int Modes = 100;				// Clusters in the synthetic corpus.
+static const unsigned int Seed = 1;
+static const float Tolerance = 1e-4;		// Relative tolerance on distances.
+
+static double getSeconds(chrono::steady_clock::time_point start) {
+	return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+// Normalize every dimension to zero mean and unit variance over the corpus, as SoundIndex::build does.
+static void normalize(const vector<float>& corpus, int size, int dimensions, vector<float>& normalized) {
+	normalized.resize(corpus.size());
+
+	for (int i = 0; i < dimensions; i++) {
+		double sum = 0;
+		double sum_of_squares = 0;
+
+		for (int j = 0; j < size; j++) {
+			sum += corpus[j * dimensions + i];
+			sum_of_squares += corpus[j * dimensions + i] * corpus[j * dimensions + i];
+		}
+
+		double mean = sum / size;
+		double variance = sum_of_squares / size - mean * mean;
+		float offset = mean;
+		float scale = variance > 1e-12 ? 1 / sqrt(variance) : 1;
+
+		for (int j = 0; j < int(corpus.size() / dimensions); j++)
+			normalized[j * dimensions + i] = (corpus[j * dimensions + i] - offset) * scale;
+	}
+}
+
+// The k nearest of the first size normalized descriptors to each query, by comparing with every one of them.
+static void scan(const vector<float>& normalized, int size, int dimensions, int queries, int k, vector<vector<SoundMatch> >& matches) {
+	vector<SoundMatch> all(size);
+	matches.resize(queries);
+
+	for (int q = 0; q < queries; q++) {
+		const float* query = &normalized[(size_t) (size + q) * dimensions];
+
+		for (int j = 0; j < size; j++) {
+			const float* descriptor = &normalized[(size_t) j * dimensions];
+			float sum = 0;
+
+			for (int i = 0; i < dimensions; i++) {
+				float difference = query[i] - descriptor[i];
+				sum += difference * difference;
+			}
+
+			all[j].id = j;
+			all[j].distance = sum;
+		}
+
+		int found = min(k, size);
+		partial_sort(all.begin(), all.begin() + found, all.end(), [](const SoundMatch& a, const SoundMatch& b) {
+			return a.distance < b.distance;
+		});
+
+		matches[q].assign(all.begin(), all.begin() + found);
+
+		for (int i = 0; i < found; i++)
+			matches[q][i].distance = sqrt(matches[q][i].distance);
+	}
+}
+
+// Number of queries whose matches do not agree with the scan's.
+static int countMismatches(const vector<vector<SoundMatch> >& matches, const vector<vector<SoundMatch> >& expected) {
+	int mismatches = 0;
+
+	for (int q = 0; q < int(expected.size()); q++) {
+		bool same = matches[q].size() == expected[q].size();
+
+		// Ids can differ only between matches at the same distance.
+		for (int i = 0; same && i < int(expected[q].size()); i++)
+			same = fabs(matches[q][i].distance - expected[q][i].distance) <= Tolerance * max(1.0f, expected[q][i].distance);
+
+		if (!same)
+			mismatches++;
+	}
+
+	return mismatches;
+}
+
+int main(int argc, char** argv) {
+	int size = argc > 1 ? atoi(argv[1]) : DefaultDescriptors;
+	int queries = argc > 2 ? atoi(argv[2]) : DefaultQueries;
+	int k = argc > 3 ? atoi(argv[3]) : DefaultK;
+	int threads = argc > 4 ? atoi(argv[4]) : int(thread::hardware_concurrency());
+	int dimensions = SegmentDescriptor::getDimensions(Features);
+
+	if (size <= 0 || queries <= 0 || k <= 0) {
+		fprintf(stderr, "usage: %s [descriptors] [queries] [k] [threads]\n", argv[0]);
+		return 2;
+	}
+
+	// The corpus, followed by the queries.
+	vector<float> descriptors;
+	makeSyntheticDescriptors(size + queries, dimensions, Modes, Seed, descriptors);
+
+	vector<float> normalized;
+	normalize(descriptors, size, dimensions, normalized);
+
+	vector<vector<SoundMatch> > expected;
+	chrono::steady_clock::time_point start = chrono::steady_clock::now();
+	scan(normalized, size, dimensions, queries, k, expected);
+	double scan_time = getSeconds(start);
+
+	printf("%d descriptors of %d dimensions, %d queries, k = %d\n", size, dimensions, queries, k);
+	printf("scan: %.1f us/query\n", scan_time * 1e6 / queries);
+
+	const float* query_descriptors = &descriptors[(size_t) size * dimensions];
+	int thread_counts[2] = { 1, threads };
+	int runs = threads > 1 ? 2 : 1;
+	bool success = true;
+
+	for (int run = 0; run < runs; run++) {
+		SoundIndex index(dimensions);
+		index.setThreadCount(thread_counts[run]);
+
+		for (int j = 0; j < size; j++)
+			index.addDescriptor(&descriptors[(size_t) j * dimensions]);
+
+		start = chrono::steady_clock::now();
+		index.build();
+		double build_time = getSeconds(start);
+
+		vector<vector<SoundMatch> > matches;
+		start = chrono::steady_clock::now();
+		index.query(query_descriptors, queries, k, matches);
+		double query_time = getSeconds(start);
+
+		// Comparisons, from single queries.
+		long long comparisons = 0;
+		vector<SoundMatch> single;
+
+		for (int q = 0; q < queries; q++)
+			comparisons += index.query(query_descriptors + (size_t) q * dimensions, k, single);
+
+		int mismatches = countMismatches(matches, expected);
+
+		printf("%2d threads: %d clusters, build %.1f ms, query %.1f us/query (x%.1f over the scan on one thread), %.1f%% compared\n",
+			thread_counts[run], index.getClusterCount(), build_time * 1e3, query_time * 1e6 / queries, scan_time / query_time,
+			100.0 * comparisons / ((double) queries * size));
+
+		if (mismatches > 0) {
+			printf("  FAILED: %d queries differ from the scan\n", mismatches);
+			success = false;
+		}
+	}
+
+	return success ? 0 : 1;
+}
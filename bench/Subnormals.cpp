@@ -0,0 +1,177 @@
+#include "SyntheticInput.h"
+
+#include "../features/Loudness.h"
+#include "../features/TemporalSparsity.h"
+#include "../features/SpectralSparsity.h"
+#include "../features/SpectralCentroid.h"
+#include "../features/TransientIndex.h"
+#include "../features/Harmonicity.h"
+#include "../features/SpectralShape.h"
+#include "../features/HarmonicityDecimated.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+using namespace std;
+
+/*
+	Regression guard for the plugins' handling of quiet input (see support/Denormals.h.)
+
+	Every plugin is run through process(), as a host would, on each SyntheticInput signal, and the best time of a few
+	passes is reported per block. The run fails (exit status 1) if:
+	- subnormal input gives different outputs from silence (under DenormalGuard subnormals read as zero),
+	- subnormal or decaying input is more than SlowdownLimit times slower than ordinary input (unflushed subnormals
+	  cost 10-100x),
+	- silence is not faster than ordinary input for the plugins that skip all-zero blocks,
+	- or the host's floating-point mode is not the same after process() as before.
+
+	Usage: subnormals [blocks per pass]
+*/
+
+static const float SampleRate = 44100;
+static const size_t DefaultBlockSize = 1024;
+static const unsigned int DefaultBlocks = 1000;
+static const int Passes = 5;
+static const double SlowdownLimit = 2.0;
+
+struct PluginCase {
+	Vamp::Plugin* (*create)(float sample_rate);
+	bool skipsZeroBlocks;		// Whether the plugin returns precomputed outputs for all-zero blocks.
+};
+
+template <class P> static Vamp::Plugin* createPlugin(float sample_rate) {
+	return new P(sample_rate);
+}
+
+static const PluginCase Cases[] = {
+	{ createPlugin<Loudness>, false },
+	{ createPlugin<TemporalSparsity>, false },
+	{ createPlugin<SpectralSparsity>, false },
+	{ createPlugin<SpectralCentroid>, false },
+	{ createPlugin<TransientIndex>, true },
+	{ createPlugin<Harmonicity>, true },
+	{ createPlugin<SpectralShape>, false },
+	{ createPlugin<HarmonicityDecimated>, true }
+};
+
+// Whether the calling thread flushes subnormal results to zero.
+static bool isFlushing() {
+	volatile float tiny = 1e-38f;
+	return tiny * 0.5f == 0;
+}
+
+// Outputs are the same if every value is, with NaN equal to NaN.
+static bool isSameOutput(const vector<float>& a, const vector<float>& b) {
+	if (a.size() != b.size())
+		return false;
+
+	for (size_t i = 0; i < a.size(); i++) {
+		if (a[i] != b[i] && !(isnan(a[i]) && isnan(b[i])))
+			return false;
+	}
+
+	return true;
+}
+
+// Best time per block of Passes passes over the blocks, in nanoseconds. outputs gets every value of the last pass.
+static double runPlugin(Vamp::Plugin* plugin, size_t block_size, const vector<float>& blocks, unsigned int count, vector<float>& outputs, bool& mode_kept) {
+	double best = 0;
+
+	for (int pass = 0; pass < Passes; pass++) {
+		plugin->reset();
+		outputs.clear();
+
+		bool flushing = isFlushing();
+		chrono::steady_clock::time_point start = chrono::steady_clock::now();
+
+		for (unsigned int block = 0; block < count; block++) {
+			const float* input[1] = { &blocks[block * block_size] };
+			Vamp::Plugin::FeatureSet features = plugin->process(input, Vamp::RealTime::frame2RealTime(long(block) * block_size, (unsigned int) SampleRate));
+
+			for (Vamp::Plugin::FeatureSet::iterator output = features.begin(); output != features.end(); output++) {
+				for (size_t f = 0; f < output->second.size(); f++)
+					outputs.insert(outputs.end(), output->second[f].values.begin(), output->second[f].values.end());
+			}
+		}
+
+		double elapsed = chrono::duration<double>(chrono::steady_clock::now() - start).count() * 1e9 / count;
+
+		if (isFlushing() != flushing)
+			mode_kept = false;
+
+		if (pass == 0 || elapsed < best)
+			best = elapsed;
+	}
+
+	return best;
+}
+
+int main(int argc, char** argv) {
+	unsigned int count = argc > 1 ? atoi(argv[1]) : DefaultBlocks;
+	bool success = true;
+
+	if (count == 0) {
+		fprintf(stderr, "usage: %s [blocks per pass]\n", argv[0]);
+		return 2;
+	}
+
+	printf("%-24s", "ns/block");
+
+	for (int s = 0; s < SyntheticSignalCount; s++)
+		printf("%12s", getSyntheticSignalName(SyntheticSignal(s)));
+
+	printf("\n");
+
+	for (size_t c = 0; c < sizeof(Cases) / sizeof(Cases[0]); c++) {
+		Vamp::Plugin* plugin = Cases[c].create(SampleRate);
+		size_t block_size = plugin->getPreferredBlockSize() != 0 ? plugin->getPreferredBlockSize() : DefaultBlockSize;
+		bool frequency_domain = plugin->getInputDomain() == Vamp::Plugin::FrequencyDomain;
+
+		if (!plugin->initialise(1, block_size, block_size)) {
+			printf("%-24s could not be initialized\n", plugin->getIdentifier().c_str());
+			success = false;
+			delete plugin;
+			continue;
+		}
+
+		double times[SyntheticSignalCount];
+		vector<float> outputs[SyntheticSignalCount];
+		bool mode_kept = true;
+
+		for (int s = 0; s < SyntheticSignalCount; s++) {
+			vector<float> blocks;
+			makeSyntheticBlocks(SyntheticSignal(s), frequency_domain, block_size, count, SampleRate, c + 1, blocks);
+			times[s] = runPlugin(plugin, block_size, blocks, count, outputs[s], mode_kept);
+		}
+
+		printf("%-24s", plugin->getIdentifier().c_str());
+
+		for (int s = 0; s < SyntheticSignalCount; s++)
+			printf("%12.1f", times[s]);
+
+		printf("\n");
+
+		const char* failure = NULL;
+
+		if (!mode_kept)
+			failure = "process() changed the host's floating-point mode";
+		else if (!isSameOutput(outputs[SyntheticSubnormal], outputs[SyntheticSilence]))
+			failure = "subnormal input gives different outputs from silence";
+		else if (times[SyntheticSubnormal] > SlowdownLimit * times[SyntheticTones])
+			failure = "subnormal input is slow";
+		else if (times[SyntheticDecay] > SlowdownLimit * times[SyntheticTones])
+			failure = "decaying input is slow";
+		else if (Cases[c].skipsZeroBlocks && times[SyntheticSilence] >= times[SyntheticTones])
+			failure = "all-zero blocks are not skipped";
+
+		if (failure != NULL) {
+			printf("  FAILED: %s\n", failure);
+			success = false;
+		}
+
+		delete plugin;
+	}
+
+	return success ? 0 : 1;
+}
@@ -0,0 +1,147 @@
+#include "SyntheticInput.h"
+
+#include "../Feature.h"
+#include "../FeatureSet.h"
+#include "../segmentation/Segmenter.h"
+#include "../segmentation/SegmenterSweep.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+using namespace std;
+using namespace Sirens;
+
+/*
+	Speed and accuracy of SegmenterSweep (see SegmenterSweep.h) on synthetic feature columns (see SyntheticInput.)
+
+	For 1 to 4 features and each number of configurations, the configurations (a small grid over alpha, r, pLagPlus
+	and cStayOn) are segmented one at a time with a Segmenter, then swept exactly, then swept in fast mode. Reported are
+	the speedups of both sweeps over the Segmenter loop, whether the exact sweep's modes and path costs all match the
+	loop's, and for fast mode the average fraction of frames whose global mode differs from the loop's
+	(Segmenter::getModeDisagreement) and the largest relative difference in path cost.
+
+	Usage: sweep [frames] [configuration counts...]
+*/
+
+static const int DefaultFrames = 2000;
+static const int DefaultCounts[] = { 1, 2, 4, 6, 8, 16, 32 };
+static const int MaxFeatures = 4;
+static const unsigned int Seed = 1;
+
+static double getSeconds(chrono::steady_clock::time_point start) {
+	return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+static void setParameters(SegmentationParameters* parameters, int configuration) {
+	parameters->setMinFeatureValue(0);
+	parameters->setMaxFeatureValue(1);
+	parameters->setPLagPlus(0.05 + 0.05 * (configuration % 4));
+	parameters->setPLagMinus(0.1);
+	parameters->setAlpha(0.1 + 0.02 * (configuration % 5));
+	parameters->setR(0.0002 * (1 + configuration % 7));
+	parameters->setCStayOff(0.0001);
+	parameters->setCStayOn(0.0001 * (1 + configuration % 2));
+	parameters->setCTurnOn(0.1);
+	parameters->setCTurningOn(0.1);
+	parameters->setCTurnOff(0.1);
+	parameters->setCNewSegment(0.1);
+}
+
+int main(int argc, char** argv) {
+	int frames = argc > 1 ? atoi(argv[1]) : DefaultFrames;
+	vector<int> counts;
+
+	for (int i = 2; i < argc; i++)
+		counts.push_back(atoi(argv[i]));
+
+	if (counts.empty())
+		counts.assign(DefaultCounts, DefaultCounts + sizeof(DefaultCounts) / sizeof(DefaultCounts[0]));
+
+	if (frames <= 0) {
+		fprintf(stderr, "usage: %s [frames] [configuration counts...]\n", argv[0]);
+		return 2;
+	}
+
+	for (int feature_count = 1; feature_count <= MaxFeatures; feature_count++) {
+		vector<float> values;
+		makeSyntheticFeatures(frames, feature_count, Seed, values);
+
+		vector<Feature*> features;
+		FeatureSet feature_set;
+
+		for (int f = 0; f < feature_count; f++) {
+			features.push_back(new Feature("", frames));
+			features[f]->addHistoryFrames(&values[(size_t) f * frames], frames);
+			feature_set.addFeature(features[f]);
+		}
+
+		Segmenter segmenter(0.01, 0.01);
+		SegmenterSweep sweep(0.01, 0.01);
+
+		segmenter.setFeatureSet(&feature_set);
+		sweep.setFeatureSet(&feature_set);
+
+		printf("%d features, %d frames\n", feature_count, frames);
+		printf("%8s%12s%10s%11s%8s%12s%12s\n", "configs", "loop (s)", "exact", "identical", "fast", "disagree", "cost");
+
+		for (size_t c = 0; c < counts.size(); c++) {
+			int count = counts[c];
+			vector<vector<SegmentationParameters> > configurations(count, vector<SegmentationParameters>(feature_count));
+
+			for (int i = 0; i < count; i++) {
+				for (int f = 0; f < feature_count; f++)
+					setParameters(&configurations[i][f], i);
+			}
+
+			// The Segmenter loop.
+			vector<vector<int> > loop_modes(count);
+			vector<double> loop_costs(count);
+
+			chrono::steady_clock::time_point start = chrono::steady_clock::now();
+
+			for (int i = 0; i < count; i++) {
+				for (int f = 0; f < feature_count; f++)
+					*features[f]->getSegmentationParameters() = configurations[i][f];
+
+				segmenter.segment();
+				loop_modes[i] = segmenter.getModes();
+				loop_costs[i] = segmenter.getPathCost();
+			}
+
+			double loop_time = getSeconds(start);
+
+			sweep.setFastMath(false);
+			start = chrono::steady_clock::now();
+			sweep.sweep(configurations);
+			double exact_time = getSeconds(start);
+
+			bool identical = true;
+
+			for (int i = 0; i < count; i++)
+				identical = identical && sweep.getModes(i) == loop_modes[i] && sweep.getPathCost(i) == loop_costs[i];
+
+			sweep.setFastMath(true);
+			start = chrono::steady_clock::now();
+			sweep.sweep(configurations);
+			double fast_time = getSeconds(start);
+
+			double disagreement = 0;
+			double cost_difference = 0;
+
+			for (int i = 0; i < count; i++) {
+				disagreement += Segmenter::getModeDisagreement(loop_modes[i], sweep.getModes(i)) / count;
+				cost_difference = max(cost_difference, fabs(sweep.getPathCost(i) - loop_costs[i]) / fabs(loop_costs[i]));
+			}
+
+			printf("%8d%12.3f%9.2fx%11s%7.2fx%11.2f%%%12.1e\n", count, loop_time, loop_time / exact_time, identical ? "yes" : "no",
+				loop_time / fast_time, 100 * disagreement, cost_difference);
+		}
+
+		for (int f = 0; f < feature_count; f++)
+			delete features[f];
+	}
+
+	return 0;
+}
@@ -0,0 +1,151 @@
+#include "SyntheticInput.h"
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+using namespace std;
+
+static const int ToneBlocks = 20;			// Blocks between changes of the tones.
+static const int Harmonics = 5;
+static const float SubnormalLimit = 1.17e-38f;	// Largest subnormal float, about.
+static const int OutlierRate = 100;				// One descriptor in OutlierRate is an outlier.
+static const float CenterRange = 10;			// Cluster centers are uniform in [-CenterRange, CenterRange].
+static const int MinEventFrames = 20;			// Sound events and the gaps between them last this many frames or more...
+static const int MaxEventFrames = 200;			// ...and fewer than this many.
+static const float FeatureNoise = 0.02f;
+
+const char* getSyntheticSignalName(SyntheticSignal signal) {
+	switch (signal) {
+		case SyntheticTones: return "tones";
+		case SyntheticSilence: return "silence";
+		case SyntheticSubnormal: return "subnormal";
+		case SyntheticDecay: return "decay";
+		default: return "";
+	}
+}
+
+// Block of the tones signal: harmonics of f0 (every third tone is silent), plus noise.
+static void makeToneBlock(bool frequency_domain, size_t block_size, unsigned int block, float sample_rate, mt19937& generator, float* values) {
+	uniform_real_distribution<float> noise(-0.5, 0.5);
+	int tone = block / ToneBlocks;
+	double f0 = 110.0 * (1 + tone % 7);
+	double level = tone % 3 == 0 ? 0.0 : 1.0;
+
+	for (size_t i = 0; i < block_size; i++) {
+		if (frequency_domain) {
+			double hz = sample_rate * i / (2.0 * block_size);
+			double magnitude = 0.05 + 0.02 * noise(generator);
+
+			for (int h = 1; h <= Harmonics; h++)
+				magnitude += 40 * level / h * exp(-pow((hz - h * f0) / 15.0, 2));
+
+			values[i] = magnitude;
+		} else {
+			double t = double(block * block_size + i) / sample_rate;
+			double sample = 0;
+
+			for (int h = 1; h <= Harmonics; h++)
+				sample += 0.5 * level / h * sin(2 * M_PI * h * f0 * t);
+
+			values[i] = sample + 0.01 * noise(generator);
+		}
+	}
+}
+
+void makeSyntheticBlocks(SyntheticSignal signal, bool frequency_domain, size_t block_size, unsigned int count, float sample_rate, unsigned int seed, vector<float>& blocks) {
+	mt19937 generator(seed);
+	uniform_real_distribution<float> uniform(0, 1);
+
+	blocks.assign(count * block_size + 2, 0);
+
+	for (unsigned int block = 0; block < count; block++) {
+		float* values = &blocks[block * block_size];
+
+		if (signal == SyntheticSilence)
+			continue;
+		else if (signal == SyntheticSubnormal) {
+			// Every value is a nonzero subnormal.
+			for (size_t i = 0; i < block_size; i++)
+				values[i] = SubnormalLimit * (0.01f + 0.98f * uniform(generator));
+		} else {
+			makeToneBlock(frequency_domain, block_size, block, sample_rate, generator, values);
+
+			// From 1e-30 at the first block to 1e-46 (below the smallest subnormal) at the last.
+			if (signal == SyntheticDecay) {
+				float gain = pow(10.0, -30 - 16.0 * block / max(count - 1, 1u));
+
+				for (size_t i = 0; i < block_size; i++)
+					values[i] *= gain;
+			}
+		}
+	}
+}
+
+void makeSyntheticDescriptors(unsigned int count, int dimensions, int modes, unsigned int seed, vector<float>& descriptors) {
+	mt19937 generator(seed);
+	uniform_real_distribution<float> uniform(-CenterRange, CenterRange);
+	uniform_real_distribution<float> spread(0.2f, 2.0f);
+	normal_distribution<float> normal(0, 1);
+
+	// Cluster centers and spreads come first, so they do not depend on count.
+	vector<float> centers(modes * dimensions);
+	vector<float> spreads(modes);
+
+	for (int m = 0; m < modes; m++) {
+		for (int i = 0; i < dimensions; i++)
+			centers[m * dimensions + i] = uniform(generator);
+
+		spreads[m] = spread(generator);
+	}
+
+	descriptors.resize((size_t) count * dimensions);
+
+	for (unsigned int d = 0; d < count; d++) {
+		float* descriptor = &descriptors[(size_t) d * dimensions];
+
+		if (generator() % OutlierRate == 0) {
+			for (int i = 0; i < dimensions; i++)
+				descriptor[i] = uniform(generator);
+		} else {
+			int m = generator() % modes;
+
+			for (int i = 0; i < dimensions; i++)
+				descriptor[i] = centers[m * dimensions + i] + spreads[m] * normal(generator);
+		}
+	}
+}
+
+void makeSyntheticFeatures(unsigned int frames, int features, unsigned int seed, vector<float>& values) {
+	mt19937 generator(seed);
+	uniform_int_distribution<int> duration(MinEventFrames, MaxEventFrames - 1);
+	uniform_real_distribution<float> level(0.4f, 0.9f);
+	uniform_real_distribution<float> drift(-0.002f, 0.002f);
+	normal_distribution<float> noise(0, FeatureNoise);
+	
+	values.assign((size_t) frames * features, 0);
+	
+	vector<float> levels(features);
+	vector<float> drifts(features);
+	bool on = false;
+	unsigned int end = 0;
+	
+	for (unsigned int t = 0; t < frames; t++) {
+		// Alternate between events and gaps.
+		if (t == end) {
+			on = !on;
+			end = min(t + duration(generator), frames);
+			
+			for (int f = 0; f < features; f++) {
+				levels[f] = on ? level(generator) : 0.05f;
+				drifts[f] = on ? drift(generator) : 0;
+			}
+		}
+		
+		for (int f = 0; f < features; f++) {
+			float value = levels[f] + noise(generator);
+			
+			values[(size_t) f * frames + t] = min(max(value, 0.0f), 1.0f);
+			levels[f] += drifts[f];
+		}
+	}
+}
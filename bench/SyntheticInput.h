@@ -0,0 +1,48 @@
+#ifndef _SYNTHETICINPUT_H
+#define _SYNTHETICINPUT_H
+
+#include <cstddef>
+#include <vector>
+using namespace std;
+
+/*
+	Generated inputs for the benchmarks, so they need no audio files or sound collections.
+
+	Of the plugin inputs, Tones is ordinary audio: a few harmonic tones that change every few blocks over a little
+	noise. Silence is exact zeros. Subnormal is noise whose every value is a positive subnormal float (below about
+	1.2e-38), and Decay is the Tones signal fading from 1e-30 down through the subnormal range to zero over the blocks,
+	as the tail of a quiet passage does.
+
+	Time-domain blocks hold samples. Frequency-domain blocks hold one magnitude per bin, as the Sirens plugins read them.
+	Blocks are stored one after another, each blockSize values (the layout processBatch takes), with 2 values of padding
+	at the end so the last block can also be handed to process() as a Vamp frequency-domain buffer. The same seed gives
+	the same blocks.
+*/
+enum SyntheticSignal {
+	SyntheticTones,
+	SyntheticSilence,
+	SyntheticSubnormal,
+	SyntheticDecay,
+	SyntheticSignalCount
+};
+
+const char* getSyntheticSignalName(SyntheticSignal signal);
+
+void makeSyntheticBlocks(SyntheticSignal signal, bool frequency_domain, size_t block_size, unsigned int count, float sample_rate, unsigned int seed, vector<float>& blocks);
+
+/*
+	Segment descriptors for SoundIndex are drawn from a mixture of modes Gaussian clusters with random centers and
+	spreads (sounds of one kind have similar descriptors), and one in a hundred is drawn uniformly over the centers'
+	range instead, as an outlier. count descriptors of dimensions values are stored one after another. With the same
+	seed, a longer call only adds descriptors at the end, so the extra ones can be held out as queries.
+*/
+void makeSyntheticDescriptors(unsigned int count, int dimensions, int modes, unsigned int seed, vector<float>& descriptors);
+
+/*
+	Feature columns for the Segmenter: frames values in [0, 1] for each of features features, one feature after another.
+	They follow sound events shared by all features, each giving every feature its own level and drift, separated by
+	near-silence, with a little noise on top, so there are clear segment boundaries to find.
+*/
+void makeSyntheticFeatures(unsigned int frames, int features, unsigned int seed, vector<float>& values);
+
+#endif
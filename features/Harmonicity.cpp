@@ -1,10 +1,28 @@
 #include "Harmonicity.h"
+#include "../support/Instrumentation.h"
+#include "../support/Kernels.h"
+#include "../support/FastMath.h"
+#include "../support/Denormals.h"
 
+#include <algorithm>
 #include <cmath>
 using namespace std;
 
 static const double PI = 2 * asin(1.0);
 
+// Modified Bessel function of the first kind, order zero, for the Kaiser window.
+static double getBesselI0(double x) {
+	double sum = 1;
+	double term = 1;
+	
+	for (int k = 1; term > 1e-12 * sum; k++) {
+		term *= (x / (2 * k)) * (x / (2 * k));
+		sum += term;
+	}
+	
+	return sum;
+}
+
 Harmonicity::Harmonicity(float inputSampleRate) : Plugin(inputSampleRate), m_blockSize(0) {
 	m_sampleRate = inputSampleRate;
 	
@@ -13,11 +31,31 @@ Harmonicity::Harmonicity(float inputSampleRate) : Plugin(inputSampleRate), m_blo
 	threshold = 0.1;
 	lpfCoefficient = 0.7;
 	maxPeaks = 3;
+	settings.replace(absThreshold, threshold, searchRegionLength, maxPeaks, lpfCoefficient);
+	
+	decimated = false;
+	decimationFactor = 1;
+	analysisRate = m_sampleRate;
+	
+	fft = NULL;
+	decimationFilter = NULL;
+	decimationTaps = NULL;
+	decimationStages = 0;
+	decimationPadding = 0;
+	decimationBuffers[0] = NULL;
+	decimationBuffers[1] = NULL;
+	decimatedBlock = NULL;
+	analysisWindow = NULL;
+	spectrum = NULL;
 	
 	rawIndices.values = NULL;
 	rawMagnitudes.values = NULL;
 	accIndices.values = NULL;
 	peakList.values = NULL;
+	
+	hypothesisFrequencies = NULL;
+	hypothesisConstants = NULL;
+	hypothesisExponents = NULL;
 }
 
 Harmonicity::~Harmonicity() {
@@ -41,7 +79,7 @@ string Harmonicity::getMaker() const {
 }
 
 int Harmonicity::getPluginVersion() const {
-	return 1;
+	return 2;
 }
 
 string Harmonicity::getCopyright() const {
@@ -126,6 +164,29 @@ Harmonicity::ParameterList Harmonicity::getParameterDescriptors() const {
 	lpfCoefficientParameter.isQuantized = false;
 	list.push_back(lpfCoefficientParameter);
 	
+	ParameterDescriptor silenceGateParameter;
+	silenceGateParameter.identifier = "silence-gate";
+	silenceGateParameter.name = "Silence gate";
+	silenceGateParameter.description = "Skip the analysis of blocks quieter than the silence threshold.";
+	silenceGateParameter.unit = "";
+	silenceGateParameter.minValue = 0;
+	silenceGateParameter.maxValue = 1;
+	silenceGateParameter.defaultValue = 0;
+	silenceGateParameter.quantizeStep = 1;
+	silenceGateParameter.isQuantized = true;
+	list.push_back(silenceGateParameter);
+	
+	ParameterDescriptor silenceThresholdParameter;
+	silenceThresholdParameter.identifier = "silence-threshold";
+	silenceThresholdParameter.name = "Silence threshold";
+	silenceThresholdParameter.description = "Level, on the scale of the Loudness output, below which the silence gate skips a block.";
+	silenceThresholdParameter.unit = "dB";
+	silenceThresholdParameter.minValue = -200;
+	silenceThresholdParameter.maxValue = 0;
+	silenceThresholdParameter.defaultValue = -120;
+	silenceThresholdParameter.isQuantized = false;
+	list.push_back(silenceThresholdParameter);
+	
 	return list;
 }
 
@@ -140,21 +201,42 @@ float Harmonicity::getParameter(string identifier) const {
 		return float(maxPeaks);
 	else if (identifier == "lpf-coefficient")
 		return lpfCoefficient;
+	else if (identifier == "silence-gate")
+		return gate.isEnabled() ? 1 : 0;
+	else if (identifier == "silence-threshold")
+		return gate.getThreshold();
 	else
 		return 0;
 }
 
 void Harmonicity::setParameter(string identifier, float value)	{
-	if (identifier == "abs-threshold")
+	if (identifier == "abs-threshold") {
 		absThreshold = value;
-	else if (identifier == "threshold")
+		publishSettings();
+	} else if (identifier == "threshold") {
 		threshold = value;
-	else if (identifier == "search-region-length")
+		publishSettings();
+	} else if (identifier == "search-region-length") {
 		searchRegionLength = int(value);
-	else if (identifier == "max-peaks")
+		publishSettings();
+	} else if (identifier == "max-peaks") {
 		maxPeaks = int(value);
-	else if (identifier == "lpf-coefficient")
+		publishSettings();
+	} else if (identifier == "lpf-coefficient") {
 		lpfCoefficient = value;
+		publishSettings();
+	} else if (identifier == "silence-gate")
+		gate.setEnabled(value >= 0.5);
+	else if (identifier == "silence-threshold")
+		gate.setThreshold(value);
+}
+
+void Harmonicity::publishSettings() {
+	settings.publish(absThreshold, threshold, searchRegionLength, maxPeaks, lpfCoefficient);
+}
+
+Harmonicity::Settings::Settings(float absThreshold, float threshold, unsigned int searchRegionLength, unsigned int maxPeaks, float lpfCoefficient) : absThreshold(absThreshold), threshold(threshold), lpfCoefficient(lpfCoefficient), maxPeaks(maxPeaks) {
+	searchRegionLength2 = (searchRegionLength - 1) / 2;
 }
 
 Harmonicity::OutputList Harmonicity::getOutputDescriptors() const {
@@ -186,14 +268,33 @@ Harmonicity::OutputList Harmonicity::getOutputDescriptors() const {
 	pitchOutput.hasDuration = false;
 	list.push_back(pitchOutput);
 	
+	OutputDescriptor skipRateOutput;
+	skipRateOutput.identifier = "skip-rate";
+	skipRateOutput.name = "Skip rate";
+	skipRateOutput.description = "fraction of blocks skipped by the silence gate, given at the end when the gate is enabled.";
+	skipRateOutput.unit = "";
+	skipRateOutput.hasFixedBinCount = true;
+	skipRateOutput.binCount = 1;
+	skipRateOutput.hasKnownExtents = true;
+	skipRateOutput.minValue = 0;
+	skipRateOutput.maxValue = 1;
+	skipRateOutput.isQuantized = false;
+	skipRateOutput.sampleType = OutputDescriptor::VariableSampleRate;
+	skipRateOutput.sampleRate = 0;
+	skipRateOutput.hasDuration = false;
+	list.push_back(skipRateOutput);
+	
 	return list;
 }
 
 bool Harmonicity::initialise(size_t channels, size_t stepSize, size_t blockSize) {
 	if (channels < getMinChannelCount() || channels > getMaxChannelCount())
 		return false;
+	else if (decimated && !FFT::isPowerOfTwo(blockSize))
+		return false;
 	else {
 		m_blockSize = blockSize;
+		energy.initialize(stepSize, blockSize);
 		
 		resetVectors();
 		return true;
@@ -201,28 +302,24 @@ bool Harmonicity::initialise(size_t channels, size_t stepSize, size_t blockSize)
 }
 
 void Harmonicity::reset() {
+	gate.reset();
+	energy.reset();
 	resetVectors();
 }
 
 Harmonicity::FeatureSet Harmonicity::process(const float *const *inputBuffers, Vamp::RealTime timestamp) {
-	pickPeaks(inputBuffers);
+	SIRENS_TIME_SCOPE("Harmonicity::process", 0);
 	
-	pitch = 0;
-	
-	if (peakList.size == 1) {
-		pitch = peakList.values[0].frequency;
-	} else if (peakList.size != 0)
-		goldsteinCalc();
-	
-	peakList.size = 0;
+	float values[2];
+	processBatch(inputBuffers[0], 1, values);
 	
 	Feature harmonicityFeature;
 	harmonicityFeature.hasTimestamp = false;
-	harmonicityFeature.values.push_back(harmonicity);
+	harmonicityFeature.values.push_back(values[0]);
 	
 	Feature pitchFeature;
 	pitchFeature.hasTimestamp = false;
-	pitchFeature.values.push_back(pitch);
+	pitchFeature.values.push_back(values[1]);
 	
 	FeatureSet fs;
 	fs[0].push_back(harmonicityFeature);
@@ -232,7 +329,76 @@ Harmonicity::FeatureSet Harmonicity::process(const float *const *inputBuffers, V
 }
 
 Harmonicity::FeatureSet Harmonicity::getRemainingFeatures() {
-	return FeatureSet();
+	FeatureSet fs;
+	
+	if (gate.isEnabled()) {
+		Feature skipRateFeature;
+		skipRateFeature.hasTimestamp = true;
+		skipRateFeature.timestamp = Vamp::RealTime();
+		skipRateFeature.values.push_back(gate.getSkipRate());
+		fs[2].push_back(skipRateFeature);
+	}
+	
+	return fs;
+}
+
+size_t Harmonicity::getBatchOutputCount() const {
+	return 2;
+}
+
+void Harmonicity::processBatch(const float* blocks, unsigned int count, float* output) {
+	DenormalGuard guard;
+	
+	const Settings& current = *settings.update();
+	
+	for (unsigned int frame = 0; frame < count; frame++) {
+		const float* block = blocks + frame * m_blockSize;
+		bool silent = false;
+		
+		// The energy of overlapping time-domain blocks is kept up to date even while the gate is off, so that it is
+		// right from the first block after the gate is enabled.
+		double mean_square = decimated ? energy.addBlock(block) / double(m_blockSize) : 0;
+		
+		if (gate.isEnabled()) {
+			if (!decimated)
+				mean_square = SilenceGate::getSpectrumMeanSquare(block, m_blockSize);
+			
+			silent = gate.isSilent(mean_square);
+		}
+		
+		if (silent) {
+			SIRENS_COUNT("Harmonicity::gatedBlocks", 1);
+			
+			// A gated block is not analysed: harmonicity is zero and the pitch is carried over.
+			harmonicity = 0;
+		} else if (isZeroBlock(block, m_blockSize)) {
+			// An all-zero block has no peaks: the pitch is zero and harmonicity keeps its last value, as it would if
+			// the block were analysed.
+			pitch = 0;
+		} else {
+			if (decimated) {
+				decimate(block);
+				
+				const float* spectrum_buffers[1] = {spectrum};
+				pickPeaks(spectrum_buffers, current);
+			} else {
+				const float* block_buffers[1] = {block};
+				pickPeaks(block_buffers, current);
+			}
+			
+			pitch = 0;
+			
+			if (peakList.size == 1) {
+				pitch = peakList.values[0].frequency;
+			} else if (peakList.size != 0)
+				goldsteinCalc();
+			
+			peakList.size = 0;
+		}
+		
+		output[2 * frame] = harmonicity;
+		output[2 * frame + 1] = pitch;
+	}
 }
 
 void Harmonicity::freeMemory() {
@@ -247,6 +413,37 @@ void Harmonicity::freeMemory() {
 	
 	if (peakList.values)
 		delete [] peakList.values;
+	
+	delete [] hypothesisFrequencies;
+	delete [] hypothesisConstants;
+	delete [] hypothesisExponents;
+	
+	delete fft;
+	delete [] decimationFilter;
+	delete [] decimationTaps;
+	delete [] decimationBuffers[0];
+	delete [] decimationBuffers[1];
+	delete [] decimatedBlock;
+	delete [] analysisWindow;
+	delete [] spectrum;
+	
+	rawIndices.values = NULL;
+	rawMagnitudes.values = NULL;
+	accIndices.values = NULL;
+	peakList.values = NULL;
+	
+	hypothesisFrequencies = NULL;
+	hypothesisConstants = NULL;
+	hypothesisExponents = NULL;
+	
+	fft = NULL;
+	decimationFilter = NULL;
+	decimationTaps = NULL;
+	decimationBuffers[0] = NULL;
+	decimationBuffers[1] = NULL;
+	decimatedBlock = NULL;
+	analysisWindow = NULL;
+	spectrum = NULL;
 }
 
 void Harmonicity::resetVectors() {
@@ -255,19 +452,23 @@ void Harmonicity::resetVectors() {
 	pitch = 0;
 	harmonicity = 0;
 	
-	float min_hz = m_sampleRate >= 180 ? 90.0 : 0;
-	float max_hz = m_sampleRate >= 7000 ? 3500.0 : m_sampleRate / 2;
+	if (decimated)
+		resetDecimation();
+	else {
+		decimationFactor = 1;
+		analysisRate = m_sampleRate;
+		fftSize = (m_blockSize - 1) * 2;
+	}
 	
-	fftSize = (m_blockSize - 1) * 2;
+	float min_hz = analysisRate >= 180 ? 90.0 : 0;
+	float max_hz = analysisRate >= 2 * MaxPeakFrequency ? float(MaxPeakFrequency) : analysisRate / 2;
 	
-	minFrequencyIndex = int(ceil(min_hz * float(fftSize) / m_sampleRate));
-	maxFrequencyIndex = int(ceil(max_hz * float(fftSize) / m_sampleRate));
+	minFrequencyIndex = int(ceil(min_hz * float(fftSize) / analysisRate));
+	maxFrequencyIndex = int(ceil(max_hz * float(fftSize) / analysisRate));
 	
 	int vector_size = maxFrequencyIndex - minFrequencyIndex;
 	
 	// Parameters.
-	searchRegionLength2 = (searchRegionLength - 1) / 2;
-	
 	nMax = 10;
 	filterOldValue = 0;
 	kVar = 0.01 / sqrt(2.0);
@@ -282,28 +483,135 @@ void Harmonicity::resetVectors() {
 	rawMagnitudes.values = new double[vector_size];
 	accIndices.values = new int[vector_size];
 	peakList.values = new Peak[vector_size];
+	
+	// Harmonic number pairs (n1 < n2 <= nMax) tried for each pair of peaks.
+	unsigned int hypotheses = nMax * (nMax - 1) / 2;
+	
+	hypothesisFrequencies = new float[hypotheses];
+	hypothesisConstants = new float[hypotheses];
+	hypothesisExponents = new float[hypotheses];
 }
 
-void Harmonicity::pickPeaks(const float *const *inputBuffers) {
-	// Search through all bins, chopping off the beginning and end, so we can slide a searchRegionLength window across the spectrum.
-	for (unsigned int k = minFrequencyIndex + searchRegionLength2; k < maxFrequencyIndex - searchRegionLength2; k++) {
-		// Find the maximum amplitude in the search region surrounding the current frequency.
-		float maxel = 0;
+// Choose a decimation factor that brings the sample rate down to no less than 8kHz (keeping 90-3500Hz well inside the
+// band), and build the anti-aliasing filters, analysis window, and FFT for the decimated block.
+void Harmonicity::resetDecimation() {
+	decimationFactor = 1;
+	decimationStages = 0;
+	
+	while (m_sampleRate / (decimationFactor * 2) >= MinAnalysisRate && m_blockSize / (decimationFactor * 2) >= 64) {
+		decimationFactor *= 2;
+		decimationStages++;
+	}
+	
+	analysisRate = m_sampleRate / decimationFactor;
+	fftSize = m_blockSize / decimationFactor;
+	
+	// A stage with input rate rate only has to remove what would alias into the band searched for peaks: frequencies
+	// above rate / 2 - MaxPeakFrequency. What it lets through between MaxPeakFrequency and there lands above
+	// MaxPeakFrequency, where the next stage treats it the same way. The transition band, MaxPeakFrequency to
+	// rate / 2 - MaxPeakFrequency, is centered on rate / 4 as a halfband filter's is, and is widest in the first stages,
+	// so they need the fewest taps. Lengths follow from Kaiser's formula for DecimationAttenuation.
+	double beta = 0.1102 * (DecimationAttenuation - 8.7);
+	unsigned int total_taps = 0;
+	
+	decimationTaps = new unsigned int[decimationStages];
+	decimationPadding = 0;
+	
+	for (unsigned int stage = 0; stage < decimationStages; stage++) {
+		double rate = m_sampleRate / double(1 << stage);
+		double transition = (rate / 2 - 2.0 * MaxPeakFrequency) / rate;
+		double order = (DecimationAttenuation - 7.95) / (14.36 * transition);
 		
-		for (unsigned int i = k - searchRegionLength2; i <= k + searchRegionLength2; i++) {
-			if (maxel < inputBuffers[0][i])
-				maxel = inputBuffers[0][i];
-		}
+		decimationTaps[stage] = (unsigned int) ceil(order / 4 + 0.5);
+		decimationPadding = max(decimationPadding, 2 * decimationTaps[stage] - 1);
+		total_taps += decimationTaps[stage];
+	}
+	
+	decimationFilter = new float[total_taps];
+	float* taps = decimationFilter;
+	
+	for (unsigned int stage = 0; stage < decimationStages; stage++) {
+		unsigned int count = decimationTaps[stage];
+		double half_length = 2 * count - 1;
+		double sum = 0;
 		
-		// Save the bin with the maximum amplitude in the search region.
-		if (inputBuffers[0][k] >= maxel) {
-			rawIndices.values[rawIndices.size] = k;
-			rawIndices.size ++;
-			rawMagnitudes.values[rawMagnitudes.size] = inputBuffers[0][k];
-			rawMagnitudes.size ++;
+		// Ideal halfband lowpass sin(pi * k / 2) / (pi * k), Kaiser windowed, at odd offsets k...
+		for (unsigned int tap = 0; tap < count; tap++) {
+			double k = 2 * tap + 1;
+			double window = getBesselI0(beta * sqrt(1 - (k / half_length) * (k / half_length))) / getBesselI0(beta);
+			
+			taps[tap] = (tap % 2 == 0 ? 1 : -1) / (PI * k) * window;
+			sum += taps[tap];
 		}
+		
+		// ...scaled for unity gain at DC: the center tap is 1/2, and the others add up to 1/2.
+		for (unsigned int tap = 0; tap < count; tap++)
+			taps[tap] *= 0.25 / sum;
+		
+		taps += count;
 	}
 	
+	decimationBuffers[0] = new float[m_blockSize + 2 * decimationPadding]();
+	decimationBuffers[1] = new float[m_blockSize + 2 * decimationPadding]();
+	
+	// Hann window, as a host would apply to a frequency-domain plugin's input. The FFT covers decimationFactor times
+	// fewer samples, so the window also scales magnitudes back up by that much to keep them comparable with a full-band
+	// spectrum (and absThreshold meaningful.)
+	analysisWindow = new float[fftSize];
+	
+	for (unsigned int i = 0; i < fftSize; i++)
+		analysisWindow[i] = decimationFactor * (0.5 - 0.5 * cos(2 * PI * i / fftSize));
+	
+	decimatedBlock = new float[fftSize];
+	spectrum = new float[fftSize / 2 + 1];
+	fft = new FFT(fftSize);
+}
+
+// Lowpass filter and decimate the input block, one halfband stage at a time, then take its magnitude spectrum. Samples
+// beyond the block are zero.
+void Harmonicity::decimate(const float* input) {
+	unsigned int length = m_blockSize;
+	const float* taps = decimationFilter;
+	float* source = decimationBuffers[0] + decimationPadding;
+	
+	copy(input, input + length, source);
+	
+	for (unsigned int stage = 0; stage < decimationStages; stage++) {
+		float* target = decimationBuffers[(stage + 1) % 2] + decimationPadding;
+		unsigned int count = decimationTaps[stage];
+		
+		length /= 2;
+		
+		// Only the samples that are kept are computed, from the center tap and the symmetric pairs of odd ones.
+		getKernels().decimateHalfband(source, taps, count, target, length);
+		
+		// Past the end, the target buffer still holds a longer block from an earlier stage.
+		fill(target + length, target + length + decimationPadding, 0.0f);
+		
+		taps += count;
+		source = target;
+	}
+	
+	for (unsigned int i = 0; i < fftSize; i++)
+		decimatedBlock[i] = source[i] * analysisWindow[i];
+	
+	fft->magnitudes(decimatedBlock, spectrum);
+}
+
+void Harmonicity::pickPeaks(const float *const *inputBuffers, const Settings& current) {
+	SIRENS_TIME_SCOPE("Harmonicity::pickPeaks", (maxFrequencyIndex - minFrequencyIndex) * sizeof(float));
+	
+	const unsigned int searchRegionLength2 = current.searchRegionLength2;
+	const unsigned int maxPeaks = current.maxPeaks;
+	
+	// Search through all bins, chopping off the beginning and end, so we can slide a searchRegionLength window across
+	// the spectrum, and save the bins that have the maximum amplitude in their search region.
+	rawIndices.size = getKernels().findPeaks(inputBuffers[0], minFrequencyIndex + searchRegionLength2, maxFrequencyIndex - searchRegionLength2, searchRegionLength2, rawIndices.values);
+	rawMagnitudes.size = rawIndices.size;
+	
+	for (unsigned int k = 0; k < rawIndices.size; k++)
+		rawMagnitudes.values[k] = inputBuffers[0][rawIndices.values[k]];
+	
 	// Find the maximum amplitude from the spectrum.
 	float max_peak_mag = 0;
 	
@@ -315,7 +623,7 @@ void Harmonicity::pickPeaks(const float *const *inputBuffers) {
 	// Accept only frequency bins where the amplitudes threshold is greater than the absolute threshold 
 	// and threshold relative to the maximum amplitude.
 	for (unsigned int k = 0; k < rawIndices.size; k++) {
-		if ((inputBuffers[0][rawIndices.values[k]] > threshold * max_peak_mag) && (inputBuffers[0][rawIndices.values[k]] > absThreshold)) {
+		if ((inputBuffers[0][rawIndices.values[k]] > current.threshold * max_peak_mag) && (inputBuffers[0][rawIndices.values[k]] > current.absThreshold)) {
 			accIndices.values[accIndices.size] = rawIndices.values[k];
 			accIndices.size ++;
 		}
@@ -326,17 +634,17 @@ void Harmonicity::pickPeaks(const float *const *inputBuffers) {
 		int ind = accIndices.values[k];
 		
 		// Get surrounding amplitudes.
-		float y1 = log(inputBuffers[0][ind - 1]);
-		float y2 = log(inputBuffers[0][ind]);
-		float y3 = log(inputBuffers[0][ind + 1]);
+		float y1 = fastLog(inputBuffers[0][ind - 1]);
+		float y2 = fastLog(inputBuffers[0][ind]);
+		float y3 = fastLog(inputBuffers[0][ind + 1]);
 		
 		float denom = (2 * (y1 - 2 * y2 + y3));
 		float freq_bin_zero = denom > 0 ? (y1 - y3) / denom : 0;
 		
 		float f = (freq_bin_zero > 0) ? (y1 - y2) / (1 + 2 * freq_bin_zero) : (y3 - y2) / (1 - 2 * freq_bin_zero);
 
-		tempPeak.amplitude = exp(y2 - f * freq_bin_zero * freq_bin_zero);
-		tempPeak.frequency = m_sampleRate * float(freq_bin_zero + ind) / float(fftSize);
+		tempPeak.amplitude = fastExp(y2 - f * freq_bin_zero * freq_bin_zero);
+		tempPeak.frequency = analysisRate * float(freq_bin_zero + ind) / float(fftSize);
 		
 		peakList.values[peakList.size] = tempPeak;
 		peakList.size ++;
@@ -358,8 +666,9 @@ void Harmonicity::pickPeaks(const float *const *inputBuffers) {
 }
 
 	
-// Evaluates a Gaussian distribution modeling the probability that a given peak is a harmonic of f0.
-float Harmonicity::goldsteinGaussian(float x1, float x2, int n1, int n2, float f0, float k) {
+// Evaluates a Gaussian distribution modeling the probability that a given peak is a harmonic of f0, as
+// constant * exp(exponent). goldsteinCalc takes the exps of all the hypotheses for a pair of peaks at once.
+void Harmonicity::goldsteinGaussian(float x1, float x2, int n1, int n2, float f0, float k, float& constant, float& exponent) {
 	// mu = f0 * N, where N = [n1, n2]
 	float mu1 = f0 * n1;
 	float mu2 = f0 * n2;
@@ -376,20 +685,18 @@ float Harmonicity::goldsteinGaussian(float x1, float x2, int n1, int n2, float f
 	float x_minus_mu2 = x2 - mu2;
 	
 	// constant term = 1 / (2PI ^ D/2 * sqrt(det(sigma))
-	float constant = 1.0 / (2.0 * PI * sigma_component1 * sigma_component2);
+	constant = 1.0 / (2.0 * PI * sigma_component1 * sigma_component2);
 	
 	// P(f0) = constant * exp(-1/2 * (x - mu)' * inv(sigma) * (x - mu)
-	float p_f0 = constant * exp(
-		-0.5 * (
-			(sigma_inverse1 * (x_minus_mu1 * x_minus_mu1)) + 
-			(sigma_inverse2 * (x_minus_mu2 * x_minus_mu2))
-		)
+	exponent = -0.5 * (
+		(sigma_inverse1 * (x_minus_mu1 * x_minus_mu1)) + 
+		(sigma_inverse2 * (x_minus_mu2 * x_minus_mu2))
 	);
-	
-	return p_f0;
 }
 
 void Harmonicity::goldsteinCalc() {
+	SIRENS_TIME_SCOPE("Harmonicity::goldsteinCalc", 0);
+	
 	unsigned int p1, p2, n1, n2;
 	float p0, f0, f1, f2, f1_rat, f2_rat, p_temp, f_temp;
 	
@@ -401,17 +708,28 @@ void Harmonicity::goldsteinCalc() {
 			f1 = peakList.values[p1].frequency;
 			f2 = peakList.values[p2].frequency;
 			
+			unsigned int hypotheses = 0;
+			
 			for (n1 = 0; n1 < nMax - 1; n1++) {
 				for (n2 = n1 + 1; n2 < nMax; n2++) {
 					f1_rat = f1 / (n1 + 1.0);
 					f2_rat = f2 / (n2 + 1.0);
 					f_temp = ((f1_rat * f1_rat) + (f2_rat * f2_rat)) / (f1_rat + f2_rat);
-					p_temp = goldsteinGaussian(f1, f2, n1 + 1, n2 + 1, f_temp, kVar);
 					
-					if ((p_temp > p0)) {
-						f0 = f_temp;
-						p0 = p_temp;
-					}
+					hypothesisFrequencies[hypotheses] = f_temp;
+					goldsteinGaussian(f1, f2, n1 + 1, n2 + 1, f_temp, kVar, hypothesisConstants[hypotheses], hypothesisExponents[hypotheses]);
+					hypotheses ++;
+				}
+			}
+			
+			getKernels().exponential(hypothesisExponents, hypothesisExponents, hypotheses);
+			
+			for (unsigned int h = 0; h < hypotheses; h++) {
+				p_temp = hypothesisConstants[h] * hypothesisExponents[h];
+				
+				if ((p_temp > p0)) {
+					f0 = hypothesisFrequencies[h];
+					p0 = p_temp;
 				}
 			}
 		}
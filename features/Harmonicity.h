@@ -4,6 +4,12 @@
 #include <vamp-sdk/Plugin.h>
 using std::string;
 
+#include "../support/BatchProcessor.h"
+#include "../support/FFT.h"
+#include "../support/BlockEnergy.h"
+#include "../support/SilenceGate.h"
+#include "../support/RealtimeConfiguration.h"
+
 struct Peak {
 	double amplitude;
 	double frequency;
@@ -24,7 +30,7 @@ struct HarmonicityPeakVector {
 	unsigned int size;
 };
 
-class Harmonicity : public Vamp::Plugin {
+class Harmonicity : public Vamp::Plugin, public BatchProcessor {
 public:
 	Harmonicity(float inputSampleRate);
 	virtual ~Harmonicity();
@@ -55,13 +61,59 @@ public:
 	
 	FeatureSet getRemainingFeatures();
 	
+	// The harmonicity and pitch of each block (see BatchProcessor.)
+	size_t getBatchOutputCount() const;
+	void processBatch(const float* blocks, unsigned int count, float* output);
+	
 protected:
 	size_t m_blockSize;
 	float m_sampleRate;
 	
-	float absThreshold, threshold, kVar;
-	float fftMax, pitch, filterOldValue, lpfCoefficient, harmonicity;
-	unsigned int maxPeaks, nMax, fftSize, searchRegionLength, searchRegionLength2;
+	// Decimated analysis (see HarmonicityDecimated): the input is time-domain audio, which is lowpass filtered and
+	// decimated before a smaller FFT. analysisRate is the sample rate of the spectrum that peaks are picked from.
+	bool decimated;
+	unsigned int decimationFactor;
+	float analysisRate;
+	
+	FFT* fft;
+	// The decimation is a cascade of halfband lowpass filters, each halving the sample rate. A halfband filter's taps
+	// are zero at even offsets from the center, apart from the center tap of 1/2, so only the odd ones are stored:
+	// decimationFilter holds every stage's taps at offsets 1, 3, 5, ... one stage after another (the filters are
+	// symmetric), and decimationTaps how many each stage has. Stages read from and write to decimationBuffers, which
+	// have decimationPadding zeros before and after the samples, so that samples beyond the block read as zero.
+	float* decimationFilter;
+	unsigned int* decimationTaps;
+	unsigned int decimationStages;
+	unsigned int decimationPadding;
+	float* decimationBuffers[2];
+	float* decimatedBlock;
+	float* analysisWindow;
+	float* spectrum;
+	
+	// Blocks below the gate's threshold skip peak picking: harmonicity is zero and the pitch is carried over. The
+	// decimated path measures the time-domain energy (tracked on every block, so it is current whenever the gate is enabled), the spectral
+	// path the energy of the spectrum.
+	SilenceGate gate;
+	BlockEnergy energy;
+	
+	// Peak picking parameters as read by process(). setParameter publishes a new set and process() adopts it at the
+	// start of the next block, so the host can change them while another thread is processing.
+	struct Settings {
+		float absThreshold, threshold, lpfCoefficient;
+		unsigned int searchRegionLength2, maxPeaks;
+		
+		Settings(float absThreshold, float threshold, unsigned int searchRegionLength, unsigned int maxPeaks, float lpfCoefficient);
+	};
+	
+	RealtimeConfiguration<Settings> settings;
+	
+	// Parameter values, as last set.
+	float absThreshold, threshold, lpfCoefficient;
+	unsigned int maxPeaks, searchRegionLength;
+	
+	float kVar;
+	float fftMax, pitch, filterOldValue, harmonicity;
+	unsigned int nMax, fftSize;
 	unsigned int minFrequencyIndex, maxFrequencyIndex;
 	
 	HarmonicityIntVector rawIndices, accIndices;
@@ -70,8 +122,20 @@ protected:
 	
 	Peak tempPeak;
 	
-	void pickPeaks(const float *const *inputBuffers);
-	float goldsteinGaussian(float x1, float x2, int n1, int n2, float f0, float k);
+	// Candidate f0 for each pair of harmonic numbers, and its probability as constant * exp(exponent).
+	float* hypothesisFrequencies;
+	float* hypothesisConstants;
+	float* hypothesisExponents;
+	
+	static const unsigned int MinAnalysisRate = 8000;
+	static const unsigned int MaxPeakFrequency = 3500;		// Top of the band searched for peaks.
+	static const unsigned int DecimationAttenuation = 70;		// Design stopband attenuation of each stage, in dB.
+	
+	void resetDecimation();
+	void decimate(const float* input);
+	void publishSettings();
+	void pickPeaks(const float *const *inputBuffers, const Settings& current);
+	void goldsteinGaussian(float x1, float x2, int n1, int n2, float f0, float k, float& constant, float& exponent);
 	void goldsteinCalc();
 	void resetVectors();
 	void freeMemory();
@@ -0,0 +1,28 @@
+#include "HarmonicityDecimated.h"
+
+HarmonicityDecimated::HarmonicityDecimated(float inputSampleRate) : Harmonicity(inputSampleRate) {
+	decimated = true;
+}
+
+HarmonicityDecimated::~HarmonicityDecimated() {
+}
+
+string HarmonicityDecimated::getIdentifier() const {
+	return "harmonicity-decimated";
+}
+
+string HarmonicityDecimated::getName() const {
+	return "Harmonicity (decimated)";
+}
+
+string HarmonicityDecimated::getDescription() const {
+	return "Calculates the degree to which the input sound originated from an harmonic source, analyzing only the band below 4kHz.";
+}
+
+HarmonicityDecimated::InputDomain HarmonicityDecimated::getInputDomain() const {
+	return TimeDomain;
+}
+
+size_t HarmonicityDecimated::getPreferredBlockSize() const {
+	return 2048;
+}
@@ -0,0 +1,23 @@
+#ifndef _HARMONICITYDECIMATED_H_
+#define _HARMONICITYDECIMATED_H_
+
+#include "Harmonicity.h"
+
+// Harmonicity computed from time-domain input that is lowpass filtered and decimated to 8-16kHz before its own, smaller
+// FFT. Only 90-3500Hz is searched for peaks either way, so this gives the same frequency resolution as Harmonicity with
+// the same block size, at a fraction of the FFT and peak picking cost on high sample rate recordings. Block sizes must
+// be powers of two.
+class HarmonicityDecimated : public Harmonicity {
+public:
+	HarmonicityDecimated(float inputSampleRate);
+	virtual ~HarmonicityDecimated();
+	
+	string getIdentifier() const;
+	string getName() const;
+	string getDescription() const;
+	
+	InputDomain getInputDomain() const;
+	size_t getPreferredBlockSize() const;
+};
+
+#endif
@@ -1,9 +1,15 @@
 #include "Loudness.h"
+#include "../support/Instrumentation.h"
+#include "../support/Denormals.h"
+#include "../support/FastMath.h"
 
 #include <cmath>
+#include <cstdio>
 using namespace std;
 
-Loudness::Loudness(float inputSampleRate) : Plugin(inputSampleRate), m_blockSize(0) {
+const float Loudness::Scales[Loudness::ScaleCount] = {0.1, 1, 10, 60};
+
+Loudness::Loudness(float inputSampleRate) : Plugin(inputSampleRate), m_blockSize(0), m_stepSize(0) {
 }
 
 Loudness::~Loudness() {
@@ -26,7 +32,7 @@ string Loudness::getMaker() const {
 }
 
 int Loudness::getPluginVersion() const {
-	return 1;
+	return 2;
 }
 
 string Loudness::getCopyright() const {
@@ -81,6 +87,33 @@ Loudness::OutputList Loudness::getOutputDescriptors() const {
 	d.hasDuration = false;
 	list.push_back(d);
 	
+	for (int scale = 0; scale < ScaleCount; scale++) {
+		char identifier[32];
+		char name[32];
+		
+		if (Scales[scale] < 1) {
+			sprintf(identifier, "loudness-%dms", int(Scales[scale] * 1000 + 0.5));
+			sprintf(name, "Loudness (%d ms)", int(Scales[scale] * 1000 + 0.5));
+		} else {
+			sprintf(identifier, "loudness-%ds", int(Scales[scale] + 0.5));
+			sprintf(name, "Loudness (%d s)", int(Scales[scale] + 0.5));
+		}
+		
+		OutputDescriptor scaleOutput;
+		scaleOutput.identifier = identifier;
+		scaleOutput.name = name;
+		scaleOutput.description = "dB-scaled mean power of the frames starting in consecutive windows of this length.";
+		scaleOutput.unit = "dB";
+		scaleOutput.hasFixedBinCount = true;
+		scaleOutput.binCount = 1;
+		scaleOutput.hasKnownExtents = false;
+		scaleOutput.isQuantized = false;
+		scaleOutput.sampleType = OutputDescriptor::VariableSampleRate;
+		scaleOutput.sampleRate = 1 / Scales[scale];
+		scaleOutput.hasDuration = true;
+		list.push_back(scaleOutput);
+	}
+	
 	return list;
 }
 
@@ -89,22 +122,26 @@ bool Loudness::initialise(size_t channels, size_t stepSize, size_t blockSize) {
 		return false;
 	else {
 		m_blockSize = blockSize;
+		m_stepSize = stepSize;
+		energy.initialize(stepSize, blockSize);
+		pyramid.clear();
 		return true;
 	}
 }
 
 void Loudness::reset() {
+	energy.reset();
+	pyramid.clear();
 }
 
 Loudness::FeatureSet Loudness::process(const float *const *inputBuffers, Vamp::RealTime timestamp) {
-	float sum_of_squares = 0;
+	SIRENS_TIME_SCOPE("Loudness::process", energy.getStepSize() * sizeof(float));
 	
-	for (unsigned int i = 0; i < m_blockSize; i++) {
-		float sample = inputBuffers[0][i];
-		sum_of_squares += sample * sample;
-	}
+	if (pyramid.getSize() == 0)
+		startTime = timestamp;
 	
-	float loudness = sum_of_squares > 0 ? 20 * log10(sum_of_squares / (float) m_blockSize) : 0;
+	float loudness;
+	processBatch(inputBuffers[0], 1, &loudness);
 	
 	Feature f;
 	f.hasTimestamp = false;
@@ -112,9 +149,88 @@ Loudness::FeatureSet Loudness::process(const float *const *inputBuffers, Vamp::R
 	
 	FeatureSet fs;
 	fs[0].push_back(f);
+	
+	// Emit the window of every time scale that this frame completes.
+	size_t frames = pyramid.getSize();
+	
+	for (int scale = 0; scale < ScaleCount; scale++) {
+		size_t scale_frames = getScaleFrames(scale);
+		
+		if (frames % scale_frames == 0)
+			fs[scale + 1].push_back(getScaleFeature(scale, frames - scale_frames, frames));
+	}
+	
 	return fs;
 }
 
 Loudness::FeatureSet Loudness::getRemainingFeatures() {
-	return FeatureSet();
+	FeatureSet fs;
+	
+	// Emit the windows that were cut short by the end of the input.
+	size_t frames = pyramid.getSize();
+	
+	for (int scale = 0; scale < ScaleCount; scale++) {
+		size_t scale_frames = getScaleFrames(scale);
+		
+		if (frames % scale_frames != 0)
+			fs[scale + 1].push_back(getScaleFeature(scale, frames - frames % scale_frames, frames));
+	}
+	
+	return fs;
+}
+
+size_t Loudness::getBatchOutputCount() const {
+	return 1;
+}
+
+void Loudness::processBatch(const float* blocks, unsigned int count, float* output) {
+	DenormalGuard guard;
+	
+	for (unsigned int frame = 0; frame < count; frame++) {
+		float sum_of_squares = energy.addBlock(blocks + frame * m_blockSize);
+		
+		output[frame] = sum_of_squares > 0 ? 20 * fastLog10(sum_of_squares / (float) m_blockSize) : 0;
+		pyramid.addValue(sum_of_squares / double(m_blockSize));
+	}
+}
+
+float Loudness::getLoudness(Vamp::RealTime start, Vamp::RealTime end) const {
+	if (m_stepSize == 0)
+		return 0;
+	
+	// Frame i starts i steps after startTime.
+	unsigned int sample_rate = (unsigned int)(m_inputSampleRate + 0.5);
+	long origin = Vamp::RealTime::realTime2Frame(startTime, sample_rate);
+	long start_sample = Vamp::RealTime::realTime2Frame(start, sample_rate) - origin;
+	long end_sample = Vamp::RealTime::realTime2Frame(end, sample_rate) - origin;
+	
+	size_t begin = start_sample > 0 ? size_t((start_sample + m_stepSize - 1) / m_stepSize) : 0;
+	size_t finish = end_sample > 0 ? size_t((end_sample + m_stepSize - 1) / m_stepSize) : 0;
+	
+	if (finish > pyramid.getSize())
+		finish = pyramid.getSize();
+	
+	if (begin >= finish)
+		return 0;
+	
+	double power = pyramid.getSum(begin, finish) / double(finish - begin);
+	return power > 0 ? 20 * log10(power) : 0;
+}
+
+// Number of frames in a window of a time scale.
+size_t Loudness::getScaleFrames(int scale) const {
+	size_t frames = m_stepSize > 0 ? size_t(Scales[scale] * m_inputSampleRate / m_stepSize + 0.5) : 1;
+	return frames > 0 ? frames : 1;
+}
+
+Loudness::Feature Loudness::getScaleFeature(int scale, size_t begin, size_t end) const {
+	double power = pyramid.getSum(begin, end) / double(end - begin);
+	
+	Feature f;
+	f.hasTimestamp = true;
+	f.timestamp = startTime + Vamp::RealTime::frame2RealTime(begin * m_stepSize, (unsigned int)(m_inputSampleRate + 0.5));
+	f.hasDuration = true;
+	f.duration = Vamp::RealTime::frame2RealTime((end - begin) * m_stepSize, (unsigned int)(m_inputSampleRate + 0.5));
+	f.values.push_back(power > 0 ? 20 * log10(power) : 0);
+	return f;
 }
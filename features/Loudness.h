@@ -4,7 +4,11 @@
 #include <vamp-sdk/Plugin.h>
 using std::string;
 
-class Loudness : public Vamp::Plugin {
+#include "../support/BatchProcessor.h"
+#include "../support/BlockEnergy.h"
+#include "../support/EnergyPyramid.h"
+
+class Loudness : public Vamp::Plugin, public BatchProcessor {
 public:
 	Loudness(float inputSampleRate);
 	virtual ~Loudness();
@@ -35,8 +39,30 @@ public:
 	
 	FeatureSet getRemainingFeatures();
 	
+	// The per-frame loudness of each block (see BatchProcessor.) The blocks' energies are added to the longer time
+	// scales, but their windows are only emitted by process(); batched blocks are timed from zero if they come first.
+	size_t getBatchOutputCount() const;
+	void processBatch(const float* blocks, unsigned int count, float* output);
+	
+	// Loudness over the frames that start within [start, end), from everything processed so far.
+	float getLoudness(Vamp::RealTime start, Vamp::RealTime end) const;
+	
 protected:
+	size_t getScaleFrames(int scale) const;
+	Feature getScaleFeature(int scale, size_t begin, size_t end) const;
+	
 	size_t m_blockSize;
+	size_t m_stepSize;
+	
+	BlockEnergy energy;
+	
+	// Mean square of every frame so far, for the longer time scales and range queries.
+	EnergyPyramid pyramid;
+	Vamp::RealTime startTime;
+	
+	// Time scales, in seconds, of the outputs after the per-frame loudness.
+	static const int ScaleCount = 4;
+	static const float Scales[ScaleCount];
 };
 
 #endif
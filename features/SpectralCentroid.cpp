@@ -1,18 +1,15 @@
 #include "SpectralCentroid.h"
+#include "../support/Instrumentation.h"
+#include "../support/Denormals.h"
 
 #include <cmath>
 using namespace std;
 
-SpectralCentroid::SpectralCentroid(float inputSampleRate) : Plugin(inputSampleRate) {
+SpectralCentroid::SpectralCentroid(float inputSampleRate) : Plugin(inputSampleRate), m_blockSize(0) {
 	m_sampleRate = inputSampleRate;
-	
-	barkUnits = NULL;
-	barkWeights = NULL;
 }
 
 SpectralCentroid::~SpectralCentroid() {
-	delete[] barkUnits;
-	delete[] barkWeights;
 }
 
 string SpectralCentroid::getIdentifier() const {
@@ -32,7 +29,7 @@ string SpectralCentroid::getMaker() const {
 }
 
 int SpectralCentroid::getPluginVersion() const {
-	return 1;
+	return 2;
 }
 
 string SpectralCentroid::getCopyright() const {
@@ -95,15 +92,7 @@ bool SpectralCentroid::initialise(size_t channels, size_t stepSize, size_t block
 		return false;
 	else {
 		m_blockSize = blockSize;
-		
-		barkUnits = new float[m_blockSize];
-		barkWeights = new float[m_blockSize - 1];
-		
-		for (unsigned int i = 0; i < m_blockSize; i++)
-			barkUnits[i] = hz_to_bark((m_sampleRate * i) / float(2 * (m_blockSize - 1)));
-		
-		for (unsigned int i = 0; i < m_blockSize - 1; i++)
-			barkWeights[i] = barkUnits[i + 1] - barkUnits[i];
+		reduction.initialize(m_blockSize, m_sampleRate);
 		
 		return true;
 	}
@@ -113,31 +102,10 @@ void SpectralCentroid::reset() {
 }
 
 SpectralCentroid::FeatureSet SpectralCentroid::process(const float *const *inputBuffers, Vamp::RealTime timestamp) {
-	float sum = 0;
-	
-	float* weight_item = barkWeights;
-	
-	for (unsigned int i = 1; i < m_blockSize; i++) {
-		float sample = inputBuffers[0][i];
-		
-		sum += sample * sample * *weight_item;
-	}
-	
-	float centroid = 0;
+	SIRENS_TIME_SCOPE("SpectralCentroid::process", 3 * m_blockSize * sizeof(float));
 	
-	if (sum > 0) {
-		weight_item = barkWeights;
-		float* unit_item = barkUnits + 1;
-	
-		for (unsigned int i = 1; i < m_blockSize; i++) {
-			float sample = inputBuffers[0][i];
-		
-			centroid += sample * sample * ((*weight_item) / sum) * *unit_item;
-		
-			unit_item ++; 
-			weight_item ++;
-		}
-	}
+	float centroid;
+	processBatch(inputBuffers[0], 1, &centroid);
 	
 	Feature f;
 	f.hasTimestamp = false;
@@ -152,6 +120,16 @@ SpectralCentroid::FeatureSet SpectralCentroid::getRemainingFeatures() {
 	return FeatureSet();
 }
 
-float SpectralCentroid::hz_to_bark(float hz) {
-	return 6.0 * asinh(hz / 600.0);
-}
\ No newline at end of file
+size_t SpectralCentroid::getBatchOutputCount() const {
+	return 1;
+}
+
+void SpectralCentroid::processBatch(const float* blocks, unsigned int count, float* output) {
+	DenormalGuard guard;
+	SpectrumStatistics statistics;
+	
+	for (unsigned int frame = 0; frame < count; frame++) {
+		reduction.reduce(blocks + frame * m_blockSize, statistics);
+		output[frame] = statistics.weightedPower > 0 ? statistics.weightedMoment / statistics.weightedPower : 0;
+	}
+}
@@ -4,7 +4,10 @@
 #include <vamp-sdk/Plugin.h>
 using std::string;
 
-class SpectralCentroid : public Vamp::Plugin {
+#include "../support/BatchProcessor.h"
+#include "../support/SpectrumReduction.h"
+
+class SpectralCentroid : public Vamp::Plugin, public BatchProcessor {
 public:
 	SpectralCentroid(float inputSampleRate);
 	virtual ~SpectralCentroid();
@@ -35,14 +38,15 @@ public:
 	
 	FeatureSet getRemainingFeatures();
 	
-protected:
-	float hz_to_bark(float hz);
+	// The centroid of each spectrum (see BatchProcessor.)
+	size_t getBatchOutputCount() const;
+	void processBatch(const float* blocks, unsigned int count, float* output);
 	
+protected:
 	size_t m_blockSize;
 	float m_sampleRate;
 	
-	float* barkWeights;
-	float* barkUnits;
+	SpectrumReduction reduction;
 };
 
 #endif
@@ -0,0 +1,151 @@
+#include "SpectralShape.h"
+#include "../support/Instrumentation.h"
+#include "../support/Denormals.h"
+
+SpectralShape::SpectralShape(float inputSampleRate) : Plugin(inputSampleRate), m_blockSize(0) {
+	m_sampleRate = inputSampleRate;
+}
+
+SpectralShape::~SpectralShape() {
+}
+
+string SpectralShape::getIdentifier() const {
+	return "spectral-shape";
+}
+
+string SpectralShape::getName() const {
+	return "Spectral shape";
+}
+
+string SpectralShape::getDescription() const {
+	return "Calculates spectral sparsity and Bark-weighted spectral centroid together, in one pass over the spectrum.";
+}
+
+string SpectralShape::getMaker() const {
+	return "Sirens";
+}
+
+int SpectralShape::getPluginVersion() const {
+	return 1;
+}
+
+string SpectralShape::getCopyright() const {
+	return "MIT";
+}
+
+SpectralShape::InputDomain SpectralShape::getInputDomain() const {
+	return FrequencyDomain;
+}
+
+size_t SpectralShape::getPreferredBlockSize() const {
+	return 0;
+}
+
+size_t SpectralShape::getPreferredStepSize() const {
+	return 0;
+}
+
+size_t SpectralShape::getMinChannelCount() const {
+	return 1;
+}
+
+size_t SpectralShape::getMaxChannelCount() const {
+	return 1;
+}
+
+SpectralShape::ParameterList SpectralShape::getParameterDescriptors() const {
+	ParameterList list;
+	return list;
+}
+
+float SpectralShape::getParameter(string identifier) const {
+	return 0;
+}
+
+void SpectralShape::setParameter(string identifier, float value)	 {
+}
+
+SpectralShape::OutputList SpectralShape::getOutputDescriptors() const {
+	OutputList list;
+	
+	OutputDescriptor sparsityOutput;
+	sparsityOutput.identifier = "spectral-sparsity";
+	sparsityOutput.name = "Spectral sparsity";
+	sparsityOutput.description = "ratio of maximum spectral power to total power.";
+	sparsityOutput.unit = "";
+	sparsityOutput.hasFixedBinCount = true;
+	sparsityOutput.binCount = 1;
+	sparsityOutput.hasKnownExtents = false;
+	sparsityOutput.isQuantized = false;
+	sparsityOutput.sampleType = OutputDescriptor::OneSamplePerStep;
+	sparsityOutput.hasDuration = false;
+	list.push_back(sparsityOutput);
+	
+	OutputDescriptor centroidOutput;
+	centroidOutput.identifier = "spectral-centroid";
+	centroidOutput.name = "Spectral centroid";
+	centroidOutput.description = "Bark-weighted centroid of the frequency spectrum of the input signal.";
+	centroidOutput.unit = "barks";
+	centroidOutput.hasFixedBinCount = true;
+	centroidOutput.binCount = 1;
+	centroidOutput.hasKnownExtents = false;
+	centroidOutput.isQuantized = false;
+	centroidOutput.sampleType = OutputDescriptor::OneSamplePerStep;
+	centroidOutput.hasDuration = false;
+	list.push_back(centroidOutput);
+	
+	return list;
+}
+
+bool SpectralShape::initialise(size_t channels, size_t stepSize, size_t blockSize) {
+	if (channels < getMinChannelCount() || channels > getMaxChannelCount())
+		return false;
+	else {
+		m_blockSize = blockSize;
+		reduction.initialize(m_blockSize, m_sampleRate);
+		return true;
+	}
+}
+
+void SpectralShape::reset() {
+}
+
+SpectralShape::FeatureSet SpectralShape::process(const float *const *inputBuffers, Vamp::RealTime timestamp) {
+	SIRENS_TIME_SCOPE("SpectralShape::process", 3 * m_blockSize * sizeof(float));
+	
+	float values[2];
+	processBatch(inputBuffers[0], 1, values);
+	
+	Feature sparsityFeature;
+	sparsityFeature.hasTimestamp = false;
+	sparsityFeature.values.push_back(values[0]);
+	
+	Feature centroidFeature;
+	centroidFeature.hasTimestamp = false;
+	centroidFeature.values.push_back(values[1]);
+	
+	FeatureSet fs;
+	fs[0].push_back(sparsityFeature);
+	fs[1].push_back(centroidFeature);
+	return fs;
+}
+
+SpectralShape::FeatureSet SpectralShape::getRemainingFeatures() {
+	return FeatureSet();
+}
+
+size_t SpectralShape::getBatchOutputCount() const {
+	return 2;
+}
+
+void SpectralShape::processBatch(const float* blocks, unsigned int count, float* output) {
+	DenormalGuard guard;
+	SpectrumStatistics statistics;
+	
+	for (unsigned int frame = 0; frame < count; frame++) {
+		reduction.reduce(blocks + frame * m_blockSize, statistics);
+		
+		output[2 * frame] = statistics.sum > 0 ? (statistics.max / statistics.sum) : 0;
+		output[2 * frame + 1] = statistics.weightedPower > 0 ? statistics.weightedMoment / statistics.weightedPower : 0;
+	}
+}
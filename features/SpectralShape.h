@@ -0,0 +1,52 @@
+#ifndef _SPECTRALSHAPE_H_
+#define _SPECTRALSHAPE_H_
+
+#include <vamp-sdk/Plugin.h>
+using std::string;
+
+#include "../support/BatchProcessor.h"
+#include "../support/SpectrumReduction.h"
+
+class SpectralShape : public Vamp::Plugin, public BatchProcessor {
+public:
+	SpectralShape(float inputSampleRate);
+	virtual ~SpectralShape();
+	
+	string getIdentifier() const;
+	string getName() const;
+	string getDescription() const;
+	string getMaker() const;
+	int getPluginVersion() const;
+	string getCopyright() const;
+	
+	InputDomain getInputDomain() const;
+	size_t getPreferredBlockSize() const;
+	size_t getPreferredStepSize() const;
+	size_t getMinChannelCount() const;
+	size_t getMaxChannelCount() const;
+	
+	ParameterList getParameterDescriptors() const;
+	float getParameter(string identifier) const;
+	void setParameter(string identifier, float value);
+	
+	OutputList getOutputDescriptors() const;
+	
+	bool initialise(size_t channels, size_t stepSize, size_t blockSize);
+	void reset();
+	
+	FeatureSet process(const float *const *inputBuffers, Vamp::RealTime timestamp);
+	
+	FeatureSet getRemainingFeatures();
+	
+	// The sparsity and centroid of each spectrum (see BatchProcessor.)
+	size_t getBatchOutputCount() const;
+	void processBatch(const float* blocks, unsigned int count, float* output);
+	
+protected:
+	size_t m_blockSize;
+	float m_sampleRate;
+	
+	SpectrumReduction reduction;
+};
+
+#endif
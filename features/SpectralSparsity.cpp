@@ -1,4 +1,6 @@
 #include "SpectralSparsity.h"
+#include "../support/Instrumentation.h"
+#include "../support/Denormals.h"
 
 SpectralSparsity::SpectralSparsity(float inputSampleRate) : Plugin(inputSampleRate), m_blockSize(0) {
 }
@@ -86,6 +88,7 @@ bool SpectralSparsity::initialise(size_t channels, size_t stepSize, size_t block
 		return false;
 	else {
 		m_blockSize = blockSize;
+		reduction.initialize(m_blockSize);
 		return true;
 	}
 }
@@ -95,17 +98,10 @@ void SpectralSparsity::reset() {
 }
 
 SpectralSparsity::FeatureSet SpectralSparsity::process(const float *const *inputBuffers, Vamp::RealTime timestamp) {
-	float max = 0;
-	float sum = 0;
+	SIRENS_TIME_SCOPE("SpectralSparsity::process", m_blockSize * sizeof(float));
 	
-	for (unsigned int i = 0; i < m_blockSize; i++) {
-		float bin = inputBuffers[0][i];
-		
-		max = max > bin ? max : bin;
-		sum += bin;
-	}
-	
-	float sparsity = sum > 0 ? (max / sum) : 0;
+	float sparsity;
+	processBatch(inputBuffers[0], 1, &sparsity);
 	
 	Feature f;
 	f.hasTimestamp = false;
@@ -119,3 +115,17 @@ SpectralSparsity::FeatureSet SpectralSparsity::process(const float *const *input
 SpectralSparsity::FeatureSet SpectralSparsity::getRemainingFeatures() {
 	return FeatureSet();
 }
+
+size_t SpectralSparsity::getBatchOutputCount() const {
+	return 1;
+}
+
+void SpectralSparsity::processBatch(const float* blocks, unsigned int count, float* output) {
+	DenormalGuard guard;
+	SpectrumStatistics statistics;
+	
+	for (unsigned int frame = 0; frame < count; frame++) {
+		reduction.reduce(blocks + frame * m_blockSize, statistics);
+		output[frame] = statistics.sum > 0 ? (statistics.max / statistics.sum) : 0;
+	}
+}
@@ -4,7 +4,10 @@
 #include <vamp-sdk/Plugin.h>
 using std::string;
 
-class SpectralSparsity : public Vamp::Plugin {
+#include "../support/BatchProcessor.h"
+#include "../support/SpectrumReduction.h"
+
+class SpectralSparsity : public Vamp::Plugin, public BatchProcessor {
 public:
 	SpectralSparsity(float inputSampleRate);
 	virtual ~SpectralSparsity();
@@ -35,8 +38,14 @@ public:
 	
 	FeatureSet getRemainingFeatures();
 	
+	// The sparsity of each spectrum (see BatchProcessor.)
+	size_t getBatchOutputCount() const;
+	void processBatch(const float* blocks, unsigned int count, float* output);
+	
 protected:
 	size_t m_blockSize;
+	
+	SpectrumReduction reduction;
 };
 
 #endif
@@ -1,17 +1,16 @@
 #include "TemporalSparsity.h"
+#include "../support/Instrumentation.h"
+#include "../support/Denormals.h"
 
 #include <cmath>
 using namespace std;
 
 TemporalSparsity::TemporalSparsity(float inputSampleRate) : Plugin(inputSampleRate), m_blockSize(0) {
 	windowSize = 50;
-	
-	rmsWindow = NULL;
-	resetWindow();
+	rmsWindow.replace(windowSize);
 }
 
 TemporalSparsity::~TemporalSparsity() {
-	delete rmsWindow;
 }
 
 string TemporalSparsity::getIdentifier() const {
@@ -78,7 +77,7 @@ TemporalSparsity::ParameterList TemporalSparsity::getParameterDescriptors() cons
 
 float TemporalSparsity::getParameter(string identifier) const {
 	if (identifier == "window-size")
-		return float(rmsWindow->getMaxSize());
+		return float(windowSize);
 	
 	return 0;
 }
@@ -86,7 +85,7 @@ float TemporalSparsity::getParameter(string identifier) const {
 void TemporalSparsity::setParameter(string identifier, float value)	 {
 	if (identifier == "window-size") {
 		windowSize = int(value);
-		resetWindow();
+		rmsWindow.publish(windowSize);
 	}
 }
 
@@ -114,44 +113,21 @@ bool TemporalSparsity::initialise(size_t channels, size_t stepSize, size_t block
 		return false;
 	else {
 		m_blockSize = blockSize;
+		energy.initialize(stepSize, blockSize);
 		return true;
 	}
 }
 
 void TemporalSparsity::reset() {
-	resetWindow();
+	energy.reset();
+	rmsWindow.replace(windowSize);
 }
 
 TemporalSparsity::FeatureSet TemporalSparsity::process(const float *const *inputBuffers, Vamp::RealTime timestamp) {
-	// Calculate RMS.
-	float sum_of_squares = 0;
-	
-	for (unsigned int i = 0; i < m_blockSize; i++) {
-		float sample = inputBuffers[0][i];
-		sum_of_squares += sample * sample;
-	}
+	SIRENS_TIME_SCOPE("TemporalSparsity::process", energy.getStepSize() * sizeof(float));
 	
-	rmsWindow->addValue(sqrt(sum_of_squares / float(m_blockSize)));
-	
-	float sparsity = 0;
-	
-	if (rmsWindow->getSize() >= 1) {
-		float max = 0;
-		float sum = 0;
-		
-		int rms_size = rmsWindow->getSize();
-		int max_size = rmsWindow->getMaxSize();
-		float* rms_item = rmsWindow->getData();
-		
-		for (int i = 0; i < rms_size; i++) {
-			max = max > *rms_item ? max : *rms_item;
-			sum += (*rms_item);
-			
-			rms_item ++;
-		}
-		
-		sparsity = sum > 0 ? (float(rms_size) / float(max_size)) * (max / sum) : 0;	
-	}
+	float sparsity;
+	processBatch(inputBuffers[0], 1, &sparsity);
 	
 	Feature f;
 	f.hasTimestamp = false;
@@ -168,9 +144,39 @@ TemporalSparsity::FeatureSet TemporalSparsity::getRemainingFeatures() {
 	return FeatureSet();
 }
 
-void TemporalSparsity::resetWindow() {
-	if (rmsWindow)
-		delete rmsWindow;
+size_t TemporalSparsity::getBatchOutputCount() const {
+	return 1;
+}
+
+void TemporalSparsity::processBatch(const float* blocks, unsigned int count, float* output) {
+	DenormalGuard guard;
+	CircularArray* window = rmsWindow.update();
 	
-	rmsWindow = new CircularArray(windowSize);
+	for (unsigned int frame = 0; frame < count; frame++) {
+		float sum_of_squares = energy.addBlock(blocks + frame * m_blockSize);
+		
+		window->addValue(sqrt(sum_of_squares / float(m_blockSize)));
+		
+		float sparsity = 0;
+		
+		if (window->getSize() >= 1) {
+			float max = 0;
+			float sum = 0;
+			
+			int rms_size = window->getSize();
+			int max_size = window->getMaxSize();
+			float* rms_item = window->getData();
+			
+			for (int i = 0; i < rms_size; i++) {
+				max = max > *rms_item ? max : *rms_item;
+				sum += (*rms_item);
+				
+				rms_item ++;
+			}
+			
+			sparsity = sum > 0 ? (float(rms_size) / float(max_size)) * (max / sum) : 0;
+		}
+		
+		output[frame] = sparsity;
+	}
 }
@@ -4,9 +4,12 @@
 #include <vamp-sdk/Plugin.h>
 using std::string;
 
+#include "../support/BatchProcessor.h"
 #include "../support/CircularArray.h"
+#include "../support/BlockEnergy.h"
+#include "../support/RealtimeConfiguration.h"
 
-class TemporalSparsity : public Vamp::Plugin {
+class TemporalSparsity : public Vamp::Plugin, public BatchProcessor {
 public:
 	TemporalSparsity(float inputSampleRate);
 	virtual ~TemporalSparsity();
@@ -37,13 +40,18 @@ public:
 	
 	FeatureSet getRemainingFeatures();
 	
-protected:
-	void resetWindow();
+	// The sparsity of each block (see BatchProcessor.)
+	size_t getBatchOutputCount() const;
+	void processBatch(const float* blocks, unsigned int count, float* output);
 	
+protected:
 	size_t m_blockSize;
 	
+	BlockEnergy energy;
+	
+	// Window size as last set. setParameter builds the new window off the processing thread, and process() swaps it in.
 	int windowSize;
-	CircularArray* rmsWindow;
+	RealtimeConfiguration<CircularArray> rmsWindow;
 };
 
 #endif
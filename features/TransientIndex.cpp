@@ -1,4 +1,7 @@
 #include "TransientIndex.h"
+#include "../support/Instrumentation.h"
+#include "../support/Kernels.h"
+#include "../support/Denormals.h"
 
 #include <cmath>
 using namespace std;
@@ -10,16 +13,9 @@ TransientIndex::TransientIndex(float inputSampleRate) : Plugin(inputSampleRate),
 	
 	filters = 30;
 	mels = 15;
-	
-	mfccNew = NULL;
-	mfccOld = NULL;
-	dctMatrix = NULL;
-	filterTemp = NULL;
-	filterBank = NULL;
 }
 
 TransientIndex::~TransientIndex() {
-	freeMemory();
 }
 
 string TransientIndex::getIdentifier() const {
@@ -39,7 +35,7 @@ string TransientIndex::getMaker() const {
 }
 
 int TransientIndex::getPluginVersion() const {
-	return 1;
+	return 2;
 }
 
 string TransientIndex::getCopyright() const {
@@ -93,6 +89,29 @@ TransientIndex::ParameterList TransientIndex::getParameterDescriptors() const {
 	melsParameter.isQuantized = true;
 	list.push_back(melsParameter);
 	
+	ParameterDescriptor silenceGateParameter;
+	silenceGateParameter.identifier = "silence-gate";
+	silenceGateParameter.name = "Silence gate";
+	silenceGateParameter.description = "Skip the analysis of blocks quieter than the silence threshold.";
+	silenceGateParameter.unit = "";
+	silenceGateParameter.minValue = 0;
+	silenceGateParameter.maxValue = 1;
+	silenceGateParameter.defaultValue = 0;
+	silenceGateParameter.quantizeStep = 1;
+	silenceGateParameter.isQuantized = true;
+	list.push_back(silenceGateParameter);
+	
+	ParameterDescriptor silenceThresholdParameter;
+	silenceThresholdParameter.identifier = "silence-threshold";
+	silenceThresholdParameter.name = "Silence threshold";
+	silenceThresholdParameter.description = "Level, on the scale of the Loudness output, below which the silence gate skips a block.";
+	silenceThresholdParameter.unit = "dB";
+	silenceThresholdParameter.minValue = -200;
+	silenceThresholdParameter.maxValue = 0;
+	silenceThresholdParameter.defaultValue = -120;
+	silenceThresholdParameter.isQuantized = false;
+	list.push_back(silenceThresholdParameter);
+	
 	return list;
 }
 
@@ -101,18 +120,28 @@ float TransientIndex::getParameter(string identifier) const {
 		return float(filters);
 	else if (identifier == "mels")
 		return float(mels);
+	else if (identifier == "silence-gate")
+		return gate.isEnabled() ? 1 : 0;
+	else if (identifier == "silence-threshold")
+		return gate.getThreshold();
 	else
 		return 0;
 }
 
 void TransientIndex::setParameter(string identifier, float value)  {
-	if (identifier == "filters") {
-		filters = int(value);
-		resetFilterBank();
-	} else if (identifier == "mels") {
-		mels = int(value);
-		resetFilterBank();
-	}
+	if (identifier == "filters" || identifier == "mels") {
+		if (identifier == "filters")
+			filters = int(value);
+		else
+			mels = int(value);
+		
+		// Before initialise() there is no block size to build for; initialise() builds the tables then.
+		if (m_blockSize > 0)
+			tables.publish(filters, mels, m_blockSize, m_sampleRate);
+	} else if (identifier == "silence-gate")
+		gate.setEnabled(value >= 0.5);
+	else if (identifier == "silence-threshold")
+		gate.setThreshold(value);
 }
 
 TransientIndex::OutputList TransientIndex::getOutputDescriptors() const {
@@ -130,6 +159,22 @@ TransientIndex::OutputList TransientIndex::getOutputDescriptors() const {
 	d.sampleType = OutputDescriptor::OneSamplePerStep;
 	d.hasDuration = false;
 	list.push_back(d);
+	
+	OutputDescriptor skipRateOutput;
+	skipRateOutput.identifier = "skip-rate";
+	skipRateOutput.name = "Skip rate";
+	skipRateOutput.description = "fraction of blocks skipped by the silence gate, given at the end when the gate is enabled.";
+	skipRateOutput.unit = "";
+	skipRateOutput.hasFixedBinCount = true;
+	skipRateOutput.binCount = 1;
+	skipRateOutput.hasKnownExtents = true;
+	skipRateOutput.minValue = 0;
+	skipRateOutput.maxValue = 1;
+	skipRateOutput.isQuantized = false;
+	skipRateOutput.sampleType = OutputDescriptor::VariableSampleRate;
+	skipRateOutput.sampleRate = 0;
+	skipRateOutput.hasDuration = false;
+	list.push_back(skipRateOutput);
 
 	return list;
 }
@@ -139,47 +184,28 @@ bool TransientIndex::initialise(size_t channels, size_t stepSize, size_t blockSi
 		return false;
 	else {
 		m_blockSize = blockSize;
-		resetFilterBank();
+		tables.replace(filters, mels, m_blockSize, m_sampleRate);
 		return true;
 	}
 }
 
 void TransientIndex::reset() {
-	resetFilterBank();
-}
-
-TransientIndex::FeatureSet TransientIndex::process(const float *const *inputBuffers, Vamp::RealTime timestamp) {
-	// Calculate the MFCC vector for the current frame.
-	for (unsigned int i = 0; i < filters; i++) {
-		filterTemp[i] = 0;
-		
-		for (unsigned int j = 0; j < m_blockSize; j++)
-			filterTemp[i] += filterBank[(i * m_blockSize) + j] * inputBuffers[0][j];
-		
-		filterTemp[i] = (filterTemp[i] > 0) ? log(filterTemp[i]) : 0;
-	}
+	gate.reset();
 	
-	for (unsigned int i = 0; i < mels; i++) {
-		mfccNew[i] = 0;
+	Tables* current = tables.update();
 	
-		for (unsigned int j = 0; j < filters; j++)
-			mfccNew[i] += dctMatrix[(i * filters) + j] * filterTemp[j];
+	if (current != NULL) {
+		for (unsigned int i = 0; i < current->mels; i++)
+			current->mfccOld[i] = 0;
 	}
+}
+
+TransientIndex::FeatureSet TransientIndex::process(const float *const *inputBuffers, Vamp::RealTime timestamp) {
+	// Only instrumented builds evaluate the byte count; processBatch adopts new tables either way.
+	SIRENS_TIME_SCOPE("TransientIndex::process", tables.update() != NULL ? (tables.get()->filters + 1) * m_blockSize * sizeof(float) : 0);
 	
-	// Calculate transient index.
-	float sum_of_squared_error = 0;
-	
-	for (unsigned int i = 0; i < mels; i++) {
-		float error = mfccNew[i] - mfccOld[i];
-		sum_of_squared_error += error * error;
-	}
-	
-	float index = sqrt(sum_of_squared_error);
-	
-	// Swap MFCC vectors.
-	float* mfccTemp = mfccOld;
-	mfccOld = mfccNew;
-	mfccNew = mfccTemp;
+	float index;
+	processBatch(inputBuffers[0], 1, &index);
 	
 	Feature f;
 	f.hasTimestamp = false;
@@ -191,78 +217,208 @@ TransientIndex::FeatureSet TransientIndex::process(const float *const *inputBuff
 }
 
 TransientIndex::FeatureSet TransientIndex::getRemainingFeatures() {
-	return FeatureSet();
+	FeatureSet fs;
+	
+	if (gate.isEnabled()) {
+		Feature f;
+		f.hasTimestamp = true;
+		f.timestamp = Vamp::RealTime();
+		f.values.push_back(gate.getSkipRate());
+		fs[1].push_back(f);
+	}
+	
+	return fs;
 }
 
+size_t TransientIndex::getBatchOutputCount() const {
+	return 1;
+}
 
-void TransientIndex::resetFilterBank() {
-	freeMemory();
+void TransientIndex::processBatch(const float* spectra, unsigned int count, float* output) {
+	DenormalGuard guard;
+	Tables* current = tables.update();
 	
-	if (m_blockSize > 0) {
-		dctMatrix = new float[filters * mels];
-		filterBank = new float[filters * m_blockSize];
-		filterTemp = new float[filters];
-	
-		mfccNew = new float[mels];
-		mfccOld = new float[mels];
-
-		// Initialisation
-		float min_mel = hz_to_mel(50.0);
-		float max_mel = hz_to_mel(m_sampleRate / 2);
+	if (current == NULL) {
+		for (unsigned int frame = 0; frame < count; frame++)
+			output[frame] = 0;
+		
+		return;
+	}
 	
-		float* filter_values = new float[m_blockSize];
-		float* filter_centers = new float[filters + 2];
+	const unsigned int filters = current->filters;
+	const unsigned int mels = current->mels;
+	const float* dctMatrix = current->dctMatrix;
+	const float* filterBank = current->filterBank;
+	const unsigned int* filterStart = current->filterStart;
+	const unsigned int* filterEnd = current->filterEnd;
+	float* mfccOld = current->mfccOld;
+	float* batchFilters = current->batchFilters;
+	float* batchMfcc = current->batchMfcc;
+	bool* batchSilent = current->batchSilent;
+	bool* batchZero = current->batchZero;
 	
-		for (unsigned int i = 0; i < m_blockSize; i++)
-			filter_values[i] = (m_sampleRate * i) / float(2 * (m_blockSize - 1));
+	const KernelTable& kernels = getKernels();
 	
-		for (unsigned int i = 0; i < mels; i++) {
-			for (unsigned int j = 0; j < filters; j++)
-				dctMatrix[i * filters + j] = cos((i + 1) * (PI / filters * (j + 0.5)));
+	for (unsigned int tile_start = 0; tile_start < count; tile_start += BatchTile) {
+		unsigned int tile = count - tile_start < BatchTile ? count - tile_start : BatchTile;
+		const float* tile_spectra = spectra + tile_start * m_blockSize;
+		
+		// Silent frames (below the gate) and all-zero ones skip the filterbank and DCT.
+		for (unsigned int frame = 0; frame < tile; frame++) {
+			const float* spectrum = tile_spectra + frame * m_blockSize;
+			
+			batchSilent[frame] = gate.isEnabled() && gate.isSilent(SilenceGate::getSpectrumMeanSquare(spectrum, m_blockSize));
+			batchZero[frame] = !batchSilent[frame] && isZeroBlock(spectrum, m_blockSize);
+			
+			if (batchZero[frame])
+				batchSilent[frame] = true;
 		}
-	
-		for (unsigned int i = 0; i < filters + 2; i++)
-			filter_centers[i] = mel_to_hz(min_mel + ((max_mel - min_mel) / (filters + 1)) * i);
-	
+		
+		// Log filterbank energies for every frame in the tile. Each filter's coefficients are loaded once per tile,
+		// and only over the bins where the filter is nonzero; the logs are then taken a frame at a time.
 		for (unsigned int i = 0; i < filters; i++) {
-			for (unsigned int j = 0; j < m_blockSize; j++) {
-				if (filter_values[j] >= filter_centers[i] && filter_values[j] < filter_centers[i + 1])
-					filterBank[(i * m_blockSize) + j] = (filter_values[j] - filter_centers[i]) / (filter_centers[i + 1] - filter_centers[i]);
-				else if (filter_values[j] >= filter_centers[i + 1] && filter_values[j] < filter_centers[i + 2])
-					filterBank[(i * m_blockSize) + j] = (filter_values[j] - filter_centers[i + 2]) / (filter_centers[i + 1] - filter_centers[i + 2]);
-				else
-					filterBank[(i * m_blockSize) + j] = 0;
+			const float* filter = filterBank + i * m_blockSize;
+			
+			for (unsigned int frame = 0; frame < tile; frame++) {
+				if (batchSilent[frame])
+					continue;
+				
+				const float* spectrum = tile_spectra + frame * m_blockSize;
+				float energy = kernels.dotProduct(filter + filterStart[i], spectrum + filterStart[i], filterEnd[i] - filterStart[i]);
+				
+				// Filters with no energy get a log energy of zero.
+				batchFilters[frame * filters + i] = (energy > 0) ? energy : 1;
 			}
 		}
-	
-		for (unsigned int i = 0; i < mels; i++) {
-			mfccNew[i] = 0;
-			mfccOld[i] = 0;
+		
+		for (unsigned int frame = 0; frame < tile; frame++) {
+			if (!batchSilent[frame])
+				kernels.naturalLog(batchFilters + frame * filters, batchFilters + frame * filters, filters);
+		}
+		
+		// MFCCs for every frame in the tile.
+		for (unsigned int frame = 0; frame < tile; frame++) {
+			if (batchSilent[frame])
+				continue;
+			
+			for (unsigned int i = 0; i < mels; i++)
+				batchMfcc[frame * mels + i] = kernels.dotProduct(dctMatrix + i * filters, batchFilters + frame * filters, filters);
+		}
+		
+		// Transient index: the difference between consecutive MFCC vectors. Silent frames reset the previous MFCCs to
+		// zero, as at the start of the input.
+		for (unsigned int frame = 0; frame < tile; frame++) {
+			if (batchZero[frame]) {
+				// An all-zero spectrum has all-zero MFCCs (every filter's log energy is taken as zero), so the index is
+				// just the size of the previous MFCCs.
+				float sum_of_squares = 0;
+				
+				for (unsigned int i = 0; i < mels; i++) {
+					sum_of_squares += mfccOld[i] * mfccOld[i];
+					mfccOld[i] = 0;
+				}
+				
+				output[tile_start + frame] = sqrt(sum_of_squares);
+				continue;
+			} else if (batchSilent[frame]) {
+				SIRENS_COUNT("TransientIndex::gatedBlocks", 1);
+				
+				for (unsigned int i = 0; i < mels; i++)
+					mfccOld[i] = 0;
+				
+				output[tile_start + frame] = 0;
+				continue;
+			}
+			
+			float* mfcc = batchMfcc + frame * mels;
+			float sum_of_squared_error = 0;
+			
+			for (unsigned int i = 0; i < mels; i++) {
+				float error = mfcc[i] - mfccOld[i];
+				sum_of_squared_error += error * error;
+				
+				mfccOld[i] = mfcc[i];
+			}
+			
+			output[tile_start + frame] = sqrt(sum_of_squared_error);
 		}
-	
-		for (unsigned int i = 0; i < filters; i++)
-			filterTemp[i] = 0;
-
-		delete[] filter_values;
-		delete[] filter_centers;
 	}
 }
 
-void TransientIndex::freeMemory() {
-	if (dctMatrix)
-		delete[] dctMatrix;
+TransientIndex::Tables::Tables(unsigned int filters, unsigned int mels, size_t blockSize, float sampleRate) : filters(filters), mels(mels), blockSize(blockSize) {
+	dctMatrix = new float[filters * mels];
+	filterBank = new float[filters * blockSize];
 	
-	if (filterBank)
-		delete[] filterBank;
+	mfccOld = new float[mels];
 	
-	if (filterTemp)
-		delete[] filterTemp;
+	filterStart = new unsigned int[filters];
+	filterEnd = new unsigned int[filters];
 	
-	if (mfccNew)
-		delete[] mfccNew;
+	batchFilters = new float[BatchTile * filters];
+	batchMfcc = new float[BatchTile * mels];
+	batchSilent = new bool[BatchTile];
+	batchZero = new bool[BatchTile];
+
+	// Initialisation
+	float min_mel = hz_to_mel(50.0);
+	float max_mel = hz_to_mel(sampleRate / 2);
+	
+	float* filter_values = new float[blockSize];
+	float* filter_centers = new float[filters + 2];
 	
-	if (mfccOld)
-		delete[] mfccOld;	
+	for (unsigned int i = 0; i < blockSize; i++)
+		filter_values[i] = (sampleRate * i) / float(2 * (blockSize - 1));
+	
+	for (unsigned int i = 0; i < mels; i++) {
+		for (unsigned int j = 0; j < filters; j++)
+			dctMatrix[i * filters + j] = cos((i + 1) * (PI / filters * (j + 0.5)));
+	}
+	
+	for (unsigned int i = 0; i < filters + 2; i++)
+		filter_centers[i] = mel_to_hz(min_mel + ((max_mel - min_mel) / (filters + 1)) * i);
+	
+	for (unsigned int i = 0; i < filters; i++) {
+		for (unsigned int j = 0; j < blockSize; j++) {
+			if (filter_values[j] >= filter_centers[i] && filter_values[j] < filter_centers[i + 1])
+				filterBank[(i * blockSize) + j] = (filter_values[j] - filter_centers[i]) / (filter_centers[i + 1] - filter_centers[i]);
+			else if (filter_values[j] >= filter_centers[i + 1] && filter_values[j] < filter_centers[i + 2])
+				filterBank[(i * blockSize) + j] = (filter_values[j] - filter_centers[i + 2]) / (filter_centers[i + 1] - filter_centers[i + 2]);
+			else
+				filterBank[(i * blockSize) + j] = 0;
+		}
+	}
+	
+	for (unsigned int i = 0; i < filters; i++) {
+		filterStart[i] = 0;
+		filterEnd[i] = 0;
+		
+		for (unsigned int j = 0; j < blockSize; j++) {
+			if (filterBank[(i * blockSize) + j] != 0) {
+				if (filterEnd[i] == 0)
+					filterStart[i] = j;
+				
+				filterEnd[i] = j + 1;
+			}
+		}
+	}
+	
+	for (unsigned int i = 0; i < mels; i++)
+		mfccOld[i] = 0;
+
+	delete[] filter_values;
+	delete[] filter_centers;
+}
+
+TransientIndex::Tables::~Tables() {
+	delete[] dctMatrix;
+	delete[] filterBank;
+	delete[] mfccOld;
+	delete[] filterStart;
+	delete[] filterEnd;
+	delete[] batchFilters;
+	delete[] batchMfcc;
+	delete[] batchSilent;
+	delete[] batchZero;
 }
 
 float TransientIndex::hz_to_mel(float hz) {
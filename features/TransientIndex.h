@@ -4,7 +4,11 @@
 #include <vamp-sdk/Plugin.h>
 using std::string;
 
-class TransientIndex : public Vamp::Plugin {
+#include "../support/BatchProcessor.h"
+#include "../support/SilenceGate.h"
+#include "../support/RealtimeConfiguration.h"
+
+class TransientIndex : public Vamp::Plugin, public BatchProcessor {
 public:
 	TransientIndex(float inputSampleRate);
 	virtual ~TransientIndex();
@@ -35,22 +39,53 @@ public:
 	
 	FeatureSet getRemainingFeatures();
 	
+	// Transient index for count consecutive spectra, stored one after another (count * blockSize values), into output
+	// (see BatchProcessor.) Equivalent to calling process() on each in turn, but the filterbank is applied to several
+	// frames at a time. Frames below the silence gate's threshold give zero and reset the MFCC state.
+	size_t getBatchOutputCount() const;
+	void processBatch(const float* spectra, unsigned int count, float* output);
+	
 protected:
-	void freeMemory();
-	void resetFilterBank();
-	float hz_to_mel(float hz);
-	float mel_to_hz(float mel);
+	// Frames handled together by processBatch.
+	static const unsigned int BatchTile = 16;
+	
+	// Filterbank, DCT matrix and working buffers for one choice of filters and mels. setParameter builds a new set
+	// off the processing thread and process() swaps it in at the start of a block, so changing the number of filters
+	// or mels never allocates or frees on the processing thread.
+	struct Tables {
+		unsigned int filters, mels;
+		size_t blockSize;
+		
+		float* mfccOld;
+		float* dctMatrix;
+		float* filterBank;
+		
+		// Range of bins in which each (triangular) filter is nonzero.
+		unsigned int* filterStart;
+		unsigned int* filterEnd;
+		
+		// Log filterbank energies and MFCCs for a tile of frames in processBatch.
+		float* batchFilters;
+		float* batchMfcc;
+		bool* batchSilent;	// Below the silence gate, or all zero.
+		bool* batchZero;
+		
+		Tables(unsigned int filters, unsigned int mels, size_t blockSize, float sampleRate);
+		~Tables();
+	};
+	
+	static float hz_to_mel(float hz);
+	static float mel_to_hz(float mel);
 	
 	size_t m_blockSize;
 	float m_sampleRate;
 	
+	// Parameter values, as last set. The processing thread reads the copies in tables.
 	unsigned int mels, filters;
 	
-	float* mfccOld;
-	float* mfccNew;
-	float* dctMatrix;
-	float* filterTemp;
-	float* filterBank;
+	RealtimeConfiguration<Tables> tables;
+	
+	SilenceGate gate;
 };
 
 #endif
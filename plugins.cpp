@@ -7,6 +7,8 @@
 #include "features/SpectralCentroid.h"
 #include "features/TransientIndex.h"
 #include "features/Harmonicity.h"
+#include "features/SpectralShape.h"
+#include "features/HarmonicityDecimated.h"
 
 // Declare one static adapter here for each plugin class in this library.
 static Vamp::PluginAdapter<Loudness> loudnessAdapter;
@@ -15,6 +17,8 @@ static Vamp::PluginAdapter<SpectralSparsity> spectralSparsityAdapter;
 static Vamp::PluginAdapter<SpectralCentroid> spectralCentroidAdapter;
 static Vamp::PluginAdapter<TransientIndex> transientIndexAdapter;
 static Vamp::PluginAdapter<Harmonicity> harmonicityAdapter;
+static Vamp::PluginAdapter<SpectralShape> spectralShapeAdapter;
+static Vamp::PluginAdapter<HarmonicityDecimated> harmonicityDecimatedAdapter;
 
 // This is the entry-point for the library, and the only function that needs to be publicly exported.
 const VampPluginDescriptor* vampGetPluginDescriptor(unsigned int version, unsigned int index) {
@@ -27,6 +31,8 @@ const VampPluginDescriptor* vampGetPluginDescriptor(unsigned int version, unsign
 		case 3: return spectralCentroidAdapter.getDescriptor();
 		case 4: return transientIndexAdapter.getDescriptor();
 		case 5: return harmonicityAdapter.getDescriptor();
+		case 6: return spectralShapeAdapter.getDescriptor();
+		case 7: return harmonicityDecimatedAdapter.getDescriptor();
     	default: return 0;
     }
 }
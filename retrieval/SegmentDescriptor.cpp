@@ -0,0 +1,47 @@
+/*
+	Copyright 2009 Arizona State University
+	
+	This file is part of Sirens.
+	
+	Sirens is free software: you can redistribute it and/or modify it under the terms 
+	of the GNU Lesser General Public License as  published by the Free Software 
+	Foundation, either version 3 of the License, or (at your option) any later version.
+	
+	Sirens is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+	without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR 
+	PURPOSE.  See the GNU General Public License for more details.
+	
+	You should have received a copy of the GNU Lesser General Public License along
+	with Sirens. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "SegmentDescriptor.h"
+
+namespace Sirens {
+	int SegmentDescriptor::getDimensions(int features) {
+		return ValuesPerFeature * features;
+	}
+	
+	void SegmentDescriptor::compute(FeatureSet* feature_set, int start, int end, float* descriptor) {
+		const vector<Feature*>& features = feature_set->getFeatures();
+		
+		for (int i = 0; i < int(features.size()); i++) {
+			FeatureSpan span = features[i]->getNormalizedHistory(start, end - start + 1);
+			TrajectoryStatistics statistics;
+			
+			for (int j = 0; j < span.size; j++)
+				statistics.addValue(span[j]);
+			
+			statistics.getValues(descriptor + ValuesPerFeature * i);
+		}
+	}
+	
+	SegmentDescriptorStream::SegmentDescriptorStream() {
+		features = 0;
+		openCount = 0;
+	}
+	
+	int SegmentDescriptorStream::getCapacity() {
+		return segments.size();
+	}
+}
@@ -0,0 +1,128 @@
+/*
+	Copyright 2009 Arizona State University
+	
+	This file is part of Sirens.
+	
+	Sirens is free software: you can redistribute it and/or modify it under the terms 
+	of the GNU Lesser General Public License as  published by the Free Software 
+	Foundation, either version 3 of the License, or (at your option) any later version.
+	
+	Sirens is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+	without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR 
+	PURPOSE.  See the GNU General Public License for more details.
+	
+	You should have received a copy of the GNU Lesser General Public License along
+	with Sirens. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef __SEGMENTDESCRIPTOR_H__
+#define __SEGMENTDESCRIPTOR_H__
+
+#include "../FeatureSet.h"
+#include "TrajectoryStatistics.h"
+
+#include <algorithm>
+#include <vector>
+using namespace std;
+
+namespace Sirens {
+	/*
+		Compact summary of a segment's feature trajectories, for indexing (see SoundIndex.)
+		
+		For each feature, in the order of the feature set, the descriptor holds the TrajectoryStatistics of the
+		segment's normalized values: mean, variance, minimum, maximum, slope, and curvature. A segment of any length is
+		described by 6 values per feature.
+	*/
+	class SegmentDescriptor {
+	public:
+		static const int ValuesPerFeature = TrajectoryStatistics::Values;
+		
+		static int getDimensions(int features);
+		
+		// Describe frames start to end (inclusive, as in Segmenter::getSegments) into descriptor, which must hold
+		// getDimensions(feature count) values.
+		static void compute(FeatureSet* feature_set, int start, int end, float* descriptor);
+	};
+	
+	/*
+		Descriptors for every segment of a mode sequence, in one pass over the feature columns.
+		
+		Frames are read in order and added to the statistics of every segment that is open at that frame, and
+		segments are finished when they end (see SegmentIterator for where that is.) Only open segments are kept, so
+		memory is proportional to the number of overlapping segments rather than the number of frames, and the
+		statistics of closed segments are reused. Results are the same as SegmentDescriptor::compute for each segment
+		of Segmenter::getSegments, in the same order.
+	*/
+	class SegmentDescriptorStream {
+	private:
+		struct OpenSegment {
+			int start;
+			vector<TrajectoryStatistics> statistics;
+		};
+		
+		int features;
+		vector<OpenSegment> segments;	// Open segments first, then spare ones.
+		int openCount;
+		vector<float> descriptor;
+		vector<FeatureSpan> columns;	// The feature set's normalized columns.
+		
+	public:
+		SegmentDescriptorStream();
+		
+		// Describe the segments of modes (as from Segmenter::getModes) over the feature set's normalized columns,
+		// calling callback(start, end, descriptor) for each. The descriptor is only valid during the call.
+		template <typename Callback>
+		void describe(FeatureSet* feature_set, const vector<int>& modes, Callback callback);
+		
+		// Most segments that have been open at once, which is how many sets of statistics the stream holds.
+		int getCapacity();
+	};
+	
+	template <typename Callback>
+	void SegmentDescriptorStream::describe(FeatureSet* feature_set, const vector<int>& modes, Callback callback) {
+		const vector<Feature*>& feature_list = feature_set->getFeatures();
+		int frames = min(int(modes.size()), feature_set->getMinHistorySize());
+		
+		features = feature_list.size();
+		openCount = 0;
+		descriptor.resize(SegmentDescriptor::getDimensions(features));
+		columns.resize(features);
+		
+		for (int i = 0; i < features; i++)
+			columns[i] = feature_list[i]->getNormalizedHistory(0, frames);
+		
+		for (int frame = 0; frame < frames; frame++) {
+			// Onsets (or an ON first frame) open a segment, unless they are in the last frame.
+			if (frame < frames - 1 && (modes[frame] == 2 || (frame == 0 && modes[frame] == 3))) {
+				if (openCount == segments.size())
+					segments.push_back(OpenSegment());
+				
+				OpenSegment& segment = segments[openCount++];
+				segment.start = frame;
+				segment.statistics.resize(features);
+				
+				for (int i = 0; i < features; i++)
+					segment.statistics[i].clear();
+			}
+			
+			for (int s = 0; s < openCount; s++) {
+				for (int i = 0; i < features; i++)
+					segments[s].statistics[i].addValue(columns[i][frame]);
+			}
+			
+			// Every open segment ends at the next OFF frame, or the last frame.
+			if (modes[frame] == 1 || frame == frames - 1) {
+				for (int s = 0; s < openCount; s++) {
+					for (int i = 0; i < features; i++)
+						segments[s].statistics[i].getValues(&descriptor[i * SegmentDescriptor::ValuesPerFeature]);
+					
+					callback(segments[s].start, frame, (const float*) &descriptor[0]);
+				}
+				
+				openCount = 0;
+			}
+		}
+	}
+}
+
+#endif
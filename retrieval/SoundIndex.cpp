@@ -0,0 +1,349 @@
+/*
+	Copyright 2009 Arizona State University
+	
+	This file is part of Sirens.
+	
+	Sirens is free software: you can redistribute it and/or modify it under the terms 
+	of the GNU Lesser General Public License as  published by the Free Software 
+	Foundation, either version 3 of the License, or (at your option) any later version.
+	
+	Sirens is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+	without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR 
+	PURPOSE.  See the GNU General Public License for more details.
+	
+	You should have received a copy of the GNU Lesser General Public License along
+	with Sirens. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "SoundIndex.h"
+#include "../support/Instrumentation.h"
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <limits>
+#include <random>
+#include <thread>
+using namespace std;
+
+namespace Sirens {
+	// Split count items into one contiguous range per thread and run work(thread, begin, end) on each, using the calling
+	// thread for the first range.
+	static void runParallel(int threads, int count, const function<void(int, int, int)>& work) {
+		threads = max(1, min(threads, count));
+		
+		vector<thread> workers;
+		
+		for (int i = 1; i < threads; i++)
+			workers.push_back(thread(work, i, (long long) count * i / threads, (long long) count * (i + 1) / threads));
+		
+		work(0, 0, count / threads);
+		
+		for (int i = 0; i < int(workers.size()); i++)
+			workers[i].join();
+	}
+	
+	static float getSquaredDistance(const float* a, const float* b, int dimensions) {
+		float sum = 0;
+		
+		for (int i = 0; i < dimensions; i++) {
+			float difference = a[i] - b[i];
+			sum += difference * difference;
+		}
+		
+		return sum;
+	}
+	
+	static bool CompareMatches(const SoundMatch& match1, const SoundMatch& match2) {
+		return match1.distance < match2.distance;
+	}
+	
+	SoundIndex::SoundIndex(int dimensions) {
+		this->dimensions = dimensions;
+		threadCount = 0;
+	}
+	
+	int SoundIndex::addDescriptor(const float* descriptor) {
+		added.insert(added.end(), descriptor, descriptor + dimensions);
+		return added.size() / dimensions - 1;
+	}
+	
+	void SoundIndex::normalize(const float* descriptor, float* normalized) const {
+		for (int i = 0; i < dimensions; i++)
+			normalized[i] = (descriptor[i] - offset[i]) * scale[i];
+	}
+	
+	int SoundIndex::getNearestCentroid(const float* descriptor, float& squared_distance) const {
+		int nearest = 0;
+		squared_distance = numeric_limits<float>::infinity();
+		
+		for (int i = 0; i < int(radii.size()); i++) {
+			float distance = getSquaredDistance(descriptor, &centroids[i * dimensions], dimensions);
+			
+			if (distance < squared_distance) {
+				squared_distance = distance;
+				nearest = i;
+			}
+		}
+		
+		return nearest;
+	}
+	
+	int SoundIndex::getThreads() const {
+		if (threadCount > 0)
+			return threadCount;
+		
+		int hardware_threads = thread::hardware_concurrency();
+		return hardware_threads > 0 ? hardware_threads : 1;
+	}
+	
+	/*-----------*
+	 * Building. *
+	 *-----------*/
+	
+	void SoundIndex::build(int clusters, int iterations) {
+		SIRENS_TIME_SCOPE("SoundIndex::build", added.size() * sizeof(float));
+		
+		int size = added.size() / dimensions;
+		int threads = getThreads();
+		
+		descriptors.assign(added.size(), 0);
+		ids.assign(size, 0);
+		offset.assign(dimensions, 0);
+		scale.assign(dimensions, 1);
+		centroids.clear();
+		radii.clear();
+		clusterStarts.assign(1, 0);
+		
+		if (size == 0)
+			return;
+		
+		// Normalize every dimension to zero mean and unit variance.
+		for (int i = 0; i < dimensions; i++) {
+			double sum = 0;
+			double sum_of_squares = 0;
+			
+			for (int j = 0; j < size; j++) {
+				sum += added[j * dimensions + i];
+				sum_of_squares += added[j * dimensions + i] * added[j * dimensions + i];
+			}
+			
+			double mean = sum / size;
+			double variance = sum_of_squares / size - mean * mean;
+			
+			offset[i] = mean;
+			scale[i] = variance > 1e-12 ? 1 / sqrt(variance) : 1;
+		}
+		
+		vector<float> normalized(added.size());
+		
+		runParallel(threads, size, [&](int thread_index, int begin, int end) {
+			for (int j = begin; j < end; j++)
+				normalize(&added[j * dimensions], &normalized[j * dimensions]);
+		});
+		
+		clusters = clusters > 0 ? clusters : int(sqrt(double(size)));
+		clusters = max(1, min(clusters, size));
+		
+		// Train on a random sample, starting from its first descriptors.
+		int samples = min(size, clusters * TrainingSamples);
+		vector<int> sample(size);
+		
+		for (int j = 0; j < size; j++)
+			sample[j] = j;
+		
+		mt19937 generator(0);
+		
+		for (int j = 0; j < samples; j++)
+			swap(sample[j], sample[j + generator() % (size - j)]);
+		
+		centroids.resize(clusters * dimensions);
+		radii.resize(clusters);
+		
+		for (int i = 0; i < clusters; i++)
+			copy(&normalized[sample[i] * dimensions], &normalized[sample[i] * dimensions] + dimensions, &centroids[i * dimensions]);
+		
+		int training_threads = max(1, min(threads, samples / 1024));
+		vector<vector<double> > sums(training_threads, vector<double>(clusters * dimensions));
+		vector<vector<int> > counts(training_threads, vector<int>(clusters));
+		
+		for (int iteration = 0; iteration < iterations; iteration++) {
+			runParallel(training_threads, samples, [&](int thread_index, int begin, int end) {
+				vector<double>& thread_sums = sums[thread_index];
+				vector<int>& thread_counts = counts[thread_index];
+				
+				fill(thread_sums.begin(), thread_sums.end(), 0);
+				fill(thread_counts.begin(), thread_counts.end(), 0);
+				
+				for (int j = begin; j < end; j++) {
+					const float* descriptor = &normalized[sample[j] * dimensions];
+					float distance;
+					int cluster = getNearestCentroid(descriptor, distance);
+					
+					for (int i = 0; i < dimensions; i++)
+						thread_sums[cluster * dimensions + i] += descriptor[i];
+					
+					thread_counts[cluster] ++;
+				}
+			});
+			
+			// Move each centroid to the mean of its members. Clusters left empty keep their centroid.
+			for (int cluster = 0; cluster < clusters; cluster++) {
+				int count = 0;
+				
+				for (int t = 0; t < training_threads; t++)
+					count += counts[t][cluster];
+				
+				if (count == 0)
+					continue;
+				
+				for (int i = 0; i < dimensions; i++) {
+					double sum = 0;
+					
+					for (int t = 0; t < training_threads; t++)
+						sum += sums[t][cluster * dimensions + i];
+					
+					centroids[cluster * dimensions + i] = sum / count;
+				}
+			}
+		}
+		
+		// Assign everything to its nearest centroid, and find each cluster's radius.
+		vector<int> assignments(size);
+		vector<vector<float> > thread_radii(threads, vector<float>(clusters, 0));
+		
+		runParallel(threads, size, [&](int thread_index, int begin, int end) {
+			vector<float>& cluster_radii = thread_radii[thread_index];
+			
+			for (int j = begin; j < end; j++) {
+				float distance;
+				assignments[j] = getNearestCentroid(&normalized[j * dimensions], distance);
+				cluster_radii[assignments[j]] = max(cluster_radii[assignments[j]], distance);
+			}
+		});
+		
+		for (int cluster = 0; cluster < clusters; cluster++) {
+			float radius = 0;
+			
+			for (int t = 0; t < threads; t++)
+				radius = max(radius, thread_radii[t][cluster]);
+			
+			// Rounded up slightly, so that rounding in the query's distances can't make the bound prune a true match.
+			radii[cluster] = sqrt(radius) * 1.0001f + 1e-6f;
+		}
+		
+		// Group descriptors by cluster.
+		clusterStarts.assign(clusters + 1, 0);
+		
+		for (int j = 0; j < size; j++)
+			clusterStarts[assignments[j] + 1] ++;
+		
+		for (int cluster = 0; cluster < clusters; cluster++)
+			clusterStarts[cluster + 1] += clusterStarts[cluster];
+		
+		vector<int> positions(clusterStarts.begin(), clusterStarts.end() - 1);
+		
+		for (int j = 0; j < size; j++) {
+			int row = positions[assignments[j]]++;
+			
+			ids[row] = j;
+			copy(&normalized[j * dimensions], &normalized[j * dimensions] + dimensions, &descriptors[row * dimensions]);
+		}
+	}
+	
+	/*----------*
+	 * Queries. *
+	 *----------*/
+	
+	int SoundIndex::query(const float* descriptor, int k, vector<SoundMatch>& matches) const {
+		matches.clear();
+		
+		int clusters = radii.size();
+		
+		if (clusters == 0 || k <= 0)
+			return 0;
+		
+		vector<float> normalized(dimensions);
+		normalize(descriptor, &normalized[0]);
+		
+		// Lower bound on the distance to any member of each cluster.
+		vector<pair<float, int> > bounds(clusters);
+		
+		for (int cluster = 0; cluster < clusters; cluster++) {
+			float distance = sqrt(getSquaredDistance(&normalized[0], &centroids[cluster * dimensions], dimensions));
+			bounds[cluster] = make_pair(max(0.0f, distance - radii[cluster]), cluster);
+		}
+		
+		sort(bounds.begin(), bounds.end());
+		
+		// Matches are kept as a max-heap on squared distance until the end.
+		int comparisons = 0;
+		matches.reserve(k);
+		
+		for (int b = 0; b < clusters; b++) {
+			if (int(matches.size()) == k && bounds[b].first * bounds[b].first >= matches.front().distance)
+				break;
+			
+			int cluster = bounds[b].second;
+			
+			for (int row = clusterStarts[cluster]; row < clusterStarts[cluster + 1]; row++) {
+				SoundMatch match;
+				match.id = ids[row];
+				match.distance = getSquaredDistance(&normalized[0], &descriptors[row * dimensions], dimensions);
+				
+				if (int(matches.size()) < k) {
+					matches.push_back(match);
+					push_heap(matches.begin(), matches.end(), CompareMatches);
+				} else if (match.distance < matches.front().distance) {
+					pop_heap(matches.begin(), matches.end(), CompareMatches);
+					matches.back() = match;
+					push_heap(matches.begin(), matches.end(), CompareMatches);
+				}
+			}
+			
+			comparisons += clusterStarts[cluster + 1] - clusterStarts[cluster];
+		}
+		
+		sort_heap(matches.begin(), matches.end(), CompareMatches);
+		
+		for (int i = 0; i < int(matches.size()); i++)
+			matches[i].distance = sqrt(matches[i].distance);
+		
+		return comparisons;
+	}
+	
+	void SoundIndex::query(const float* queries, int count, int k, vector<vector<SoundMatch> >& matches) const {
+		SIRENS_TIME_SCOPE("SoundIndex::query", (unsigned long long) count * dimensions * sizeof(float));
+		
+		matches.resize(count);
+		
+		runParallel(getThreads(), count, [&](int thread_index, int begin, int end) {
+			for (int i = begin; i < end; i++)
+				query(queries + (long long) i * dimensions, k, matches[i]);
+		});
+	}
+	
+	/*-------------*
+	 * Attributes. *
+	 *-------------*/
+	
+	void SoundIndex::setThreadCount(int value) {
+		threadCount = value;
+	}
+	
+	int SoundIndex::getThreadCount() {
+		return threadCount;
+	}
+	
+	int SoundIndex::getDimensions() {
+		return dimensions;
+	}
+	
+	int SoundIndex::getSize() {
+		return ids.size();
+	}
+	
+	int SoundIndex::getClusterCount() {
+		return radii.size();
+	}
+}
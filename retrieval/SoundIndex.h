@@ -0,0 +1,102 @@
+/*
+	Copyright 2009 Arizona State University
+	
+	This file is part of Sirens.
+	
+	Sirens is free software: you can redistribute it and/or modify it under the terms 
+	of the GNU Lesser General Public License as  published by the Free Software 
+	Foundation, either version 3 of the License, or (at your option) any later version.
+	
+	Sirens is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+	without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR 
+	PURPOSE.  See the GNU General Public License for more details.
+	
+	You should have received a copy of the GNU Lesser General Public License along
+	with Sirens. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef __SOUNDINDEX_H__
+#define __SOUNDINDEX_H__
+
+#include <vector>
+using namespace std;
+
+/*
+	Query-by-example over segment descriptors (see SegmentDescriptor.)
+	
+	Descriptors are normalized per dimension (zero mean, unit variance over the whole collection) and clustered with
+	k-means. Each cluster keeps its centroid and its radius, the largest distance from the centroid to one of its
+	members, and its members are stored contiguously. A query visits clusters in order of the triangle-inequality
+	bound |query - centroid| - radius on the distance to any of their members, and stops as soon as that bound is no
+	closer than the k-th best match so far. Results are exactly the k nearest descriptors, but only the clusters near
+	the query are scanned.
+	
+	Building and batch queries are split over threads. Clusters are trained on a sample of at most TrainingSamples
+	descriptors per cluster, so building costs a few passes over the sample plus one assignment pass over everything.
+	
+	Based on the cluster-based indexing of:
+	J. Xue, G. Wichern, H. Thornburg, and A. Spanias, "Fast query-by-example of environmental sounds via robust and
+	efficient cluster-based indexing," in Proc. of IEEE International Conference on Acoustics Speech and Signal
+	Processing (ICASSP), Las Vegas, NV, April 2008.
+*/
+
+namespace Sirens {
+	struct SoundMatch {
+		int id;				// Index of the descriptor, in the order descriptors were added.
+		float distance;		// Euclidean distance between the normalized descriptors.
+	};
+	
+	class SoundIndex {
+	private:
+		int dimensions;
+		int threadCount;
+		
+		// Descriptors as added, kept so the index can be rebuilt.
+		vector<float> added;
+		
+		// Normalization: (value - offset) * scale, per dimension.
+		vector<float> offset;
+		vector<float> scale;
+		
+		// Built index. Normalized descriptors and their ids are grouped by cluster; cluster i holds rows
+		// clusterStarts[i] to clusterStarts[i + 1] - 1.
+		vector<float> descriptors;
+		vector<int> ids;
+		vector<int> clusterStarts;
+		vector<float> centroids;
+		vector<float> radii;
+		
+		void normalize(const float* descriptor, float* normalized) const;
+		int getNearestCentroid(const float* descriptor, float& squared_distance) const;
+		int getThreads() const;
+		
+	public:
+		static const int TrainingSamples = 64;
+		static const int Iterations = 10;
+		
+		SoundIndex(int dimensions);
+		
+		// Add a descriptor of getDimensions() values, returning its id. It can be found after the next build().
+		int addDescriptor(const float* descriptor);
+		
+		// Cluster everything added so far. With clusters = 0, the number of clusters is the square root of the number of
+		// descriptors.
+		void build(int clusters = 0, int iterations = Iterations);
+		
+		// The k nearest descriptors to a descriptor, nearest first. Returns how many descriptors were compared.
+		int query(const float* descriptor, int k, vector<SoundMatch>& matches) const;
+		
+		// The k nearest descriptors for each of count descriptors, stored one after another, split over threads.
+		void query(const float* queries, int count, int k, vector<vector<SoundMatch> >& matches) const;
+		
+		// Threads for build() and batch queries (0, the default, for one per hardware thread.)
+		void setThreadCount(int value);
+		int getThreadCount();
+		
+		int getDimensions();
+		int getSize();			// Descriptors in the built index.
+		int getClusterCount();
+	};
+}
+
+#endif
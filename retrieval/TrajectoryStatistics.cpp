@@ -0,0 +1,58 @@
+/*
+	Copyright 2009 Arizona State University
+	
+	This file is part of Sirens.
+	
+	Sirens is free software: you can redistribute it and/or modify it under the terms 
+	of the GNU Lesser General Public License as  published by the Free Software 
+	Foundation, either version 3 of the License, or (at your option) any later version.
+	
+	Sirens is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+	without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR 
+	PURPOSE.  See the GNU General Public License for more details.
+	
+	You should have received a copy of the GNU Lesser General Public License along
+	with Sirens. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "TrajectoryStatistics.h"
+
+namespace Sirens {
+	void TrajectoryStatistics::clear() {
+		count = 0;
+		mean = 0;
+		deviation = 0;
+		minimum = 0;
+		maximum = 0;
+		sum = 0;
+		sumT = 0;
+		sumT2 = 0;
+	}
+	
+	// sum(x * P1) / sum(P1^2), with P1 = t - c and sum(P1^2) = (n^3 - n) / 12.
+	double TrajectoryStatistics::getSlope() const {
+		double n = count;
+		double c = (n - 1) / 2;
+		double norm = (n * n * n - n) / 12;
+		
+		return norm > 0 ? (sumT - c * sum) / norm : 0;
+	}
+	
+	// sum(x * P2) / sum(P2^2), with P2 = (t - c)^2 - (n^2 - 1) / 12 and sum(P2^2) = n (n^2 - 1) (n^2 - 4) / 180.
+	double TrajectoryStatistics::getCurvature() const {
+		double n = count;
+		double c = (n - 1) / 2;
+		double norm = n * (n * n - 1) * (n * n - 4) / 180;
+		
+		return norm > 0 ? (sumT2 - 2 * c * sumT + (c * c - (n * n - 1) / 12) * sum) / norm : 0;
+	}
+	
+	void TrajectoryStatistics::getValues(float* values) const {
+		values[0] = getMean();
+		values[1] = getVariance();
+		values[2] = getMinimum();
+		values[3] = getMaximum();
+		values[4] = getSlope();
+		values[5] = getCurvature();
+	}
+}
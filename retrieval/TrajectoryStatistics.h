@@ -0,0 +1,83 @@
+/*
+	Copyright 2009 Arizona State University
+	
+	This file is part of Sirens.
+	
+	Sirens is free software: you can redistribute it and/or modify it under the terms 
+	of the GNU Lesser General Public License as  published by the Free Software 
+	Foundation, either version 3 of the License, or (at your option) any later version.
+	
+	Sirens is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+	without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR 
+	PURPOSE.  See the GNU General Public License for more details.
+	
+	You should have received a copy of the GNU Lesser General Public License along
+	with Sirens. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef __TRAJECTORYSTATISTICS_H__
+#define __TRAJECTORYSTATISTICS_H__
+
+namespace Sirens {
+	/*
+		Summary of a feature trajectory, accumulated one frame at a time in constant memory.
+		
+		Besides the mean, variance, and range, the trajectory is fit with a quadratic in the orthogonal (discrete
+		Legendre) basis 1, t - c, and (t - c)^2 - (n^2 - 1) / 12, where t is the frame within the trajectory and
+		c = (n - 1) / 2 its middle. The linear coefficient is the least-squares slope per frame, and the quadratic
+		coefficient the curvature; being orthogonal, neither changes the other. Both come from running sums of x,
+		x * t, and x * t^2, so frames never need to be kept.
+	*/
+	class TrajectoryStatistics {
+	private:
+		int count;
+		double mean;		// Running mean and sum of squared deviations (Welford.)
+		double deviation;
+		float minimum;
+		float maximum;
+		double sum;			// sum(x), sum(x * t), sum(x * t^2), with t counted from 0.
+		double sumT;
+		double sumT2;
+		
+	public:
+		static const int Values = 6;
+		
+		TrajectoryStatistics() {
+			clear();
+		}
+		
+		void clear();
+		
+		void addValue(float value) {
+			double t = count;
+			double delta = value - mean;
+			
+			count ++;
+			mean += delta / count;
+			deviation += delta * (value - mean);
+			
+			if (count == 1 || value < minimum)
+				minimum = value;
+			
+			if (count == 1 || value > maximum)
+				maximum = value;
+			
+			sum += value;
+			sumT += value * t;
+			sumT2 += value * t * t;
+		}
+		
+		int getCount() const { return count; }
+		double getMean() const { return mean; }
+		double getVariance() const { return count > 0 ? deviation / count : 0; }
+		float getMinimum() const { return minimum; }
+		float getMaximum() const { return maximum; }
+		double getSlope() const;
+		double getCurvature() const;
+		
+		// Mean, variance, minimum, maximum, slope, and curvature, in that order.
+		void getValues(float* values) const;
+	};
+}
+
+#endif
@@ -0,0 +1,332 @@
+/*
+	Copyright 2009 Arizona State University
+	
+	This file is part of Sirens.
+	
+	Sirens is free software: you can redistribute it and/or modify it under the terms 
+	of the GNU Lesser General Public License as  published by the Free Software 
+	Foundation, either version 3 of the License, or (at your option) any later version.
+	
+	Sirens is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+	without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR 
+	PURPOSE.  See the GNU General Public License for more details.
+	
+	You should have received a copy of the GNU Lesser General Public License along
+	with Sirens. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "ParameterSweep.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <random>
+#include <sstream>
+using namespace std;
+
+namespace Sirens {
+	/*-------*
+	 * Axes. *
+	 *-------*/
+	
+	int SweepAxis::getGridSize() {
+		return kind == Values ? values.size() : count;
+	}
+	
+	double SweepAxis::getGridValue(int i) {
+		if (kind == Values)
+			return values[i];
+		
+		double t = count > 1 ? double(i) / (count - 1) : 0;
+		
+		if (kind == Linear)
+			return values[0] + (values[1] - values[0]) * t;
+		else
+			return exp(log(values[0]) + (log(values[1]) - log(values[0])) * t);
+	}
+	
+	double SweepAxis::getRandomValue(double u) {
+		if (kind == Values)
+			return values[min(int(u * values.size()), int(values.size()) - 1)];
+		else if (kind == Linear)
+			return values[0] + (values[1] - values[0]) * u;
+		else
+			return exp(log(values[0]) + (log(values[1]) - log(values[0])) * u);
+	}
+	
+	/*-------------------------------*
+	 * Constructors and destructors. *
+	 *-------------------------------*/
+	
+	ParameterSweep::ParameterSweep(double p_new, double p_off) : segmenter(p_new, p_off) {
+		featureSet = NULL;
+		randomCount = 0;
+		seed = 0;
+	}
+	
+	ParameterSweep::~ParameterSweep() {
+	}
+	
+	/*-------------*
+	 * Attributes. *
+	 *-------------*/
+	
+	void ParameterSweep::setFeatureSet(FeatureSet* feature_set) {
+		featureSet = feature_set;
+		features = featureSet->getFeatures();
+		
+		segmenter.setFeatureSet(feature_set);
+	}
+	
+	FeatureSet* ParameterSweep::getFeatureSet() {
+		return featureSet;
+	}
+	
+	SegmenterSweep* ParameterSweep::getSegmenter() {
+		return &segmenter;
+	}
+	
+	/*-------*
+	 * Spec. *
+	 *-------*/
+	
+	// -1 for "*", otherwise the feature with this name or index, or -2 if there is none.
+	int ParameterSweep::getFeatureIndex(const string& name) {
+		if (name == "*")
+			return -1;
+		
+		for (int i = 0; i < int(features.size()); i++) {
+			if (features[i]->getName() == name)
+				return i;
+		}
+		
+		char* end;
+		long index = strtol(name.c_str(), &end, 10);
+		
+		if (!name.empty() && *end == '\0' && index >= 0 && index < long(features.size()))
+			return index;
+		
+		return -2;
+	}
+	
+	bool ParameterSweep::parseLine(const string& line) {
+		istringstream stream(line.substr(0, line.find('#')));
+		string first;
+		
+		if (!(stream >> first))
+			return true;
+		
+		if (first == "random") {
+			randomCount = 0;
+			seed = 0;
+			
+			if (!(stream >> randomCount) || randomCount <= 0)
+				return false;
+			
+			stream >> seed;
+			return true;
+		}
+		
+		string parameter, kind;
+		
+		if (!(stream >> parameter >> kind))
+			return false;
+		
+		SweepAxis axis;
+		axis.feature = getFeatureIndex(first);
+		axis.parameter = SegmentationParameters::getParameterIndex(parameter);
+		axis.count = 0;
+		
+		if (axis.feature < -1 || axis.parameter < 0)
+			return false;
+		
+		double value;
+		
+		if (kind == "values") {
+			axis.kind = SweepAxis::Values;
+			
+			while (stream >> value)
+				axis.values.push_back(value);
+			
+			if (axis.values.empty())
+				return false;
+		} else if (kind == "linear" || kind == "log") {
+			axis.kind = kind == "linear" ? SweepAxis::Linear : SweepAxis::Log;
+			axis.values.resize(2);
+			
+			if (!(stream >> axis.values[0] >> axis.values[1] >> axis.count) || axis.count <= 0)
+				return false;
+			
+			if (axis.kind == SweepAxis::Log && (axis.values[0] <= 0 || axis.values[1] <= 0))
+				return false;
+		} else
+			return false;
+		
+		// Anything left over is a mistake, such as a value that isn't a number.
+		string rest;
+		
+		if (stream.clear(), stream >> rest)
+			return false;
+		
+		axes.push_back(axis);
+		return true;
+	}
+	
+	bool ParameterSweep::parse(const string& spec) {
+		axes.clear();
+		randomCount = 0;
+		seed = 0;
+		
+		istringstream stream(spec);
+		string line;
+		
+		while (getline(stream, line)) {
+			if (!parseLine(line)) {
+				axes.clear();
+				randomCount = 0;
+				return false;
+			}
+		}
+		
+		return true;
+	}
+	
+	bool ParameterSweep::load(string file_path) {
+		ifstream file(file_path.c_str());
+		
+		if (!file)
+			return false;
+		
+		stringstream spec;
+		spec << file.rdbuf();
+		
+		return parse(spec.str());
+	}
+	
+	/*----------------*
+	 * Configuration. *
+	 *----------------*/
+	
+	// A configuration with values[a] for axis a. Parameters are copied into fresh objects rather than assigned from the
+	// features', so that initialize() builds the fusion logic and Q table from the swept values.
+	void ParameterSweep::addConfiguration(const vector<double>& values) {
+		vector<SegmentationParameters> configuration(features.size());
+		
+		for (int f = 0; f < int(features.size()); f++) {
+			SegmentationParameters* source = features[f]->getSegmentationParameters();
+			
+			for (int p = 0; p < SegmentationParameters::ParameterCount; p++)
+				configuration[f].setParameter(p, source->getParameter(p));
+			
+			for (int a = 0; a < 2; a++) {
+				configuration[f].xInit[a] = source->xInit[a];
+				
+				for (int b = 0; b < 2; b++)
+					configuration[f].pInit[a][b] = source->pInit[a][b];
+			}
+		}
+		
+		string description;
+		
+		for (int a = 0; a < int(axes.size()); a++) {
+			for (int f = 0; f < int(features.size()); f++) {
+				if (axes[a].feature == -1 || axes[a].feature == f)
+					configuration[f].setParameter(axes[a].parameter, values[a]);
+			}
+			
+			char value[64];
+			snprintf(value, sizeof(value), "%g", values[a]);
+			
+			if (a > 0)
+				description += ";";
+			
+			description += axes[a].feature == -1 ? string("*") : features[axes[a].feature]->getName();
+			description += string(".") + SegmentationParameters::getParameterName(axes[a].parameter) + "=" + value;
+		}
+		
+		configurations.push_back(configuration);
+		descriptions.push_back(description);
+	}
+	
+	void ParameterSweep::run() {
+		configurations.clear();
+		descriptions.clear();
+		
+		if (featureSet == NULL)
+			return;
+		
+		vector<double> values(axes.size());
+		
+		if (randomCount > 0) {
+			mt19937 generator(seed);
+			uniform_real_distribution<double> uniform(0, 1);
+			
+			for (int c = 0; c < randomCount; c++) {
+				for (int a = 0; a < int(axes.size()); a++)
+					values[a] = axes[a].getRandomValue(uniform(generator));
+				
+				addConfiguration(values);
+			}
+		} else {
+			// Count through the grid like an odometer, the last axis changing fastest.
+			vector<int> position(axes.size(), 0);
+			bool done = false;
+			
+			while (!done) {
+				for (int a = 0; a < int(axes.size()); a++)
+					values[a] = axes[a].getGridValue(position[a]);
+				
+				addConfiguration(values);
+				
+				done = true;
+				
+				for (int a = axes.size() - 1; a >= 0 && done; a--) {
+					if (++ position[a] < axes[a].getGridSize())
+						done = false;
+					else
+						position[a] = 0;
+				}
+			}
+		}
+		
+		segmenter.sweep(configurations);
+	}
+	
+	/*----------*
+	 * Results. *
+	 *----------*/
+	
+	int ParameterSweep::getConfigurationCount() {
+		return configurations.size();
+	}
+	
+	const vector<SegmentationParameters>& ParameterSweep::getConfiguration(int c) {
+		return configurations[c];
+	}
+	
+	string ParameterSweep::getDescription(int c) {
+		return descriptions[c];
+	}
+	
+	bool ParameterSweep::write(string file_path) {
+		FILE* file = fopen(file_path.c_str(), "w");
+		
+		if (file == NULL)
+			return false;
+		
+		bool success = true;
+		
+		for (int c = 0; success && c < int(configurations.size()); c++) {
+			success = fprintf(file, "# configuration %d: %s cost %.17g\n", c, descriptions[c].c_str(), segmenter.getPathCost(c)) > 0;
+			
+			SegmentIterator iterator = segmenter.getSegmentIterator(c);
+			int start, end;
+			
+			while (success && iterator.next(start, end))
+				success = fprintf(file, "%d %d\n", start, end) > 0;
+		}
+		
+		return fclose(file) == 0 && success;
+	}
+}
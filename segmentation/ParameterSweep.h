@@ -0,0 +1,120 @@
+/*
+	Copyright 2009 Arizona State University
+	
+	This file is part of Sirens.
+	
+	Sirens is free software: you can redistribute it and/or modify it under the terms 
+	of the GNU Lesser General Public License as  published by the Free Software 
+	Foundation, either version 3 of the License, or (at your option) any later version.
+	
+	Sirens is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+	without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR 
+	PURPOSE.  See the GNU General Public License for more details.
+	
+	You should have received a copy of the GNU Lesser General Public License along
+	with Sirens. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef __PARAMETERSWEEP_H__
+#define __PARAMETERSWEEP_H__
+
+#include "../FeatureSet.h"
+#include "SegmenterSweep.h"
+#include "SegmentationParameters.h"
+
+#include <string>
+#include <vector>
+using namespace std;
+
+/*
+	Grid and random searches over segmentation parameters.
+	
+	A sweep is described by a text spec, one axis per line ('#' starts a comment):
+		
+		<feature> <parameter> values v1 v2 ...		exactly these values
+		<feature> <parameter> linear a b n			n values evenly spaced from a to b
+		<feature> <parameter> log a b n				n values evenly spaced in log from a to b (a, b > 0)
+		random <count> [seed]						sample count configurations instead of the grid
+	
+	<feature> is a feature name (Feature::getName), its index in the feature set, or * for every feature.
+	<parameter> is one of the SegmentationParameters names (see SegmentationParameters::getParameterName.)
+	
+	Without a random line, every combination of the axes' values is run (the product of their sizes.) With one, each
+	configuration draws each axis independently: one of the listed values, uniformly in [a, b] for linear, or
+	log-uniformly in [a, b] for log. Parameters no axis mentions keep the feature's own values, as do xInit and pInit.
+	
+	Every configuration is segmented by one SegmenterSweep, so SweepLanes of them share each pass over the features;
+	too few to fill a group are segmented one at a time instead, which is faster for them. getSegmenter()->setFastMath
+	trades exact results for a faster sweep (see SegmenterSweep.h.)
+	write() produces, for every configuration, a header line and one "start end" line (in frames) per segment:
+		
+		# configuration 3: Loudness.r=0.001;*.alpha=0.05 cost 1523.27
+		12 80
+		95 143
+*/
+
+namespace Sirens {
+	struct SweepAxis {
+		enum Kind {
+			Values,
+			Linear,
+			Log
+		};
+		
+		int feature;			// Index in the feature set, or -1 for every feature.
+		int parameter;			// SegmentationParameters parameter index.
+		Kind kind;
+		vector<double> values;	// The listed values, or the range's endpoints.
+		int count;				// Number of grid points in a range.
+		
+		// Value of grid point i, or the value for a uniform draw u in [0, 1).
+		double getGridValue(int i);
+		double getRandomValue(double u);
+		int getGridSize();
+	};
+	
+	class ParameterSweep {
+	protected:
+		FeatureSet* featureSet;
+		vector<Feature*> features;
+		
+		vector<SweepAxis> axes;
+		int randomCount;		// Zero for a grid search.
+		unsigned int seed;
+		
+		SegmenterSweep segmenter;
+		vector<vector<SegmentationParameters> > configurations;
+		vector<string> descriptions;
+		
+		int getFeatureIndex(const string& name);
+		bool parseLine(const string& line);
+		void addConfiguration(const vector<double>& values);
+	
+	public:
+		ParameterSweep(double p_new = 0, double p_off = 0);
+		~ParameterSweep();
+		
+		// The features to segment. Set before parsing the spec, so feature names can be resolved.
+		void setFeatureSet(FeatureSet* feature_set);
+		FeatureSet* getFeatureSet();
+		
+		SegmenterSweep* getSegmenter();
+		
+		// Read a spec, replacing any previous one. Returns false, with the axes parsed so far discarded, if a line is not
+		// understood.
+		bool parse(const string& spec);
+		bool load(string file_path);
+		
+		// Build the configurations from the spec and segment them all.
+		void run();
+		
+		int getConfigurationCount();
+		const vector<SegmentationParameters>& getConfiguration(int c);
+		string getDescription(int c);		// The swept values of configuration c, as "feature.parameter=value;..."
+		
+		// Write every configuration's segments (see above.)
+		bool write(string file_path);
+	};
+}
+
+#endif
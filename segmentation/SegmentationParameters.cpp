@@ -27,12 +27,31 @@ namespace Sirens {
 		pInit[1][0] = 0;
 		pInit[1][1] = 1;
 		
+		minFeatureValue = 0;
+		maxFeatureValue = 1;
+		
 		initialized = false;
 	}
 	
 	SegmentationParameters::~SegmentationParameters() {
 	}
 
+	void SegmentationParameters::setMinFeatureValue(double value) {
+		minFeatureValue = value;
+	}
+	
+	void SegmentationParameters::setMaxFeatureValue(double value) {
+		maxFeatureValue = value;
+	}
+	
+	double SegmentationParameters::getMinFeatureValue() {
+		return minFeatureValue;
+	}
+	
+	double SegmentationParameters::getMaxFeatureValue() {
+		return maxFeatureValue;
+	}
+	
 	void SegmentationParameters::setPLagPlus(double value) {
 		pLagPlus = value;
 	}
@@ -113,6 +132,59 @@ namespace Sirens {
 		return cNewSegment;
 	}
 	
+	static const char* const ParameterNames[SegmentationParameters::ParameterCount] = {
+		"minFeatureValue", "maxFeatureValue", "pLagPlus", "pLagMinus", "alpha", "r",
+		"cStayOff", "cStayOn", "cTurnOn", "cTurningOn", "cTurnOff", "cNewSegment"
+	};
+	
+	const char* SegmentationParameters::getParameterName(int index) {
+		return index >= 0 && index < ParameterCount ? ParameterNames[index] : NULL;
+	}
+	
+	int SegmentationParameters::getParameterIndex(const string& name) {
+		for (int i = 0; i < ParameterCount; i++) {
+			if (name == ParameterNames[i])
+				return i;
+		}
+		
+		return -1;
+	}
+	
+	double SegmentationParameters::getParameter(int index) {
+		switch (index) {
+			case 0: return minFeatureValue;
+			case 1: return maxFeatureValue;
+			case 2: return pLagPlus;
+			case 3: return pLagMinus;
+			case 4: return alpha;
+			case 5: return r;
+			case 6: return cStayOff;
+			case 7: return cStayOn;
+			case 8: return cTurnOn;
+			case 9: return cTurningOn;
+			case 10: return cTurnOff;
+			case 11: return cNewSegment;
+			default: return 0;
+		}
+	}
+	
+	void SegmentationParameters::setParameter(int index, double value) {
+		switch (index) {
+			case 0: setMinFeatureValue(value); break;
+			case 1: setMaxFeatureValue(value); break;
+			case 2: setPLagPlus(value); break;
+			case 3: setPLagMinus(value); break;
+			case 4: setAlpha(value); break;
+			case 5: setR(value); break;
+			case 6: setCStayOff(value); break;
+			case 7: setCStayOn(value); break;
+			case 8: setCTurnOn(value); break;
+			case 9: setCTurningOn(value); break;
+			case 10: setCTurnOff(value); break;
+			case 11: setCNewSegment(value); break;
+		}
+	}
+	
 	void SegmentationParameters::createFusionLogic() {
 		for (int i = 0; i < 3; i++) {
 			for (int j = 0; j < 3; j++) {
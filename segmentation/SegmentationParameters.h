@@ -18,6 +18,7 @@
 #ifndef __SEGMENTATIONPARAMETERS_H__
 #define __SEGMENTATIONPARAMETERS_H__
 
+#include <string>
 #include <vector>
 using namespace std;
 
@@ -140,6 +141,14 @@ namespace Sirens {
 		double getCTurningOn();
 		double getCNewSegment();
 		
+		// The 12 parameters by number, in the order above (minFeatureValue is 0, cNewSegment 11), for tuning tools
+		// such as ParameterSweep. getParameterIndex returns -1 for a name that is not one of them.
+		static const int ParameterCount = 12;
+		static const char* getParameterName(int index);
+		static int getParameterIndex(const string& name);
+		double getParameter(int index);
+		void setParameter(int index, double value);
+		
 		double xInit[2];
 		double pInit[2][2];
 		double q[3][3];
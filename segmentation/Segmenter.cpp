@@ -16,8 +16,12 @@
 */
 
 #include "Segmenter.h"
+#include "../support/Instrumentation.h"
+#include "../support/Denormals.h"
 
 #include <cmath>
+#include <algorithm>
+#include <limits>
 using namespace std;
 
 namespace Sirens {
@@ -27,6 +31,17 @@ namespace Sirens {
 		
 		featureSet = NULL;
 		initialized = false;
+		stateCount = 0;
+		viterbiFunction = &Segmenter::viterbiKernel<0>;
+		
+		beamWidth = 0;
+		beamThreshold = numeric_limits<double>::infinity();
+		
+		decimation = 1;
+		guardBand = 0;
+		constrained = false;
+		holding = false;
+		refinedFrames = 0;
 	}
 	
 	Segmenter::~Segmenter() {
@@ -38,24 +53,15 @@ namespace Sirens {
 	
 	// How many total states are in the system.
 	int Segmenter::getStateCount() {
-		return pow(3.0, double(features.size() + 1));
+		return stateCount;
 	}
 	
 	// Return all which modes each feature (and global mode) are in for a particular state index.
 	vector<int> Segmenter::getFeatureModes(int state) {
 		vector<int> indices(features.size() + 1, 0);
 		
-		indices[0] = int(ceil(double(state) / double(getStateCount() / 3)));
-		
-		for (int i = 0; i < features.size(); i++) {			
-			int top_index = pow(3.0, double(features.size() - i));
-			int bottom_index = pow(3.0, double(features.size() - i - 1));
-						
-			indices[i + 1] = ceil(double(state % top_index) / double(bottom_index));
-						
-			if (indices[i + 1] == 0)
-				indices[i + 1] = 3;
-		}
+		for (int i = 0; i < int(features.size()) + 1; i++)
+			indices[i] = getSegmenterMode(state, i, features.size());
 	
 		return indices;
 	}
@@ -102,63 +108,408 @@ namespace Sirens {
 	 * Algorithms. *
 	 *-------------*/
 	
-	void Segmenter::viterbi(int frame) {
-		int edges = getStateCount();
+	// Mode lookups come from the compile-time table when the number of features is fixed, or modeMatrix otherwise.
+	template <int N>
+	static inline int getMode(const vector<vector<int> >& mode_matrix, int position, int state) {
+		static constexpr SegmenterModeTable<N> table;
 		
-		// Compute costs for all possible next states.
-		for (int new_index = 0; new_index < edges; new_index++) {
-			for (int old_index = 0; old_index < edges; old_index++) {
-				double cost_temp = 0;
+		return N > 0 ? table.modes[position][state] : mode_matrix[position][state];
+	}
+	
+	// Viterbi for one frame of the columns, writing each state's best previous state to predecessors.
+	void Segmenter::viterbi(const vector<FeatureSpan>& columns, int frame, int* predecessors) {
+		for (int j = 0; j < int(features.size()); j++)
+			y[j] = columns[j].values[frame];
+		
+		(this->*viterbiFunction)(predecessors);
+	}
+	
+	// Viterbi for one frame. N is the number of features, or 0 if it is only known at runtime. When N is fixed, the state
+	// count and feature loop bounds are compile-time constants, so the per-feature loops unroll.
+	template <int N>
+	void Segmenter::viterbiKernel(int* predecessors) {
+		const int feature_count = N > 0 ? N : int(features.size());
+		const int edges = N > 0 ? SegmenterModeTable<N>::states : getStateCount();
+		bool pruning = isPruning();
+		bool sparse = pruning || constrained;	// Whether some previous states may have infinite cost.
+		
+		SIRENS_TIME_SCOPE("Segmenter::viterbi", 0);
+		SIRENS_COUNT("Segmenter::frames", 1);
+		
+		unsigned long long kalman_updates = 0;
+		unsigned long long valid_edges = 0;
+		
+		if (pruning && !holding) {
+			// With beam search, only the live states are expanded.
+			expandBeam<N>(predecessors, kalman_updates, valid_edges);
+		} else {
+			// While refining, only states that follow from a live state are worth evaluating.
+			if (sparse && !holding) {
+				reachable.assign(edges, false);
+				
+				for (int old_index = 0; old_index < edges; old_index++) {
+					if (oldCosts[old_index] < numeric_limits<double>::infinity()) {
+						for (int i = 0; i < int(successors[old_index].size()); i++)
+							reachable[successors[old_index][i]] = true;
+					}
+				}
+			}
+			
+			for (int new_index = 0; new_index < edges; new_index++) {
+				if (holding ? !(oldCosts[new_index] < numeric_limits<double>::infinity()) : sparse && !reachable[new_index]) {
+					if (predecessors != NULL)
+						predecessors[new_index] = 0;
+					
+					newCosts[new_index] = numeric_limits<double>::infinity();
+					continue;
+				}
 				
-				for (int feature_index = 0; feature_index < features.size(); feature_index++) {
+				// While holding, every state follows itself, so no feature changes mode and each needs only one filter.
+				if (holding) {
+					double cost = oldCosts[new_index] - probabilityMatrix[new_index][new_index];
+					
+					for (int feature_index = 0; feature_index < feature_count; feature_index++) {
+						SegmentationParameters* parameters = features[feature_index]->getSegmentationParameters();
+						int mode = getMode<N>(modeMatrix, feature_index + 1, new_index) - 1;
+						ViterbiDistribution& distribution = maxDistributions[feature_index][new_index];
+						
+						distribution.cost = KalmanLPF(
+							y[feature_index],
+							distribution.covariance,
+							distribution.mean,
+							parameters->getR(),
+							parameters->q[mode][mode],
+							parameters->getAlpha()
+						);
+						
+						cost += distribution.cost;
+					}
+					
+					kalman_updates += feature_count;
+					newCosts[new_index] = cost;
+					continue;
+				}
+				
+				// Filter each feature from this state's best distribution, once for every mode the feature could have been in.
+				for (int feature_index = 0; feature_index < feature_count; feature_index++) {
 					SegmentationParameters* parameters = features[feature_index]->getSegmentationParameters();
+					int mode_new = getMode<N>(modeMatrix, feature_index + 1, new_index) - 1;
 					
-					newDistributions[feature_index][new_index][old_index].cost = KalmanLPF(
+					for (int mode_old = 0; mode_old < 3; mode_old++) {
+						ViterbiDistribution& distribution = newDistributions[feature_index][new_index][mode_old];
+						distribution = maxDistributions[feature_index][new_index];
+						
+						distribution.cost = KalmanLPF(
+							y[feature_index],
+							distribution.covariance,
+							distribution.mean,
+							parameters->getR(),
+							parameters->q[mode_old][mode_new],
+							parameters->getAlpha()
+						);
+					}
+				}
+				
+				kalman_updates += 3 * feature_count;
+				
+				// Min-plus over the valid transitions into this state: find the cost of each, keeping only the least.
+				double minimum_cost = numeric_limits<double>::infinity();
+				int minimum_index = 0;
+				
+				const vector<int>& transitions = validTransitions[new_index];
+				
+				for (int i = 0; i < int(transitions.size()); i++) {
+					int old_index = transitions[i];
+					
+					if (sparse && !(oldCosts[old_index] < numeric_limits<double>::infinity()))
+						continue;
+					
+					valid_edges ++;
+					
+					double cost_temp = 0;
+					
+					for (int feature_index = 0; feature_index < feature_count; feature_index++)
+						cost_temp += newDistributions[feature_index][new_index][getMode<N>(modeMatrix, feature_index + 1, old_index) - 1].cost;
+					
+					double cost = oldCosts[old_index] + cost_temp - probabilityMatrix[new_index][old_index];
+					
+					if (cost < minimum_cost) {
+						minimum_cost = cost;
+						minimum_index = old_index;
+					}
+				}
+				
+				predecessors[new_index] = minimum_index;
+				newCosts[new_index] = minimum_cost;
+				
+				// Keep the best filtered distributions as input distributions to the next frame.
+				for (int feature_index = 0; feature_index < feature_count; feature_index++)
+					maxDistributions[feature_index][new_index] = newDistributions[feature_index][new_index][getMode<N>(modeMatrix, feature_index + 1, minimum_index) - 1];
+			}
+		}
+		
+		// Renormalize so that the best state has zero cost.
+		double minimum_cost = *min_element(newCosts.begin(), newCosts.end());
+		
+		if (minimum_cost < numeric_limits<double>::infinity()) {
+			for (int i = 0; i < edges; i++)
+				newCosts[i] -= minimum_cost;
+			
+			costOffset += minimum_cost;
+		}
+		
+		if (pruning)
+			prune();
+		
+		SIRENS_COUNT("Segmenter::kalmanUpdates", kalman_updates);
+		SIRENS_COUNT("Segmenter::validEdges", valid_edges);
+		
+		for (int i = 0; i < edges; i++) {
+			if (newCosts[i] < numeric_limits<double>::infinity())
+				liveStates ++;
+		}
+		
+		oldCosts.swap(newCosts);
+	}
+	
+	// One frame of beam search: each live state runs its features' filters once into each mode a feature can move to, and
+	// every successor of a live state is scored from those, taking over the filters of its best previous state.
+	template <int N>
+	void Segmenter::expandBeam(int* predecessors, unsigned long long& kalman_updates, unsigned long long& valid_edges) {
+		const int feature_count = N > 0 ? N : int(features.size());
+		const int edges = N > 0 ? SegmenterModeTable<N>::states : getStateCount();
+		
+		liveIndices.clear();
+		
+		for (int old_index = 0; old_index < edges; old_index++) {
+			if (oldCosts[old_index] < numeric_limits<double>::infinity())
+				liveIndices.push_back(old_index);
+		}
+		
+		int live_count = liveIndices.size();
+		
+		// Filters of each live state into every new mode, stored by live state, feature, and new mode.
+		for (int live = 0; live < live_count; live++) {
+			int old_index = liveIndices[live];
+			
+			for (int feature_index = 0; feature_index < feature_count; feature_index++) {
+				SegmentationParameters* parameters = features[feature_index]->getSegmentationParameters();
+				int mode_old = getMode<N>(modeMatrix, feature_index + 1, old_index) - 1;
+				ViterbiDistribution* filtered = &beamDistributions[(live * feature_count + feature_index) * 3];
+				
+				for (int mode_new = 0; mode_new < 3; mode_new++) {
+					filtered[mode_new] = maxDistributions[feature_index][old_index];
+					
+					filtered[mode_new].cost = KalmanLPF(
 						y[feature_index],
-						newDistributions[feature_index][new_index][old_index].covariance,
-						newDistributions[feature_index][new_index][old_index].mean,
+						filtered[mode_new].covariance,
+						filtered[mode_new].mean,
 						parameters->getR(),
-						parameters->q[modeMatrix[feature_index + 1][old_index] - 1][modeMatrix[feature_index + 1][new_index] - 1],
+						parameters->q[mode_old][mode_new],
 						parameters->getAlpha()
 					);
-					
-					cost_temp += newDistributions[feature_index][new_index][old_index].cost;
 				}
+			}
+		}
+		
+		kalman_updates += 3 * live_count * feature_count;
+		
+		// Min-plus from the live states into their successors.
+		fill(newCosts.begin(), newCosts.end(), numeric_limits<double>::infinity());
+		
+		for (int live = 0; live < live_count; live++) {
+			int old_index = liveIndices[live];
+			const ViterbiDistribution* filtered = &beamDistributions[live * feature_count * 3];
+			const vector<int>& next_states = successors[old_index];
+			
+			for (int i = 0; i < int(next_states.size()); i++) {
+				int new_index = next_states[i];
+				double cost = oldCosts[old_index] - probabilityMatrix[new_index][old_index];
 				
-				costs[new_index][old_index] = oldCosts[old_index] + cost_temp - probabilityMatrix[new_index][old_index];
+				for (int feature_index = 0; feature_index < feature_count; feature_index++)
+					cost += filtered[feature_index * 3 + getMode<N>(modeMatrix, feature_index + 1, new_index) - 1].cost;
+				
+				if (cost < newCosts[new_index]) {
+					newCosts[new_index] = cost;
+					predecessors[new_index] = old_index;
+					bestLive[new_index] = live;
+				}
 			}
+			
+			valid_edges += next_states.size();
 		}
 		
-		// Find the next element with least cost along each path.
-		for (int i = 0; i < edges; i++) {
-			vector<double>::iterator minimum_iterator = min_element(costs[i].begin(), costs[i].end());
-			psi[frame][i] = distance(costs[i].begin(), minimum_iterator);
-			oldCosts[i] = *minimum_iterator;
+		// States that were reached keep the filters they were reached with, as input distributions to the next frame.
+		for (int new_index = 0; new_index < edges; new_index++) {
+			if (!(newCosts[new_index] < numeric_limits<double>::infinity())) {
+				predecessors[new_index] = 0;
+				continue;
+			}
+			
+			const ViterbiDistribution* filtered = &beamDistributions[bestLive[new_index] * feature_count * 3];
+			
+			for (int feature_index = 0; feature_index < feature_count; feature_index++)
+				maxDistributions[feature_index][new_index] = filtered[feature_index * 3 + getMode<N>(modeMatrix, feature_index + 1, new_index) - 1];
 		}
+	}
+	
+	// Pick the Viterbi kernel specialized for the number of features, if there is one.
+	void Segmenter::selectViterbiKernel() {
+		switch (features.size()) {
+			case 1: viterbiFunction = &Segmenter::viterbiKernel<1>; break;
+			case 2: viterbiFunction = &Segmenter::viterbiKernel<2>; break;
+			case 3: viterbiFunction = &Segmenter::viterbiKernel<3>; break;
+			case 4: viterbiFunction = &Segmenter::viterbiKernel<4>; break;
+			case 5: viterbiFunction = &Segmenter::viterbiKernel<5>; break;
+			case 6: viterbiFunction = &Segmenter::viterbiKernel<6>; break;
+			default: viterbiFunction = &Segmenter::viterbiKernel<0>; break;
+		}
+	}
+	
+	// Whether segment() will decode a number of frames hierarchically: only if there are at least two coarse frames.
+	bool Segmenter::isHierarchical(int frames) {
+		return decimation > 1 && frames >= 2 * decimation;
+	}
+	
+	// Row of the traceback table for the row-th frame of the sequence being decoded, growing the table if needed.
+	int* Segmenter::getPsiRow(int row) {
+		if (int(psi.size()) <= row)
+			psi.resize(row + 1);
 		
-		// Copy best filtered distributions.
-		for (int i = 0; i < edges; i++) {
-			for (int f = 0; f < features.size(); f++) {
-				for (int row = 0; row < 2; row++) {
-					maxDistributions[f][i].mean[row] = newDistributions[f][i][psi[frame][i]].mean[row];
-					
-					for (int column = 0; column < 2; column++)
-						maxDistributions[f][i].covariance[row][column] = newDistributions[f][i][psi[frame][i]].covariance[row][column];					
+		if (int(psi[row].size()) != getStateCount())
+			psi[row].resize(getStateCount());
+		
+		return &psi[row][0];
+	}
+	
+	// Traverse the state transitions backward from the state with the least cost in the last frame. rows gives each
+	// frame's row of the traceback table, or -1 for frames in which every state followed itself; if it is NULL, frame i
+	// is row i.
+	void Segmenter::traceback(int frames, const int* rows, vector<int>& states) {
+		SIRENS_TIME_SCOPE("Segmenter::traceback", (unsigned long long) frames * sizeof(int));
+		
+		states[frames - 1] = distance(oldCosts.begin(), min_element(oldCosts.begin(), oldCosts.end()));
+		
+		for (int i = frames - 2; i > -1; i--) {
+			int row = rows != NULL ? rows[i] : i;
+			states[i] = row >= 0 ? psi[row][states[i + 1]] : states[i + 1];
+		}
+	}
+	
+	// Exact Viterbi over the first frames of the columns, writing the optimal state sequence to states.
+	void Segmenter::decode(const vector<FeatureSpan>& columns, int frames, vector<int>& states) {
+		resetPath();
+		
+		// For each frame, perform Viterbi and get the optimal state sequence.
+		for (int i = 0; i < frames; i++)
+			viterbi(columns, i, getPsiRow(i));
+		
+		traceback(frames, NULL, states);
+	}
+	
+	// Segment the columns averaged over blocks of decimation frames, then decode windows around the coarse solution's
+	// state changes at full resolution, allowing no changes in between.
+	void Segmenter::decodeHierarchical(const vector<FeatureSpan>& columns, vector<int>& states) {
+		int coarse_frames = (frames + decimation - 1) / decimation;
+		
+		for (int j = 0; j < int(features.size()); j++) {
+			for (int c = 0; c < coarse_frames; c++) {
+				int start = c * decimation;
+				int end = min(start + decimation, frames);
+				double sum = 0;
+				
+				for (int i = start; i < end; i++)
+					sum += columns[j].values[i];
+				
+				coarseValues[j][c] = sum / (end - start);
+			}
+			
+			coarseColumns[j].values = &coarseValues[j][0];
+			coarseColumns[j].size = coarse_frames;
+		}
+		
+		decode(coarseColumns, coarse_frames, coarseStates);
+		
+		// A change between coarse frames c - 1 and c happened somewhere in their frames; decode those and the guard band
+		// around them at full resolution, merging windows that overlap.
+		windows.clear();
+		
+		for (int c = 1; c < coarse_frames; c++) {
+			if (coarseStates[c] == coarseStates[c - 1])
+				continue;
+			
+			int start = max((c - 1) * decimation - guardBand, 0);
+			int end = min((c + 1) * decimation + guardBand, frames);
+			
+			if (!windows.empty() && start <= windows.back().second)
+				windows.back().second = end;
+			else
+				windows.push_back(make_pair(start, end));
+		}
+		
+		// Full resolution pass. Windows are decoded as usual. In the stretches between them the coarse solution found no
+		// change, so after the stretch's first frame (which may change state, to meet the window before it) every state
+		// only follows itself. Which state each stretch ends up in is still decided by the full resolution costs.
+		frameRows.assign(frames, -1);
+		int row = 0;
+		int position = 0;
+		
+		resetPath();
+		constrained = true;
+		
+		for (int w = 0; w <= int(windows.size()); w++) {
+			int hold_end = w < int(windows.size()) ? windows[w].first : frames;
+			
+			if (position < hold_end) {
+				frameRows[position] = row;
+				viterbi(columns, position, getPsiRow(row++));
+				
+				holding = true;
+				
+				for (position++; position < hold_end; position++)
+					viterbi(columns, position, NULL);
+				
+				holding = false;
+			}
+			
+			if (w < int(windows.size())) {
+				for (; position < windows[w].second; position++) {
+					frameRows[position] = row;
+					viterbi(columns, position, getPsiRow(row++));
 				}
 			}
 		}
 		
-		// Copy best filtered distributions as input distributions to next frame.
+		refinedFrames = row;
+		traceback(frames, &frameRows[0], states);
+		
+		constrained = false;
+	}
+	
+	bool Segmenter::isPruning() {
+		return beamWidth > 0 || beamThreshold < numeric_limits<double>::infinity();
+	}
+	
+	// Drop states from the current frame that fall outside the beam. Costs are already relative to the best state.
+	void Segmenter::prune() {
+		int edges = getStateCount();
+		
+		beamCosts.clear();
+		
 		for (int i = 0; i < edges; i++) {
-			for (int j = 0; j < edges; j++) {
-				for (int f = 0; f < features.size(); f++) {
-					for (int row = 0; row < 2; row ++) {
-						newDistributions[f][i][j].mean[row] = maxDistributions[f][i].mean[row];
-						
-						for (int column = 0; column < 2; column++)
-							newDistributions[f][i][j].covariance[row][column] = maxDistributions[f][i].covariance[row][column];
-					}
-				}
+			if (newCosts[i] > beamThreshold)
+				newCosts[i] = numeric_limits<double>::infinity();
+			else
+				beamCosts.push_back(newCosts[i]);
+		}
+		
+		if (beamWidth > 0 && int(beamCosts.size()) > beamWidth) {
+			nth_element(beamCosts.begin(), beamCosts.begin() + beamWidth - 1, beamCosts.end());
+			double cutoff = beamCosts[beamWidth - 1];
+			
+			for (int i = 0; i < edges; i++) {
+				if (newCosts[i] > cutoff)
+					newCosts[i] = numeric_limits<double>::infinity();
 			}
 		}
 	}
@@ -170,6 +521,9 @@ namespace Sirens {
 	void Segmenter::setFeatureSet(FeatureSet* feature_set) {
 		featureSet = feature_set;
 		features = featureSet->getFeatures();
+		stateCount = getSegmenterStateCount(features.size());
+		
+		selectViterbiKernel();
 	}
 	
 	FeatureSet* Segmenter::getFeatureSet() {
@@ -196,6 +550,38 @@ namespace Sirens {
 		return pOff;
 	}
 	
+	void Segmenter::setBeamWidth(int value) {
+		beamWidth = value;
+	}
+	
+	void Segmenter::setBeamThreshold(double value) {
+		beamThreshold = value > 0 ? value : numeric_limits<double>::infinity();
+	}
+	
+	int Segmenter::getBeamWidth() {
+		return beamWidth;
+	}
+	
+	double Segmenter::getBeamThreshold() {
+		return beamThreshold;
+	}
+	
+	void Segmenter::setDecimation(int value) {
+		decimation = value > 1 ? value : 1;
+	}
+	
+	void Segmenter::setGuardBand(int value) {
+		guardBand = value > 0 ? value : 0;
+	}
+	
+	int Segmenter::getDecimation() {
+		return decimation;
+	}
+	
+	int Segmenter::getGuardBand() {
+		return guardBand;
+	}
+	
 	/*-----------------*
 	 * Initialization. *
 	 *-----------------*/
@@ -232,9 +618,9 @@ namespace Sirens {
 		modeMatrix = vector<vector<int> >(int(features.size() + 1), int_row);
 		
 		for (int i = 0; i < edges; i++) {
-			vector<int> indices = getFeatureModes(i + 1);
+			vector<int> indices = getFeatureModes(i);
 			
-			for (int j = 0; j < features.size() + 1; j++)
+			for (int j = 0; j < int(features.size()) + 1; j++)
 				modeMatrix[j][i] = indices[j];
 		}
 		
@@ -248,7 +634,7 @@ namespace Sirens {
 				mode_new = modeMatrix[0][j];
 				gate_probability = 1.0;
 				
-				for (int k = 0; k < features.size(); k++) {
+				for (int k = 0; k < int(features.size()); k++) {
 					feature_mode_old = modeMatrix[k + 1][i];
 					feature_mode_new = modeMatrix[k + 1][j];
 					
@@ -258,52 +644,152 @@ namespace Sirens {
 				probabilityMatrix[j][i] = log(modeTransitions[mode_old - 1][mode_new - 1] * gate_probability);
 			}
 		}
+		
+		// Viterbi only needs to consider transitions that can actually happen.
+		validTransitions = vector<vector<int> >(edges);
+		
+		for (int i = 0; i < edges; i++) {
+			for (int j = 0; j < edges; j++) {
+				if (probabilityMatrix[i][j] > -numeric_limits<double>::infinity())
+					validTransitions[i].push_back(j);
+			}
+		}
+		
+		successors = vector<vector<int> >(edges);
+		
+		for (int i = 0; i < edges; i++) {
+			for (int j = 0; j < int(validTransitions[i].size()); j++)
+				successors[validTransitions[i][j]].push_back(i);
+		}
 	}
 	
-	// Initialize everything.
+	// Build the frame-independent tables: mode logic, prior transition probabilities, and the transitions Viterbi
+	// considers. They only depend on the number of features, pNew, pOff, and each feature's fusion logic, so they are
+	// kept across runs and rebuilt only when one of those changes.
 	void Segmenter::initialize() {
-		if (!initialized) {
-			// Initialize prior distributions.
-			for (int i = 0; i < features.size(); i++)
-				features[i]->getSegmentationParameters()->initialize();
-			
+		// Initialize prior distributions.
+		for (int i = 0; i < int(features.size()); i++)
+			features[i]->getSegmentationParameters()->initialize();
+		
+		getTableKey(currentTableKey);
+		
+		if (!initialized || currentTableKey != tableKey) {
 			createModeLogic();
 			createProbabilityTable();
 			
-			int edges = getStateCount();
+			tableKey = currentTableKey;
+			initialized = true;
+		}
+	}
+	
+	// Everything the tables are built from.
+	void Segmenter::getTableKey(vector<double>& key) {
+		key.clear();
+		key.push_back(features.size());
+		key.push_back(pNew);
+		key.push_back(pOff);
+		
+		for (int i = 0; i < int(features.size()); i++) {
+			const double* fusion_logic = &features[i]->getSegmentationParameters()->fusionLogic[0][0][0][0];
+			key.insert(key.end(), fusion_logic, fusion_logic + 81);
+		}
+	}
+	
+	// Prepare the per-run state for segmenting a number of frames. Buffers are only reallocated when they need to
+	// grow, so segmenting many files with one Segmenter allocates nothing once it has seen the longest one.
+	void Segmenter::reset(int frames) {
+		this->frames = frames;
+		
+		int edges = getStateCount();
+		
+		// Initialize global mode sequence (on/off/onset for each frame).
+		modes.assign(frames, 0);
+		
+		// Initialize cost vectors used by Viterbi.
+		oldCosts.resize(edges);
+		newCosts.resize(edges);
+		
+		reachable.assign(edges, true);
+		beamCosts.reserve(edges);
+		
+		if (isPruning()) {
+			liveIndices.reserve(edges);
+			beamDistributions.resize((size_t) edges * features.size() * 3);
+			bestLive.resize(edges);
+		}
+		
+		// Best state transitions for each state in each frame (only in the coarse pass and the windows decoded at full
+		// resolution when hierarchical; windows grow the table if they need to.) Every entry used is written by
+		// Viterbi, so rows left over from a longer run are kept as they are.
+		int rows = isHierarchical(frames) ? (frames + decimation - 1) / decimation : frames;
+		
+		if (int(psi.size()) < rows)
+			psi.resize(rows);
+		
+		for (int i = 0; i < rows; i++) {
+			if (int(psi[i].size()) != edges)
+				psi[i].resize(edges);
+		}
+		
+		maxDistributions.resize(features.size());
+		newDistributions.resize(features.size());
+		
+		for (int i = 0; i < int(features.size()); i++) {
+			maxDistributions[i].resize(edges);
+			newDistributions[i].resize(edges);
+		}
+		
+		resetPath();
+		refinedFrames = frames;
+		
+		// Initialize feature vector for current frame.
+		y.assign(features.size(), 0);
+		
+		columns.resize(features.size());
+		stateSequence.assign(frames, 0);
+		
+		// Coarse pass and windows of hierarchical segmentation. There is at most one window per coarse frame.
+		if (isHierarchical(frames)) {
+			int coarse_frames = (frames + decimation - 1) / decimation;
 			
-			// Initialize global mode sequence (on/off/onset for each frame).
-			modes = vector<int>(frames, 0);
+			coarseValues.resize(features.size());
+			coarseColumns.resize(features.size());
 			
-			// Initialize cost vectors used by Viterbi.
-			vector<double> cost_vector = vector<double>(edges, 0);
-			costs = vector<vector<double> >(edges, cost_vector);
-			oldCosts = vector<double>(edges, 0);
-				
-			// Best state transitions for each state in each frame.
-			vector<int> psi_row = vector<int>(edges, 0);
-			psi = vector<vector<int> >(frames, psi_row);
+			for (int i = 0; i < int(features.size()); i++)
+				coarseValues[i].resize(coarse_frames);
 			
-			// Initialize Gaussians used by Viterbi.
-			vector<ViterbiDistribution> temp1(edges);
-			maxDistributions = vector<vector<ViterbiDistribution> >(features.size(), temp1);
+			coarseStates.resize(coarse_frames);
+			windows.reserve(coarse_frames);
+			frameRows.reserve(frames);
+		}
+		
+		SIRENS_PEAK("Segmenter::psiBytes", (unsigned long long) rows * edges * sizeof(int));
+		SIRENS_PEAK("Segmenter::newDistributionsBytes", (unsigned long long) features.size() * edges * sizeof(array<ViterbiDistribution, 3>));
+	}
+	
+	// Start a Viterbi pass: every state has zero cost, and state 0 has the prior distribution.
+	void Segmenter::resetPath() {
+		int edges = getStateCount();
+		
+		oldCosts.assign(edges, 0);
+		newCosts.assign(edges, 0);
+		costOffset = 0;
+		liveStates = 0;
+		
+		// Initialize Gaussians used by Viterbi. State 0 starts from the prior distribution, and the others from the default
+		// one (mean 0, identity covariance.)
+		for (int i = 0; i < int(features.size()); i++) {
+			SegmentationParameters* parameters = features[i]->getSegmentationParameters();
 			
-			vector<vector<ViterbiDistribution> > temp2(edges, temp1);
-			newDistributions = vector<vector<vector<ViterbiDistribution> > >(features.size(), temp2);
+			for (int state = 0; state < edges; state++)
+				maxDistributions[i][state] = ViterbiDistribution();
 			
-			for (int i = 0; i < features.size(); i++) {
-				for (int a = 0; a < 2; a++) {
-					maxDistributions[i][0].mean[a] = features[i]->getSegmentationParameters()->xInit[a];
-					
-					for (int b = 0; b < 2; b++)
-						maxDistributions[i][0].covariance[a][b] = features[i]->getSegmentationParameters()->pInit[a][b];
-				}
+			for (int a = 0; a < 2; a++) {
+				maxDistributions[i][0].mean[a] = parameters->xInit[a];
+				
+				for (int b = 0; b < 2; b++)
+					maxDistributions[i][0].covariance[a][b] = parameters->pInit[a][b];
 			}
-			
-			// Initialize feature vector for current frame.
-			y = vector<double>(features.size(), 0);
-			
-			initialized = true;
 		}
 	}
 	
@@ -313,35 +799,28 @@ namespace Sirens {
 	 *---------------*/
 	
 	void Segmenter::segment() {
+		SIRENS_TIME_SCOPE("Segmenter::segment", 0);
+		DenormalGuard guard;
+		
 		if (featureSet != NULL) {
-			frames = featureSet->getMinHistorySize();
-			
 			initialize();
+			reset(featureSet->getMinHistorySize());
 			
-			// For each frame, perform Viterbi and get the optimal state sequence.
-			for (int i = 0; i < frames; i++) {
-				for (int j = 0; j < features.size(); j++)
-					y[j] = features[j]->getHistoryFrame(i);
-				
-				viterbi(i);
-			}
-			
-			vector<int> state_sequence(frames, 0);
-			
-			// Find the next state with the least cost and choose it to assign to the state of the last frame.
-			vector<double>::iterator minimum_cost = min_element(oldCosts.begin(), oldCosts.end());
-			state_sequence[frames - 1] = distance(oldCosts.begin(), minimum_cost);
+			// Normalized feature columns, read directly in the frame loop.
+			for (int j = 0; j < int(features.size()); j++)
+				columns[j] = features[j]->getNormalizedHistory(0, frames);
 			
-			// Find the "off" states and "on"/"onset" states that have minimum cost. 
-			int start = (getStateCount() / 3);
+			if (frames <= 0)
+				return;
 			
-			// Traverse the state transitions backward from the last frame's optimal mode to get the state sequence.
-			for (int i = frames - 2; i > -1; i--)
-				state_sequence[i] = psi[i][state_sequence[i + 1]];
+			if (isHierarchical(frames))
+				decodeHierarchical(columns, stateSequence);
+			else
+				decode(columns, frames, stateSequence);
 			
 			// Find the mode sequence.
 			for (int i = 0; i < frames; i++)
-				modes[i] = modeMatrix[0][state_sequence[i]];
+				modes[i] = modeMatrix[0][stateSequence[i]];
 		}
 	}
 	
@@ -352,30 +831,138 @@ namespace Sirens {
 	
 	vector<vector<int> > Segmenter::getSegments() {
 		vector<vector<int> > segments;
+		vector<int> segment(2, 0);
 		
-		// If the last frame is an onset, ignore it and just make it whatever the previous frame was.
-		for (int i = 0; i < modes.size(); i++) {
-			if (i < modes.size() - 1) {
-				if ((i == 0 && modes[i] == 3) || (modes[i] == 2)) {
-					vector<int> segment(2, 0);
-					segment[0] = i;
-					
-					for (int j = i; j < modes.size(); j++) {
-						if ((modes[j] == 1) || (j == modes.size() - 1)) {
-							segment[1] = j;
-							break;
-						}
-					}
-					
-					segments.push_back(segment);
-				}
+		SegmentIterator iterator = getSegmentIterator();
+		
+		while (iterator.next(segment[0], segment[1]))
+			segments.push_back(segment);
+		
+		return segments;
+	}
+	
+	int Segmenter::getSegments(int* segments, int capacity) {
+		SegmentIterator iterator = getSegmentIterator();
+		int count = 0;
+		int start, end;
+		
+		while (iterator.next(start, end)) {
+			if (count < capacity) {
+				segments[2 * count] = start;
+				segments[2 * count + 1] = end;
 			}
+			
+			count ++;
 		}
 		
-		return segments;
+		return count;
 	}
 	
-	vector<int> Segmenter::getModes() {
+	SegmentIterator Segmenter::getSegmentIterator() {
+		return SegmentIterator(modes.empty() ? NULL : &modes[0], modes.size());
+	}
+	
+	const vector<int>& Segmenter::getModes() {
 		return modes;
 	}
+	
+	double Segmenter::getPathCost() {
+		if (oldCosts.empty())
+			return 0;
+		
+		return costOffset + *min_element(oldCosts.begin(), oldCosts.end());
+	}
+	
+	double Segmenter::getAverageLiveStates() {
+		return frames > 0 ? liveStates / double(frames) : 0;
+	}
+	
+	double Segmenter::getRefinedFraction() {
+		return frames > 0 ? double(refinedFrames) / double(frames) : 0;
+	}
+	
+	double Segmenter::getModeDisagreement(const vector<int>& reference, const vector<int>& modes) {
+		// Frames present in only one of the sequences count as disagreements.
+		int length = min(reference.size(), modes.size());
+		int total = max(reference.size(), modes.size());
+		int disagreements = total - length;
+		
+		for (int i = 0; i < length; i++) {
+			if (reference[i] != modes[i])
+				disagreements ++;
+		}
+		
+		return total > 0 ? double(disagreements) / double(total) : 0;
+	}
+	
+	// Distinct segment start and end frames of a mode sequence, in order.
+	static vector<int> getBoundaries(const vector<int>& modes) {
+		vector<int> boundaries;
+		SegmentIterator iterator(modes.empty() ? NULL : &modes[0], modes.size());
+		int start, end;
+		
+		while (iterator.next(start, end)) {
+			boundaries.push_back(start);
+			boundaries.push_back(end);
+		}
+		
+		sort(boundaries.begin(), boundaries.end());
+		boundaries.erase(unique(boundaries.begin(), boundaries.end()), boundaries.end());
+		
+		return boundaries;
+	}
+	
+	BoundaryAgreement Segmenter::compareBoundaries(const vector<int>& reference, const vector<int>& modes, int tolerance) {
+		vector<int> reference_boundaries = getBoundaries(reference);
+		vector<int> boundaries = getBoundaries(modes);
+		
+		BoundaryAgreement agreement;
+		agreement.referenceBoundaries = reference_boundaries.size();
+		agreement.boundaries = boundaries.size();
+		
+		// Both lists are in order, so match them in one pass, pairing each boundary with the first unmatched reference
+		// boundary within the tolerance.
+		double total_offset = 0;
+		int i = 0, j = 0;
+		
+		while (i < int(reference_boundaries.size()) && j < int(boundaries.size())) {
+			int offset = boundaries[j] - reference_boundaries[i];
+			
+			if (abs(offset) <= tolerance) {
+				agreement.matched ++;
+				total_offset += abs(offset);
+				i++;
+				j++;
+			} else if (offset < 0) {
+				j++;
+			} else {
+				i++;
+			}
+		}
+		
+		agreement.meanOffset = agreement.matched > 0 ? total_offset / agreement.matched : 0;
+		
+		return agreement;
+	}
+	
+	BoundaryAgreement Segmenter::compareWithExact(int tolerance) {
+		int configured_decimation = decimation;
+		int configured_beam_width = beamWidth;
+		double configured_beam_threshold = beamThreshold;
+		
+		decimation = 1;
+		beamWidth = 0;
+		beamThreshold = numeric_limits<double>::infinity();
+		
+		segment();
+		vector<int> reference = modes;
+		
+		decimation = configured_decimation;
+		beamWidth = configured_beam_width;
+		beamThreshold = configured_beam_threshold;
+		
+		segment();
+		
+		return compareBoundaries(reference, modes, tolerance);
+	}
 }
@@ -20,7 +20,9 @@
 
 #include "../Feature.h"
 #include "../FeatureSet.h"
+#include "SegmenterModes.h"
 
+#include <array>
 #include <vector>
 using namespace std;
 
@@ -42,7 +44,9 @@ using namespace std;
 	
 	Every frame, a Kalman filter is performed for every possible state transition (there 
 	are #states^2 of these) for every feature. This corresponds to N * 3^(2(N + 1)) filters
-	evaluated each frame. 
+	evaluated each frame. In practice, a feature's filter for a transition only depends on
+	the new state and that feature's mode in the previous state, so only 3 distinct filters
+	per feature per new state need to be evaluated (N * 3^(N + 2) per frame.)
 	
 	Each Kalman filter attempts to predict the value of the input feature trajectory given
 	a certain known measurement noise (SegmentationParameters::getR) and a covariance, which
@@ -65,6 +69,35 @@ using namespace std;
 	proceeded by ON modes.) Viterbi then finds the shortest path through the network, which gives
 	you the most likely mode sequence.
 	
+	Costs are accumulated in the log domain, so they grow without bound over long recordings. After
+	every frame, the minimum cost is subtracted from all states' costs (and kept in a running offset),
+	which does not change the optimal path but keeps the costs in a range where precision is not lost.
+	
+	Beam search:
+	With many features, most states have costs far above the best one and almost never end up on the
+	optimal path. Setting a beam width (Segmenter::setBeamWidth) keeps only that many of the lowest-cost
+	states alive after each frame, and a beam threshold (Segmenter::setBeamThreshold) drops any state
+	whose cost is more than the threshold above the best state's. The next frame is then expanded from
+	the live states only: each runs its features' Kalman filters once into each of the three modes a
+	feature can move to, and every successor is scored from those, so the work per frame grows with the
+	beam width rather than the number of states. Unlike exact Viterbi, where each state keeps its own
+	filters, a state entered from another one takes over the filters of the state it came from (as a
+	state that was outside the beam has none that are current.) This is approximate: the result may
+	differ from exact Viterbi, which can be measured against an exact run with
+	Segmenter::getModeDisagreement (bench/Beam.cpp does this for a range of widths.) Both are disabled
+	by default.
+	
+	Hierarchical segmentation:
+	Exact Viterbi over millions of frames is slow, and its traceback table (one entry per state per frame) large.
+	Setting a decimation factor (Segmenter::setDecimation) first segments the feature columns averaged over blocks of
+	that many frames, which finds where the state changes to within a block. Only windows around those changes,
+	extended by a guard band of frames on either side (Segmenter::setGuardBand), are then decoded at full resolution.
+	In the long stable stretches between them, every state may only follow itself, as the coarse solution has no
+	change there: this needs one Kalman filter per feature per state and no traceback entries, while which state the
+	stretch is in is still chosen at full resolution. Like the beam, this is approximate: a change that the coarse
+	pass misses entirely (usually a very short segment) is not recovered. Segmenter::compareWithExact measures how
+	far its boundaries are from exact ones. Disabled by default.
+	
 	For more information about the algorithm implemented here, see:
 	G. Wichern, H. Thornburg, B. Mechtley, A. Fink, A. Spanias, and K. Tu, "Robust multi-feature
 	segmentation and indexing for natural sound environments," in Proc. of IEEE/EURASIP International
@@ -97,6 +130,68 @@ namespace Sirens {
 		}
 	};
 	
+	/*
+		Segments in a global mode sequence, found lazily in one forward pass.
+		
+		A segment starts at every ONSET (or at the first frame, if it is ON) and ends at the next OFF frame or the last
+		frame, whichever comes first, so overlapping segments that start in the same ON region end together. Frames are
+		read at most twice in total, however many segments overlap. An onset in the last frame does not start a segment.
+	*/
+	class SegmentIterator {
+	private:
+		const int* modes;
+		int size;
+		int groupStart;		// First frame after the last OFF frame.
+		int groupEnd;		// OFF frame (or the last frame) ending the segments starting in the current group, or -1.
+		int position;		// Next frame to check for an onset in the current group.
+		
+	public:
+		SegmentIterator(const int* modes = NULL, int size = 0) : modes(modes), size(size), groupStart(0), groupEnd(-1), position(0) {
+		}
+		
+		// Find the next segment, in order of start frame. Returns false when there are no more.
+		bool next(int& start, int& end) {
+			while (groupStart < size) {
+				if (groupEnd < 0) {
+					for (groupEnd = groupStart; groupEnd < size - 1 && modes[groupEnd] != 1; groupEnd++);
+					position = groupStart;
+				}
+				
+				int last = groupEnd < size - 1 ? groupEnd : size - 2;
+				
+				while (position <= last) {
+					int frame = position++;
+					
+					if (modes[frame] == 2 || (frame == 0 && modes[frame] == 3)) {
+						start = frame;
+						end = groupEnd;
+						return true;
+					}
+				}
+				
+				groupStart = groupEnd + 1;
+				groupEnd = -1;
+			}
+			
+			return false;
+		}
+	};
+	
+	// How closely the segment boundaries of one segmentation match those of a reference (see
+	// Segmenter::compareBoundaries.)
+	struct BoundaryAgreement {
+		int referenceBoundaries;	// Distinct segment start and end frames in the reference.
+		int boundaries;				// Distinct segment start and end frames in the segmentation compared with it.
+		int matched;				// Boundaries within the tolerance of a reference boundary, each matched at most once.
+		double meanOffset;			// Mean distance in frames between matched boundaries.
+		
+		BoundaryAgreement() : referenceBoundaries(0), boundaries(0), matched(0), meanOffset(0) {
+		}
+		
+		double getPrecision() const { return boundaries > 0 ? double(matched) / double(boundaries) : 1; }
+		double getRecall() const { return referenceBoundaries > 0 ? double(matched) / double(referenceBoundaries) : 1; }
+	};
+	
 	class Segmenter {
 	private:
 		FeatureSet* featureSet;
@@ -105,6 +200,11 @@ namespace Sirens {
 		// Initialization.
 		bool initialized;
 		int frames;
+		int stateCount;
+		vector<double> tableKey;						// What the tables were built from (see getTableKey.)
+		vector<double> currentTableKey;
+		
+		void getTableKey(vector<double>& key);
 		
 		double pNew, pOff;								// Prior poisson probabilities for the global mode.
 		vector<double> y;								// Feature vector for the current frame.
@@ -113,23 +213,66 @@ namespace Sirens {
 		vector<vector<double> > probabilityMatrix;		// Log-scaled prior transition probabilities for all state combinations.
 		
 		vector<vector<int> > modeMatrix;				// Modes of every feature (and global mode) for each state.
+		vector<vector<int> > validTransitions;			// Previous states with nonzero prior probability, for each new state.
 				
 		// Viterbi.
-		vector<vector<double> > costs;					// Costs of every possible state transition.
 		vector<vector<int> > psi;						// Stored state sequences.
-		vector<double> oldCosts;						// Minimum cost list for previous frame.
+		vector<double> oldCosts;						// Minimum cost list for previous frame (relative to costOffset.)
+		vector<double> newCosts;						// Minimum cost list for the current frame.
+		double costOffset;								// Total cost removed from oldCosts by renormalization.
+		vector<FeatureSpan> columns;					// Normalized feature columns for the current run.
+		vector<int> stateSequence;						// Optimal state of every frame.
+		
+		// Beam search.
+		int beamWidth;									// Maximum number of live states per frame (0 for no limit.)
+		double beamThreshold;							// Maximum cost above the best state for a state to stay live.
+		vector<vector<int> > successors;				// Next states with nonzero prior probability, for each previous state.
+		vector<bool> reachable;							// Whether each state can be reached from a live state this frame.
+		vector<double> beamCosts;						// Scratch space for finding the beam cutoff.
+		vector<int> liveIndices;						// States alive in the previous frame.
+		vector<ViterbiDistribution> beamDistributions;	// Each live state's filters, by live state, feature, and new feature mode.
+		vector<int> bestLive;							// Position in liveIndices of each new state's best previous state.
+		double liveStates;								// Total live states over all frames, for reporting.
+		
+		bool isPruning();
+		void prune();
+		
+		// Hierarchical segmentation.
+		int decimation;									// Frames per coarse frame (1 for exact segmentation.)
+		int guardBand;									// Frames decoded at full resolution on either side of a coarse change.
+		bool constrained;								// Whether some states may have infinite cost (while refining.)
+		bool holding;									// Whether every state may only follow itself in the current frame.
+		int refinedFrames;								// Frames with a traceback table row in the last run.
+		vector<vector<float> > coarseValues;			// Feature columns averaged over blocks of decimation frames.
+		vector<FeatureSpan> coarseColumns;
+		vector<int> coarseStates;						// Optimal state of every coarse frame.
+		vector<pair<int, int> > windows;				// Frame ranges decoded at full resolution.
+		vector<int> frameRows;							// Traceback table row of each frame, or -1 for held frames.
+		
+		bool isHierarchical(int frames);
+		int* getPsiRow(int row);
+		void resetPath();
+		void decode(const vector<FeatureSpan>& columns, int frames, vector<int>& states);
+		void decodeHierarchical(const vector<FeatureSpan>& columns, vector<int>& states);
+		void traceback(int frames, const int* rows, vector<int>& states);
 		
 		// Distributions for Viterbi.
 		vector<vector<ViterbiDistribution> > maxDistributions;				// Distributions that correspond to minimum cost transitions.
-		vector<vector<vector<ViterbiDistribution> > > newDistributions;		// Distributions for every possible transition and every feature.
+		vector<vector<array<ViterbiDistribution, 3> > > newDistributions;	// Distributions for every feature, new state, and previous feature mode.
 		
-		// Helpers for indexing large matrices.
-		vector<int> getFeatureModes(int state);		// Return mode of every feature (plus global mode) for a particular state.
+		// Helpers for indexing large matrices (see SegmenterModes.h.)
+		vector<int> getFeatureModes(int state);		// Return mode of every feature (plus global mode) for a particular state index.
 		int getStateCount();						// How many possible states are in the system (3 ^ (features + 1))
 		
 		// Algorithms.
 		double KalmanLPF(double y, double p[2][2], double x[2], double r, double q, double alpha);
-		void viterbi(int frame);
+		void viterbi(const vector<FeatureSpan>& columns, int frame, int* predecessors);
+		
+		// Viterbi specialized for N features (1 to MaxFixedFeatures), or for any number of features if N is 0.
+		template <int N> void viterbiKernel(int* predecessors);
+		template <int N> void expandBeam(int* predecessors, unsigned long long& kalman_updates, unsigned long long& valid_edges);
+		void (Segmenter::*viterbiFunction)(int* predecessors);
+		void selectViterbiKernel();
 		
 		vector<int> modes;
 		
@@ -145,22 +288,65 @@ namespace Sirens {
 		void setPNew(double value);
 		void setPOff(double value);
 		void setDelay(int value);
+		void setBeamWidth(int value);
+		void setBeamThreshold(double value);
+		void setDecimation(int value);
+		void setGuardBand(int value);
 		
 		double getPNew();
 		double getPOff();
 		int getDelay();
+		int getBeamWidth();
+		double getBeamThreshold();
+		int getDecimation();
+		int getGuardBand();
 		
-		// Initialization.
+		// Initialization. initialize() builds the tables that do not depend on the number of frames, reusing them
+		// from the last run when nothing they depend on has changed, and reset() prepares the buffers for a run of a
+		// number of frames. segment() calls both, so a Segmenter can be given one feature set after another.
 		void createModeLogic();
 		void createProbabilityTable();
-		void initialize();				
+		void initialize();
+		void reset(int frames);
 		
 		// Segmentation. This is what users call.
 		void segment();
 		
-		// Retrieve results after segmentation.
+		// Retrieve results after segmentation. Segments are (start, end) frame pairs, in order of start frame.
 		vector<vector<int> > getSegments();
-		vector<int> getModes();
+		
+		// Write up to capacity segments as start, end pairs into segments (2 * capacity ints), returning the total
+		// number of segments, which may be more than capacity.
+		int getSegments(int* segments, int capacity);
+		
+		// Iterate over segments without storing them.
+		SegmentIterator getSegmentIterator();
+		
+		// Call callback(start, end) for every segment.
+		template <typename Callback>
+		void forEachSegment(Callback callback) {
+			SegmentIterator iterator = getSegmentIterator();
+			int start, end;
+			
+			while (iterator.next(start, end))
+				callback(start, end);
+		}
+		
+		// Global mode of every frame. The reference is valid until the next segment().
+		const vector<int>& getModes();
+		double getPathCost();			// Total (negative log-likelihood) cost of the optimal state sequence.
+		double getAverageLiveStates();	// Average number of states kept alive per frame by the beam.
+		double getRefinedFraction();	// Fraction of frames decoded at full resolution (1 unless hierarchical.)
+		
+		// Fraction of frames in which two mode sequences (e.g. exact and beam results) disagree.
+		static double getModeDisagreement(const vector<int>& reference, const vector<int>& modes);
+		
+		// Match the segment boundaries of two mode sequences, allowing them to be up to tolerance frames apart.
+		static BoundaryAgreement compareBoundaries(const vector<int>& reference, const vector<int>& modes, int tolerance);
+		
+		// Segment exactly (no decimation or beam) and then as configured, and compare the boundaries of the two. The
+		// configured result is kept, so this can stand in for segment() when evaluating settings.
+		BoundaryAgreement compareWithExact(int tolerance);
 	};
 }
 
@@ -0,0 +1,63 @@
+/*
+	Copyright 2009 Arizona State University
+	
+	This file is part of Sirens.
+	
+	Sirens is free software: you can redistribute it and/or modify it under the terms 
+	of the GNU Lesser General Public License as  published by the Free Software 
+	Foundation, either version 3 of the License, or (at your option) any later version.
+	
+	Sirens is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+	without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR 
+	PURPOSE.  See the GNU General Public License for more details.
+	
+	You should have received a copy of the GNU Lesser General Public License along
+	with Sirens. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef __SEGMENTERMODES_H__
+#define __SEGMENTERMODES_H__
+
+/*
+	State indexing for the segmenter.
+
+	A state is a combination of the global mode and one mode per feature, each of which is 1 (OFF),
+	2 (ONSET), or 3 (ON). States are numbered so that, written in base 3, the most significant digit
+	is the global mode and the following digits are the modes of each feature in order, each digit
+	being one less than the mode. For N features, there are 3^(N + 1) states.
+
+	Everything here is constexpr, so when the number of features is known at compile time (see
+	Segmenter::viterbiKernel) state counts and mode lookups are constants.
+*/
+
+namespace Sirens {
+	// Largest number of features for which the segmenter has a specialized Viterbi kernel.
+	const int MaxFixedFeatures = 6;
+
+	// How many states there are for a number of features: 3 ^ (features + 1).
+	constexpr int getSegmenterStateCount(int features) {
+		return features < 0 ? 1 : 3 * getSegmenterStateCount(features - 1);
+	}
+
+	// Mode of the global mode (position 0) or feature (position i + 1) for a particular state index.
+	constexpr int getSegmenterMode(int state, int position, int features) {
+		return (state / getSegmenterStateCount(features - position - 1)) % 3 + 1;
+	}
+
+	// Modes of the global mode and every feature for every state, computed at compile time.
+	template <int N>
+	struct SegmenterModeTable {
+		static constexpr int states = getSegmenterStateCount(N);
+
+		unsigned char modes[N + 1][states];
+
+		constexpr SegmenterModeTable() : modes() {
+			for (int position = 0; position < N + 1; position++) {
+				for (int state = 0; state < states; state++)
+					modes[position][state] = getSegmenterMode(state, position, N);
+			}
+		}
+	};
+}
+
+#endif
@@ -0,0 +1,72 @@
+/*
+	Copyright 2009 Arizona State University
+	
+	This file is part of Sirens.
+	
+	Sirens is free software: you can redistribute it and/or modify it under the terms 
+	of the GNU Lesser General Public License as  published by the Free Software 
+	Foundation, either version 3 of the License, or (at your option) any later version.
+	
+	Sirens is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+	without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR 
+	PURPOSE.  See the GNU General Public License for more details.
+	
+	You should have received a copy of the GNU Lesser General Public License along
+	with Sirens. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "SegmenterPool.h"
+
+namespace Sirens {
+	SegmenterPool::SegmenterPool(int size) {
+		segmenters.reserve(size);
+		available.reserve(size);
+		
+		for (int i = 0; i < size; i++) {
+			segmenters.push_back(new Segmenter());
+			available.push_back(segmenters.back());
+		}
+	}
+	
+	// Segmenters that are still acquired are deleted too, so the pool must outlive its users.
+	SegmenterPool::~SegmenterPool() {
+		for (int i = 0; i < int(segmenters.size()); i++)
+			delete segmenters[i];
+	}
+	
+	Segmenter* SegmenterPool::acquire() {
+		lock_guard<mutex> lock(poolMutex);
+		
+		if (available.empty()) {
+			segmenters.push_back(new Segmenter());
+			
+			// Make room now, so that releasing it later never has to allocate.
+			available.reserve(segmenters.size());
+			
+			return segmenters.back();
+		}
+		
+		Segmenter* segmenter = available.back();
+		available.pop_back();
+		
+		return segmenter;
+	}
+	
+	void SegmenterPool::release(Segmenter* segmenter) {
+		if (segmenter == NULL)
+			return;
+		
+		lock_guard<mutex> lock(poolMutex);
+		available.push_back(segmenter);
+	}
+	
+	int SegmenterPool::getSize() {
+		lock_guard<mutex> lock(poolMutex);
+		return segmenters.size();
+	}
+	
+	int SegmenterPool::getAvailableCount() {
+		lock_guard<mutex> lock(poolMutex);
+		return available.size();
+	}
+}
@@ -0,0 +1,59 @@
+/*
+	Copyright 2009 Arizona State University
+	
+	This file is part of Sirens.
+	
+	Sirens is free software: you can redistribute it and/or modify it under the terms 
+	of the GNU Lesser General Public License as  published by the Free Software 
+	Foundation, either version 3 of the License, or (at your option) any later version.
+	
+	Sirens is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+	without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR 
+	PURPOSE.  See the GNU General Public License for more details.
+	
+	You should have received a copy of the GNU Lesser General Public License along
+	with Sirens. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef __SEGMENTERPOOL_H__
+#define __SEGMENTERPOOL_H__
+
+#include "Segmenter.h"
+
+#include <mutex>
+#include <vector>
+using namespace std;
+
+namespace Sirens {
+	/*
+		Recycles Segmenters between segmentation jobs, so batch workers don't rebuild the probability tables and
+		reallocate the Viterbi buffers (megabytes with five or more features) for every file.
+		
+		A segmenter comes back from acquire() with whatever feature set, probabilities, and beam settings it was
+		released with; set those that differ, then setFeatureSet() and segment() as usual. Its tables are reused when
+		they still apply and its buffers grow to the longest file it has seen (see Segmenter::reset), so once every
+		segmenter in the pool has done a run, acquiring and segmenting allocate nothing. acquire() and release() may
+		be called from any thread.
+	*/
+	class SegmenterPool {
+	private:
+		mutex poolMutex;
+		vector<Segmenter*> segmenters;		// Every segmenter created by the pool.
+		vector<Segmenter*> available;		// Segmenters not currently acquired.
+		
+	public:
+		SegmenterPool(int size = 0);
+		~SegmenterPool();
+		
+		// Take a segmenter out of the pool, creating one if none are available.
+		Segmenter* acquire();
+		
+		// Return a segmenter from acquire() to the pool.
+		void release(Segmenter* segmenter);
+		
+		int getSize();
+		int getAvailableCount();
+	};
+}
+
+#endif
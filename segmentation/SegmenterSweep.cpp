@@ -0,0 +1,650 @@
+/*
+	Copyright 2009 Arizona State University
+	
+	This file is part of Sirens.
+	
+	Sirens is free software: you can redistribute it and/or modify it under the terms 
+	of the GNU Lesser General Public License as  published by the Free Software 
+	Foundation, either version 3 of the License, or (at your option) any later version.
+	
+	Sirens is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+	without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR 
+	PURPOSE.  See the GNU General Public License for more details.
+	
+	You should have received a copy of the GNU Lesser General Public License along
+	with Sirens. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "SegmenterSweep.h"
+#include "../support/Instrumentation.h"
+#include "../support/Denormals.h"
+#include "../support/Kernels.h"
+
+#include <cmath>
+#include <algorithm>
+#include <limits>
+using namespace std;
+
+namespace Sirens {
+	SegmenterSweep::SegmenterSweep(double p_new, double p_off) : segmenter(p_new, p_off) {
+		setPNew(p_new);
+		setPOff(p_off);
+		
+		featureSet = NULL;
+		frames = 0;
+		stateCount = 0;
+		fastMath = false;
+	}
+	
+	SegmenterSweep::~SegmenterSweep() {
+	}
+	
+	/*-----------*
+	 * Features. *
+	 *-----------*/
+	
+	void SegmenterSweep::setFeatureSet(FeatureSet* feature_set) {
+		featureSet = feature_set;
+		features = featureSet->getFeatures();
+		stateCount = getSegmenterStateCount(features.size());
+		
+		createModeMatrix();
+		segmenter.setFeatureSet(featureSet);
+	}
+	
+	FeatureSet* SegmenterSweep::getFeatureSet() {
+		return featureSet;
+	}
+	
+	/*-------------*
+	 * Attributes. *
+	 *-------------*/
+	
+	void SegmenterSweep::setPNew(double value) {
+		pNew = value;
+		segmenter.setPNew(value);
+	}
+	
+	void SegmenterSweep::setPOff(double value) {
+		pOff = value;
+		segmenter.setPOff(value);
+	}
+	
+	double SegmenterSweep::getPNew() {
+		return pNew;
+	}
+	
+	double SegmenterSweep::getPOff() {
+		return pOff;
+	}
+	
+	void SegmenterSweep::setFastMath(bool value) {
+		fastMath = value;
+	}
+	
+	bool SegmenterSweep::getFastMath() {
+		return fastMath;
+	}
+	
+	// Measured against a Segmenter per configuration: below these, a group in lanes takes longer than its configurations
+	// do separately.
+	int SegmenterSweep::getMinGroupSize() {
+		return fastMath ? 2 : 6;
+	}
+	
+	/*-----------------*
+	 * Initialization. *
+	 *-----------------*/
+	
+	void SegmenterSweep::createModeMatrix() {
+		modeMatrix = vector<vector<int> >(features.size() + 1, vector<int>(stateCount));
+		
+		for (int position = 0; position < int(features.size()) + 1; position++) {
+			for (int state = 0; state < stateCount; state++)
+				modeMatrix[position][state] = getSegmenterMode(state, position, features.size());
+		}
+	}
+	
+	// Load the parameters of configurations first to first + SweepLanes - 1 into the lanes, repeating the last
+	// configuration in lanes past the end, and build each lane's prior transition probabilities as Segmenter does.
+	void SegmenterSweep::loadGroup(const vector<vector<SegmentationParameters> >& configurations, int first) {
+		int feature_count = features.size();
+		int edges = stateCount;
+		
+		laneParameters.resize(feature_count * SweepLanes);
+		r.resize(feature_count * SweepLanes);
+		alpha.resize(feature_count * SweepLanes);
+		q.resize(feature_count * 9 * SweepLanes);
+		offset.resize(feature_count * SweepLanes);
+		scale.resize(feature_count * SweepLanes);
+		
+		for (int k = 0; k < SweepLanes; k++) {
+			int c = min(first + k, int(configurations.size()) - 1);
+			
+			for (int f = 0; f < feature_count; f++) {
+				SegmentationParameters& parameters = laneParameters[f * SweepLanes + k];
+				parameters = configurations[c][f];
+				parameters.initialize();
+				
+				r[f * SweepLanes + k] = parameters.getR();
+				alpha[f * SweepLanes + k] = parameters.getAlpha();
+				
+				for (int mode_old = 0; mode_old < 3; mode_old++) {
+					for (int mode_new = 0; mode_new < 3; mode_new++)
+						q[((f * 3 + mode_old) * 3 + mode_new) * SweepLanes + k] = parameters.q[mode_old][mode_new];
+				}
+				
+				// As in Feature::normalize.
+				double min_value = parameters.getMinFeatureValue();
+				double max_value = parameters.getMaxFeatureValue();
+				
+				offset[f * SweepLanes + k] = min_value;
+				scale[f * SweepLanes + k] = max_value != min_value ? 1.0 / (max_value - min_value) : 1.0;
+			}
+		}
+		
+		// Global mode transition probabilities (see Segmenter::createModeLogic.)
+		double mode_transitions[3][3] = {
+			{1.0 - pNew, pNew, 0},
+			{0, 0, 1},
+			{pOff - pOff * pNew, pNew, 1.0 - pNew - pOff + pOff * pNew}
+		};
+		
+		// Log prior of every transition in every lane (see Segmenter::createProbabilityTable), keeping the transitions
+		// that any lane allows. A lane that doesn't allow one has -infinity, so it is never chosen there.
+		validTransitions = vector<vector<int> >(edges);
+		transitionProbabilities = vector<vector<double> >(edges);
+		
+		double probabilities[SweepLanes];
+		
+		for (int new_index = 0; new_index < edges; new_index++) {
+			for (int old_index = 0; old_index < edges; old_index++) {
+				int mode_old = modeMatrix[0][old_index];
+				int mode_new = modeMatrix[0][new_index];
+				bool valid = false;
+				
+				for (int k = 0; k < SweepLanes; k++) {
+					double gate_probability = 1.0;
+					
+					for (int f = 0; f < feature_count; f++) {
+						int feature_mode_old = modeMatrix[f + 1][old_index];
+						int feature_mode_new = modeMatrix[f + 1][new_index];
+						
+						gate_probability *= laneParameters[f * SweepLanes + k].fusionLogic[mode_old - 1][mode_new - 1][feature_mode_old - 1][feature_mode_new - 1];
+					}
+					
+					probabilities[k] = log(mode_transitions[mode_old - 1][mode_new - 1] * gate_probability);
+					
+					if (probabilities[k] > -numeric_limits<double>::infinity())
+						valid = true;
+				}
+				
+				if (valid) {
+					validTransitions[new_index].push_back(old_index);
+					transitionProbabilities[new_index].insert(transitionProbabilities[new_index].end(), probabilities, probabilities + SweepLanes);
+				}
+			}
+		}
+		
+		if (fastMath) {
+			int combinations = getSegmenterStateCount(feature_count - 1);
+			
+			fastR.assign(r.begin(), r.end());
+			fastAlpha.assign(alpha.begin(), alpha.end());
+			fastQ.assign(q.begin(), q.end());
+			fastTransitionProbabilities = vector<vector<float> >(edges);
+			transitionCombinations = vector<vector<int> >(edges);
+			
+			// A state's index is its global mode followed by its feature modes, in base 3, so the feature modes alone are
+			// the index modulo the number of their combinations.
+			for (int new_index = 0; new_index < edges; new_index++) {
+				fastTransitionProbabilities[new_index].assign(transitionProbabilities[new_index].begin(), transitionProbabilities[new_index].end());
+				
+				for (int i = 0; i < int(validTransitions[new_index].size()); i++)
+					transitionCombinations[new_index].push_back(validTransitions[new_index][i] % combinations);
+			}
+		}
+	}
+	
+	// Every state starts with zero cost in every lane: state 0 from the lane's prior distribution, and the others from
+	// the default one (mean 0, identity covariance), as in Segmenter::resetPath.
+	void SegmenterSweep::resetGroup() {
+		int feature_count = features.size();
+		int edges = stateCount;
+		
+		oldCosts.assign(edges * SweepLanes, 0);
+		newCosts.assign(edges * SweepLanes, 0);
+		fastOldCosts.assign(fastMath ? edges * SweepLanes : 0, 0);
+		fastNewCosts.assign(fastMath ? edges * SweepLanes : 0, 0);
+		
+		for (int k = 0; k < SweepLanes; k++)
+			costOffset[k] = 0;
+		
+		for (int f = 0; f < feature_count; f++) {
+			for (int state = 0; state < edges; state++) {
+				SweepDistribution<double>& distribution = maxDistributions[f * edges + state];
+				
+				for (int k = 0; k < SweepLanes; k++) {
+					const SegmentationParameters& parameters = laneParameters[f * SweepLanes + k];
+					
+					for (int a = 0; a < 2; a++) {
+						distribution.mean[a][k] = state == 0 ? parameters.xInit[a] : 0;
+						
+						for (int b = 0; b < 2; b++)
+							distribution.covariance[a][b][k] = state == 0 ? parameters.pInit[a][b] : (a == b ? 1 : 0);
+					}
+					
+					distribution.cost[k] = 0;
+				}
+				
+				if (fastMath) {
+					SweepDistribution<float>& fast_distribution = fastMaxDistributions[f * edges + state];
+					
+					for (int k = 0; k < SweepLanes; k++) {
+						for (int a = 0; a < 2; a++) {
+							fast_distribution.mean[a][k] = distribution.mean[a][k];
+							
+							for (int b = 0; b < 2; b++)
+								fast_distribution.covariance[a][b][k] = distribution.covariance[a][b][k];
+						}
+					}
+				}
+			}
+		}
+	}
+	
+	/*-------------*
+	 * Algorithms. *
+	 *-------------*/
+	
+	// Segmenter::KalmanLPF in every lane, from prior to posterior. The filter update is one loop the compiler can
+	// vectorize; the costs, which need a log, are a second.
+	static inline void filterLanes(const SweepDistribution<double>& prior, SweepDistribution<double>& posterior, const double* __restrict y, const double* __restrict r, const double* __restrict q, const double* __restrict alpha) {
+		const double* __restrict x0 = prior.mean[0];
+		const double* __restrict x1 = prior.mean[1];
+		const double* __restrict p00 = prior.covariance[0][0];
+		const double* __restrict p01 = prior.covariance[0][1];
+		const double* __restrict p10 = prior.covariance[1][0];
+		const double* __restrict p11 = prior.covariance[1][1];
+		
+		double* __restrict new_x0 = posterior.mean[0];
+		double* __restrict new_x1 = posterior.mean[1];
+		double* __restrict new_p00 = posterior.covariance[0][0];
+		double* __restrict new_p01 = posterior.covariance[0][1];
+		double* __restrict new_p10 = posterior.covariance[1][0];
+		double* __restrict new_p11 = posterior.covariance[1][1];
+		
+		double err[SweepLanes];
+		double s[SweepLanes];
+		
+		for (int k = 0; k < SweepLanes; k++) {
+			double a = alpha[k];
+			
+			// Prediction.
+			double x_1 = (1 - a) * x0[k] + a * x1[k];
+			
+			// Prediction covariance.
+			double p_11 = p00[k] * (1 - a) * (1 - a) + 2 * p01[k] * a * (1 - a) + p11[k] * a * a + q[k] * (1 - a) * (1 - a);
+			double p_10 = p00[k] * (1 - a) + p10[k] * a + q[k] * (1 - a);
+			double p_01 = p_10;
+			double p_00 = p00[k] + q[k];
+			
+			// Lowpass filter error and Kalman filter residual variance.
+			err[k] = y[k] - x_1;
+			s[k] = p_11 + r[k];
+			
+			// Kalman gain.
+			double k0 = p_01 / s[k];
+			double k1 = p_11 / s[k];
+			
+			// Posterior estimate covariance.
+			new_p00[k] = p_00 - k0 * p_01;
+			new_p10[k] = p_10 - k0 * p_11;
+			new_p01[k] = new_p10[k];
+			new_p11[k] = p_11 - k1 * p_11;
+			
+			// Estimate.
+			new_x0[k] = x0[k] + k0 * err[k];
+			new_x1[k] = x_1 + k1 * err[k];
+		}
+		
+		for (int k = 0; k < SweepLanes; k++)
+			posterior.cost[k] = 0.5 * (log(s[k]) + (err[k] * err[k] / s[k]));
+	}
+	
+	// Segmenter::viterbiKernel for one frame, in every lane.
+	void SegmenterSweep::viterbi(int frame) {
+		const int feature_count = features.size();
+		const int edges = stateCount;
+		
+		int* predecessors = &psi[(size_t) frame * edges * SweepLanes];
+		
+		for (int new_index = 0; new_index < edges; new_index++) {
+			// Filter each feature from this state's best distribution, once for every mode the feature could have been in.
+			for (int f = 0; f < feature_count; f++) {
+				int mode_new = modeMatrix[f + 1][new_index] - 1;
+				
+				for (int mode_old = 0; mode_old < 3; mode_old++) {
+					filterLanes(maxDistributions[f * edges + new_index], newDistributions[(f * edges + new_index) * 3 + mode_old], &y[f * SweepLanes], &r[f * SweepLanes], &q[((f * 3 + mode_old) * 3 + mode_new) * SweepLanes], &alpha[f * SweepLanes]);
+				}
+			}
+			
+			// Min-plus over the valid transitions into this state, in every lane. Indices are kept as doubles so that
+			// choosing between them takes the same instructions as choosing between costs.
+			double minimum_cost[SweepLanes];
+			double minimum_index[SweepLanes];
+			
+			for (int k = 0; k < SweepLanes; k++) {
+				minimum_cost[k] = numeric_limits<double>::infinity();
+				minimum_index[k] = 0;
+			}
+			
+			const vector<int>& transitions = validTransitions[new_index];
+			const double* probabilities = &transitionProbabilities[new_index][0];
+			
+			for (int i = 0; i < int(transitions.size()); i++) {
+				int old_index = transitions[i];
+				double cost_temp[SweepLanes] = {0};
+				
+				for (int f = 0; f < feature_count; f++) {
+					const double* costs = newDistributions[(f * edges + new_index) * 3 + modeMatrix[f + 1][old_index] - 1].cost;
+					
+					for (int k = 0; k < SweepLanes; k++)
+						cost_temp[k] += costs[k];
+				}
+				
+				const double* old_costs = &oldCosts[old_index * SweepLanes];
+				const double* probability = probabilities + i * SweepLanes;
+				
+				for (int k = 0; k < SweepLanes; k++) {
+					double cost = old_costs[k] + cost_temp[k] - probability[k];
+					bool better = cost < minimum_cost[k];
+					
+					minimum_cost[k] = better ? cost : minimum_cost[k];
+					minimum_index[k] = better ? old_index : minimum_index[k];
+				}
+			}
+			
+			for (int k = 0; k < SweepLanes; k++) {
+				predecessors[new_index * SweepLanes + k] = int(minimum_index[k]);
+				newCosts[new_index * SweepLanes + k] = minimum_cost[k];
+			}
+			
+			// Keep each lane's best filtered distributions as input distributions to the next frame.
+			for (int f = 0; f < feature_count; f++) {
+				SweepDistribution<double>& maximum = maxDistributions[f * edges + new_index];
+				
+				for (int k = 0; k < SweepLanes; k++) {
+					const SweepDistribution<double>& distribution = newDistributions[(f * edges + new_index) * 3 + modeMatrix[f + 1][int(minimum_index[k])] - 1];
+					
+					for (int a = 0; a < 2; a++) {
+						maximum.mean[a][k] = distribution.mean[a][k];
+						
+						for (int b = 0; b < 2; b++)
+							maximum.covariance[a][b][k] = distribution.covariance[a][b][k];
+					}
+					
+					maximum.cost[k] = distribution.cost[k];
+				}
+			}
+		}
+		
+		// Renormalize each lane so that its best state has zero cost.
+		for (int k = 0; k < SweepLanes; k++) {
+			double minimum_cost = numeric_limits<double>::infinity();
+			
+			for (int i = 0; i < edges; i++)
+				minimum_cost = min(minimum_cost, newCosts[i * SweepLanes + k]);
+			
+			if (minimum_cost < numeric_limits<double>::infinity()) {
+				for (int i = 0; i < edges; i++)
+					newCosts[i * SweepLanes + k] -= minimum_cost;
+				
+				costOffset[k] += minimum_cost;
+			}
+		}
+		
+		oldCosts.swap(newCosts);
+	}
+	
+	// viterbi in fast mode, with the lane kernels (see support/Kernels.h.) The feature costs of a transition depend only
+	// on the previous state's feature modes, so they are summed once per combination of those rather than once per
+	// transition.
+	void SegmenterSweep::viterbiFast(int frame) {
+		const KernelTable& kernels = getKernels();
+		const int feature_count = features.size();
+		const int edges = stateCount;
+		
+		int* predecessors = &psi[(size_t) frame * edges * SweepLanes];
+		
+		for (int new_index = 0; new_index < edges; new_index++) {
+			// Filter each feature from this state's best distribution, once for every mode the feature could have been in,
+			// and take the logs of all their residual variances at once.
+			for (int f = 0; f < feature_count; f++) {
+				int mode_new = modeMatrix[f + 1][new_index] - 1;
+				
+				for (int mode_old = 0; mode_old < 3; mode_old++) {
+					int filter = (f * 3 + mode_old) * SweepLanes;
+					
+					kernels.filterLanes(fastMaxDistributions[f * edges + new_index].mean[0], fastNewDistributions[(f * edges + new_index) * 3 + mode_old].mean[0], &fastY[f * SweepLanes], &fastR[f * SweepLanes], &fastQ[((f * 3 + mode_old) * 3 + mode_new) * SweepLanes], &fastAlpha[f * SweepLanes], &residuals[filter], &errors[filter], SweepLanes);
+				}
+			}
+			
+			kernels.naturalLog(&residuals[0], &residuals[0], residuals.size());
+			
+			// Sum the feature costs for every combination of previous feature modes, one feature at a time: feature f's
+			// mode is the next base 3 digit of the combination.
+			int combinations = 1;
+			
+			for (int k = 0; k < SweepLanes; k++)
+				combinedCosts[k] = 0;
+			
+			for (int f = 0; f < feature_count; f++) {
+				kernels.combineCosts(&combinedCosts[0], combinations, &residuals[f * 3 * SweepLanes], &errors[f * 3 * SweepLanes], SweepLanes);
+				combinations *= 3;
+			}
+			
+			// Min-plus over the valid transitions into this state, in every lane.
+			const vector<int>& transitions = validTransitions[new_index];
+			
+			kernels.minPlusLanes(&fastOldCosts[0], &transitions[0], &combinedCosts[0], &transitionCombinations[new_index][0], &fastTransitionProbabilities[new_index][0], transitions.size(), SweepLanes, &fastNewCosts[new_index * SweepLanes], &predecessors[new_index * SweepLanes]);
+			
+			// Keep each lane's best filtered distributions as input distributions to the next frame.
+			for (int f = 0; f < feature_count; f++) {
+				SweepDistribution<float>& maximum = fastMaxDistributions[f * edges + new_index];
+				
+				for (int k = 0; k < SweepLanes; k++) {
+					const SweepDistribution<float>& distribution = fastNewDistributions[(f * edges + new_index) * 3 + modeMatrix[f + 1][predecessors[new_index * SweepLanes + k]] - 1];
+					
+					for (int a = 0; a < 2; a++) {
+						maximum.mean[a][k] = distribution.mean[a][k];
+						
+						for (int b = 0; b < 2; b++)
+							maximum.covariance[a][b][k] = distribution.covariance[a][b][k];
+					}
+				}
+			}
+		}
+		
+		// Renormalize each lane so that its best state has zero cost, keeping the offset in double.
+		for (int k = 0; k < SweepLanes; k++) {
+			float minimum_cost = numeric_limits<float>::infinity();
+			
+			for (int i = 0; i < edges; i++)
+				minimum_cost = min(minimum_cost, fastNewCosts[i * SweepLanes + k]);
+			
+			if (minimum_cost < numeric_limits<float>::infinity()) {
+				for (int i = 0; i < edges; i++)
+					fastNewCosts[i * SweepLanes + k] -= minimum_cost;
+				
+				costOffset[k] += minimum_cost;
+			}
+		}
+		
+		fastOldCosts.swap(fastNewCosts);
+	}
+	
+	// Cost of ending in state at the last frame, in lane k.
+	double SegmenterSweep::getFinalCost(int state, int k) {
+		return fastMath ? fastOldCosts[state * SweepLanes + k] : oldCosts[state * SweepLanes + k];
+	}
+	
+	// Recover the mode sequences and path costs of configurations first to first + count - 1 from their lanes.
+	void SegmenterSweep::traceback(int first, int count) {
+		int edges = stateCount;
+		vector<int> state_sequence(frames);
+		
+		for (int k = 0; k < count; k++) {
+			int last_state = 0;
+			
+			for (int i = 1; i < edges; i++) {
+				if (getFinalCost(i, k) < getFinalCost(last_state, k))
+					last_state = i;
+			}
+			
+			state_sequence[frames - 1] = last_state;
+			
+			for (int i = frames - 2; i > -1; i--)
+				state_sequence[i] = psi[((size_t) i * edges + state_sequence[i + 1]) * SweepLanes + k];
+			
+			modes[first + k].resize(frames);
+			
+			for (int i = 0; i < frames; i++)
+				modes[first + k][i] = modeMatrix[0][state_sequence[i]];
+			
+			pathCosts[first + k] = costOffset[k] + getFinalCost(last_state, k);
+		}
+	}
+	
+	// Segment configurations first to first + count - 1 with the Segmenter, giving the features each configuration's
+	// parameters in turn.
+	void SegmenterSweep::segmentSeparately(const vector<vector<SegmentationParameters> >& configurations, int first, int count) {
+		int feature_count = features.size();
+		vector<SegmentationParameters> saved(feature_count);
+		
+		for (int f = 0; f < feature_count; f++)
+			saved[f] = *features[f]->getSegmentationParameters();
+		
+		for (int c = first; c < first + count; c++) {
+			for (int f = 0; f < feature_count; f++)
+				*features[f]->getSegmentationParameters() = configurations[c][f];
+			
+			segmenter.segment();
+			
+			modes[c] = segmenter.getModes();
+			pathCosts[c] = segmenter.getPathCost();
+		}
+		
+		for (int f = 0; f < feature_count; f++)
+			*features[f]->getSegmentationParameters() = saved[f];
+	}
+	
+	/*---------------*
+	 * Segmentation. *
+	 *---------------*/
+	
+	void SegmenterSweep::sweep(const vector<vector<SegmentationParameters> >& configurations) {
+		SIRENS_TIME_SCOPE("SegmenterSweep::sweep", 0);
+		DenormalGuard guard;
+		
+		modes.assign(configurations.size(), vector<int>());
+		pathCosts.assign(configurations.size(), 0);
+		
+		if (featureSet == NULL || configurations.empty())
+			return;
+		
+		frames = featureSet->getMinHistorySize();
+		
+		if (frames <= 0)
+			return;
+		
+		int feature_count = features.size();
+		int edges = stateCount;
+		
+		if (fastMath) {
+			fastMaxDistributions.resize(feature_count * edges);
+			fastNewDistributions.resize(feature_count * edges * 3);
+			fastY.resize(feature_count * SweepLanes);
+			combinedCosts.resize(getSegmenterStateCount(feature_count - 1) * SweepLanes);
+			residuals.resize(feature_count * 3 * SweepLanes);
+			errors.resize(feature_count * 3 * SweepLanes);
+		}
+		
+		maxDistributions.resize(feature_count * edges);
+		newDistributions.resize(fastMath ? 0 : feature_count * edges * 3);
+		psi.resize((size_t) frames * edges * SweepLanes);
+		y.resize(feature_count * SweepLanes);
+		
+		SIRENS_PEAK("SegmenterSweep::psiBytes", (unsigned long long) frames * edges * SweepLanes * sizeof(int));
+		
+		vector<FeatureSpan> columns(feature_count);
+		
+		for (int f = 0; f < feature_count; f++)
+			columns[f] = features[f]->getHistory(0, frames);
+		
+		for (int first = 0; first < int(configurations.size()); first += SweepLanes) {
+			int count = min(SweepLanes, int(configurations.size()) - first);
+			
+			if (count < getMinGroupSize()) {
+				segmentSeparately(configurations, first, count);
+				continue;
+			}
+			
+			loadGroup(configurations, first);
+			resetGroup();
+			
+			// Each frame's feature values are read once and normalized for every lane.
+			for (int i = 0; i < frames; i++) {
+				for (int f = 0; f < feature_count; f++) {
+					for (int k = 0; k < SweepLanes; k++) {
+						float value = (columns[f].values[i] - offset[f * SweepLanes + k]) * scale[f * SweepLanes + k];
+						
+						if (fastMath)
+							fastY[f * SweepLanes + k] = value;
+						else
+							y[f * SweepLanes + k] = value;
+					}
+				}
+				
+				if (fastMath)
+					viterbiFast(i);
+				else
+					viterbi(i);
+			}
+			
+			traceback(first, count);
+		}
+	}
+	
+	/*---------------------*
+	 * After segmentation. *
+	 *---------------------*/
+	
+	int SegmenterSweep::getConfigurationCount() {
+		return modes.size();
+	}
+	
+	const vector<int>& SegmenterSweep::getModes(int c) {
+		return modes[c];
+	}
+	
+	double SegmenterSweep::getPathCost(int c) {
+		return pathCosts[c];
+	}
+	
+	vector<vector<int> > SegmenterSweep::getSegments(int c) {
+		vector<vector<int> > segments;
+		vector<int> segment(2, 0);
+		
+		SegmentIterator iterator = getSegmentIterator(c);
+		
+		while (iterator.next(segment[0], segment[1]))
+			segments.push_back(segment);
+		
+		return segments;
+	}
+	
+	SegmentIterator SegmenterSweep::getSegmentIterator(int c) {
+		return SegmentIterator(modes[c].empty() ? NULL : &modes[c][0], modes[c].size());
+	}
+}
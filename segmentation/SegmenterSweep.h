@@ -0,0 +1,159 @@
+/*
+	Copyright 2009 Arizona State University
+	
+	This file is part of Sirens.
+	
+	Sirens is free software: you can redistribute it and/or modify it under the terms 
+	of the GNU Lesser General Public License as  published by the Free Software 
+	Foundation, either version 3 of the License, or (at your option) any later version.
+	
+	Sirens is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+	without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR 
+	PURPOSE.  See the GNU General Public License for more details.
+	
+	You should have received a copy of the GNU Lesser General Public License along
+	with Sirens. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef __SEGMENTERSWEEP_H__
+#define __SEGMENTERSWEEP_H__
+
+#include "../FeatureSet.h"
+#include "Segmenter.h"
+#include "SegmentationParameters.h"
+
+#include <vector>
+using namespace std;
+
+/*
+	Segmenting one feature set with many SegmentationParameters configurations, for tuning.
+	
+	Running Segmenter::segment once per configuration repeats everything that does not depend on the parameters:
+	reading the feature columns, looking up the modes of every state, and walking the valid transitions. A
+	SegmenterSweep runs SweepLanes configurations at once instead. Every per-configuration quantity (normalized feature
+	value, Kalman filter mean and covariance, cost, traceback entry) is stored as an array with one slot per lane, so the
+	Kalman updates and the min-plus step over each transition are short fixed-length loops over the lanes.
+	Configurations beyond SweepLanes are run in further groups.
+	
+	Each lane does exactly the arithmetic Segmenter does, in the same order, so a configuration's modes and path cost
+	are identical to those of an exact (no beam, no decimation) Segmenter run with the same parameters, pNew and pOff.
+	That keeps the cost's log scalar, and the lanes in double.
+	
+	Fast mode (setFastMath) gives that up for speed. Lanes are float, and the loops over them are the SIMD lane kernels
+	of support/Kernels.h: the filters, with the covariance update in forms that don't cancel in float; the logs of all
+	of a state's residual variances at once, with the naturalLog kernel (see FastMath.h); a table of the feature costs
+	summed over every combination of previous feature modes, built once per state, which each transition looks up
+	rather than adding its own; and the min-plus step. Path costs then differ from Segmenter's in about the sixth
+	significant digit, which can move a boundary where two paths cost nearly the same.
+	
+	A group of configurations costs about the same however many of its lanes are used, so groups with fewer than
+	getMinGroupSize() configurations (the last one, or all of a small sweep) are segmented one configuration at a time
+	with a Segmenter instead, which is faster for them. This sets the features' segmentation parameters in turn, and
+	restores them afterwards.
+	
+	The traceback table holds an entry per frame, state, and lane, so memory grows with the number of lanes: sweeps are
+	meant for excerpts of a recording rather than hours of it. See ParameterSweep for building configurations from a grid
+	or random search and writing out their segments.
+*/
+
+namespace Sirens {
+	// Number of configurations segmented together.
+	const int SweepLanes = 8;
+	
+	// Kalman filter state for one feature and state, in every lane: in double, or in float in fast mode (which keeps its
+	// costs elsewhere.)
+	template <typename Real>
+	struct SweepDistribution {
+		Real mean[2][SweepLanes];
+		Real covariance[2][2][SweepLanes];
+		Real cost[SweepLanes];
+	};
+	
+	class SegmenterSweep {
+	private:
+		FeatureSet* featureSet;
+		vector<Feature*> features;
+		double pNew, pOff;
+		
+		int frames;
+		int stateCount;
+		
+		// Shared by every configuration.
+		vector<vector<int> > modeMatrix;					// Modes of every feature (and global mode) for each state.
+		vector<vector<int> > validTransitions;				// Previous states that any configuration allows, for each new state.
+		
+		// Parameters of the configurations in the current group, one slot per lane.
+		vector<SegmentationParameters> laneParameters;		// Feature f of lane k is at f * SweepLanes + k.
+		vector<vector<double> > transitionProbabilities;	// Log prior of each valid transition, per lane, for each new state.
+		vector<double> r, alpha;							// Per feature and lane.
+		vector<double> q;									// Per feature, old mode, new mode and lane.
+		vector<float> offset, scale;						// Feature normalization, per feature and lane.
+		
+		// Viterbi.
+		vector<double> y;									// Normalized feature values for the current frame, per feature and lane.
+		vector<SweepDistribution<double> > maxDistributions;	// Per feature and state.
+		vector<SweepDistribution<double> > newDistributions;	// Per feature, state, and previous feature mode.
+		vector<double> oldCosts, newCosts;					// Per state and lane.
+		vector<int> psi;									// Best previous state, per frame, state and lane.
+		double costOffset[SweepLanes];
+		
+		// Fast mode: the same in float, and the tables it adds.
+		bool fastMath;
+		vector<float> fastY, fastR, fastAlpha, fastQ;
+		vector<vector<float> > fastTransitionProbabilities;
+		vector<SweepDistribution<float> > fastMaxDistributions;
+		vector<SweepDistribution<float> > fastNewDistributions;
+		vector<float> fastOldCosts, fastNewCosts;
+		vector<vector<int> > transitionCombinations;		// Previous state's combination of feature modes, per valid transition.
+		vector<float> combinedCosts;						// Summed feature costs, per combination of previous feature modes and lane.
+		vector<float> residuals, errors;					// Filter log residual variances and err^2 / s, per feature, previous mode, and lane.
+		
+		// Segmenting small groups one configuration at a time.
+		Segmenter segmenter;
+		
+		// Results, per configuration.
+		vector<vector<int> > modes;
+		vector<double> pathCosts;
+		
+		void createModeMatrix();
+		void loadGroup(const vector<vector<SegmentationParameters> >& configurations, int first);
+		void resetGroup();
+		void viterbi(int frame);
+		void viterbiFast(int frame);
+		double getFinalCost(int state, int k);
+		void traceback(int first, int count);
+		void segmentSeparately(const vector<vector<SegmentationParameters> >& configurations, int first, int count);
+	
+	public:
+		SegmenterSweep(double p_new = 0, double p_off = 0);
+		~SegmenterSweep();
+		
+		void setFeatureSet(FeatureSet* feature_set);
+		FeatureSet* getFeatureSet();
+		
+		void setPNew(double value);
+		void setPOff(double value);
+		double getPNew();
+		double getPOff();
+		
+		// Fast mode (see above.) Disabled by default.
+		void setFastMath(bool value);
+		bool getFastMath();
+		
+		// Fewest configurations a group needs to be segmented in lanes rather than one at a time.
+		int getMinGroupSize();
+		
+		// Segment the feature set once for every configuration. configurations[c][f] holds the parameters of feature f in
+		// configuration c; the features' own parameters are not used.
+		void sweep(const vector<vector<SegmentationParameters> >& configurations);
+		
+		// Results of configuration c from the last sweep, as from the corresponding Segmenter methods.
+		int getConfigurationCount();
+		const vector<int>& getModes(int c);
+		double getPathCost(int c);
+		vector<vector<int> > getSegments(int c);
+		SegmentIterator getSegmentIterator(int c);
+	};
+}
+
+#endif
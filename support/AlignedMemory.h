@@ -0,0 +1,31 @@
+#ifndef _ALIGNEDMEMORY_H
+#define _ALIGNEDMEMORY_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+
+// Columns and tables that are swept in hot loops start on a cache line boundary.
+const size_t CacheLineSize = 64;
+
+// Allocate count elements aligned to a cache line. The pointer returned by malloc is kept just before the aligned block.
+template <typename T>
+T* allocateAligned(size_t count) {
+	void* raw = malloc(count * sizeof(T) + CacheLineSize + sizeof(void*));
+	
+	if (raw == NULL)
+		throw std::bad_alloc();
+	
+	uintptr_t aligned = (uintptr_t(raw) + sizeof(void*) + CacheLineSize - 1) & ~uintptr_t(CacheLineSize - 1);
+	((void**) aligned)[-1] = raw;
+	
+	return (T*) aligned;
+}
+
+inline void freeAligned(void* pointer) {
+	if (pointer != NULL)
+		free(((void**) pointer)[-1]);
+}
+
+#endif
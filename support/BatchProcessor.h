@@ -0,0 +1,31 @@
+#ifndef _BATCHPROCESSOR_H
+#define _BATCHPROCESSOR_H
+
+#include <cstddef>
+
+/*
+	Batch entry point for in-process hosts (such as Pipeline), implemented by every Sirens plugin alongside process().
+
+	process() has to build a FeatureSet (a map of vectors of Features, each with its own vector of values) for every
+	block, which for the cheap features costs more than the feature itself. processBatch() takes count blocks stored
+	one after another, each of the plugin's block size (count * blockSize values, time-domain samples or spectrum bins
+	as for process()), and writes the values of the plugin's one-sample-per-step outputs into output, a row-major
+	count x getBatchOutputCount() matrix: row i holds block i's values, in the order of getOutputDescriptors().
+
+	Blocks are taken to follow on from whatever was processed before, by either entry point, so process() and
+	processBatch() can be mixed. Variable-rate outputs (Loudness's longer time scales, the skip rates) are not part of
+	the matrix, but their state is still updated: Loudness::getLoudness and the skip rates from getRemainingFeatures()
+	cover batched blocks too.
+*/
+class BatchProcessor {
+public:
+	virtual ~BatchProcessor() {
+	}
+
+	// Number of values each block produces (the columns of processBatch's output.)
+	virtual size_t getBatchOutputCount() const = 0;
+
+	virtual void processBatch(const float* blocks, unsigned int count, float* output) = 0;
+};
+
+#endif
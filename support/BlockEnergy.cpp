@@ -0,0 +1,162 @@
+#include "BlockEnergy.h"
+#include "Kernels.h"
+
+// Below this fraction of the largest recent total, the running total may be mostly rounding error.
+const double BlockEnergy::CancellationLimit = 1e-6;
+
+BlockEnergy::BlockEnergy() {
+	stepSize = 0;
+	blockSize = 0;
+	segmentLength = 0;
+	segmentCount = 0;
+	newSegments = 0;
+	resumInterval = 1;
+	segments = NULL;
+
+	reset();
+}
+
+BlockEnergy::~BlockEnergy() {
+	freeMemory();
+}
+
+void BlockEnergy::freeMemory() {
+	delete [] segments;
+	segments = NULL;
+}
+
+void BlockEnergy::initialize(size_t step_size, size_t block_size) {
+	freeMemory();
+
+	stepSize = step_size;
+	blockSize = block_size;
+
+	if (stepSize > 0 && stepSize < blockSize) {
+		size_t a = blockSize;
+		size_t b = stepSize;
+
+		while (b > 0) {
+			size_t remainder = a % b;
+			a = b;
+			b = remainder;
+		}
+
+		segmentLength = a;
+		segmentCount = blockSize / segmentLength;
+		newSegments = stepSize / segmentLength;
+	} else {
+		segmentLength = blockSize;
+		segmentCount = 1;
+		newSegments = 1;
+	}
+
+	resumInterval = (segmentCount + newSegments - 1) / newSegments;
+	segments = new double[segmentCount];
+
+	reset();
+}
+
+void BlockEnergy::reset() {
+	oldest = 0;
+	sumOfSquares = 0;
+	primed = false;
+	blocksSinceSum = 0;
+	largestSum = 0;
+}
+
+double BlockEnergy::sumSegment(const float* samples) const {
+	// Short segments (a step and block with a small common factor) would spend more on the call than on the sum.
+	if (segmentLength < ShortSegment) {
+		float sum = 0;
+
+		for (size_t i = 0; i < segmentLength; i++)
+			sum += samples[i] * samples[i];
+
+		return sum;
+	}
+
+	return getKernels().sumOfSquares(samples, segmentLength);
+}
+
+// Replace the running total with the exact sum of the ring.
+void BlockEnergy::sumSegments() {
+	// Four partial sums, so the additions don't wait on one another.
+	double partial[4] = {0, 0, 0, 0};
+	size_t i = 0;
+
+	for (; i + 4 <= segmentCount; i += 4) {
+		for (size_t j = 0; j < 4; j++)
+			partial[j] += segments[i + j];
+	}
+
+	for (; i < segmentCount; i++)
+		partial[0] += segments[i];
+
+	sumOfSquares = (partial[0] + partial[1]) + (partial[2] + partial[3]);
+	blocksSinceSum = 0;
+	largestSum = sumOfSquares;
+}
+
+double BlockEnergy::addBlock(const float* block) {
+	if (segments == NULL)
+		return 0;
+
+	if (!primed || segmentCount == 1) {
+		for (size_t i = 0; i < segmentCount; i++)
+			segments[i] = sumSegment(block + i * segmentLength);
+
+		sumSegments();
+
+		oldest = 0;
+		primed = true;
+
+		return sumOfSquares;
+	}
+
+	// The new samples are the last step of the block. Each replaces the earliest segment in the ring, which is walked
+	// in at most two contiguous runs.
+	const float* samples = block + blockSize - stepSize;
+
+	double added = 0;
+	double removed = 0;
+
+	for (size_t done = 0; done < newSegments; ) {
+		size_t run = newSegments - done < segmentCount - oldest ? newSegments - done : segmentCount - oldest;
+		const float* run_samples = samples + done * segmentLength;
+		double* ring = segments + oldest;
+
+		if (segmentLength == 1) {
+			// One sample per segment (a step and block with no common factor.)
+			for (size_t i = 0; i < run; i++) {
+				double segment = run_samples[i] * run_samples[i];
+
+				removed += ring[i];
+				added += segment;
+				ring[i] = segment;
+			}
+		} else {
+			for (size_t i = 0; i < run; i++) {
+				double segment = sumSegment(run_samples + i * segmentLength);
+
+				removed += ring[i];
+				added += segment;
+				ring[i] = segment;
+			}
+		}
+
+		done += run;
+		oldest = oldest + run < segmentCount ? oldest + run : 0;
+	}
+
+	sumOfSquares += added - removed;
+
+	blocksSinceSum ++;
+
+	if (sumOfSquares > largestSum)
+		largestSum = sumOfSquares;
+
+	if (blocksSinceSum >= resumInterval || sumOfSquares < largestSum * CancellationLimit)
+		sumSegments();
+
+	return sumOfSquares;
+}
@@ -0,0 +1,75 @@
+#ifndef _BLOCKENERGY_H
+#define _BLOCKENERGY_H
+
+#include <cstddef>
+
+/*
+	Sum of squares over overlapping blocks (Loudness, TemporalSparsity), squaring only the new samples.
+
+	When the step is smaller than the block, each block shares all but its last step samples with the
+	previous one. The block is split into segments of gcd(step, block) samples whose partial sums are
+	kept in a ring, so a new block only has to square its new samples, and the total is kept as a
+	running sum: each new segment's sum is added and the one it replaces subtracted. That makes a block
+	cost O(step) even when gcd(step, block) is small (step 441 and block 1024 give 1024 segments).
+
+	Subtraction lets rounding error build up, and loses a quiet passage after a loud one to
+	cancellation, so the total is summed afresh from the ring once every segment has been replaced,
+	and whenever it has fallen below CancellationLimit times the largest total since the last exact
+	sum. Both are rare enough that the exact sums add O(step) per block on average.
+
+	This relies on consecutive calls receiving consecutive blocks, as a Vamp host provides them. The
+	first block after initialize() or reset() is summed in full.
+*/
+class BlockEnergy {
+private:
+	size_t stepSize;
+	size_t blockSize;
+
+	size_t segmentLength;	// gcd(step, block) samples, or the whole block when blocks don't overlap.
+	size_t segmentCount;	// Segments per block.
+	size_t newSegments;		// Segments each block adds.
+
+	double* segments;		// Ring of segment sums.
+	size_t oldest;			// Index of the earliest segment in the block.
+	double sumOfSquares;	// Sum of the segments in the ring.
+	bool primed;			// Whether the ring holds the previous block.
+
+	size_t resumInterval;	// Blocks after which every segment has been replaced.
+	size_t blocksSinceSum;	// Blocks since sumOfSquares was last summed exactly.
+	double largestSum;		// Largest sumOfSquares since then.
+
+	static const double CancellationLimit;
+	static const size_t ShortSegment = 16;	// Segments shorter than this are summed inline rather than by the kernel.
+
+	double sumSegment(const float* samples) const;
+	void sumSegments();
+	void freeMemory();
+
+public:
+	BlockEnergy();
+	~BlockEnergy();
+
+	void initialize(size_t step_size, size_t block_size);
+	void reset();
+
+	// Add the next block and return its sum of squares.
+	double addBlock(const float* block);
+
+	double getSumOfSquares() const {
+		return sumOfSquares;
+	}
+
+	double getMeanSquare() const {
+		return blockSize > 0 ? sumOfSquares / double(blockSize) : 0;
+	}
+
+	size_t getStepSize() const {
+		return stepSize;
+	}
+
+	size_t getBlockSize() const {
+		return blockSize;
+	}
+};
+
+#endif
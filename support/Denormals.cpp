@@ -0,0 +1,31 @@
+#include "Denormals.h"
+
+#include <cstring>
+using namespace std;
+
+static const size_t ZeroChunk = 64;
+
+// OR of the bits of count values, sign bits excluded, so -0 counts as zero.
+static inline uint32_t getMagnitudeBits(const float* values, size_t count) {
+	uint32_t bits = 0;
+
+	for (size_t i = 0; i < count; i++) {
+		uint32_t value;
+		memcpy(&value, values + i, sizeof(value));
+		bits |= value;
+	}
+
+	return bits & 0x7fffffff;
+}
+
+bool isZeroBlock(const float* values, size_t count) {
+	size_t i = 0;
+
+	// Whole chunks have a fixed length, so the compiler can unroll and vectorize them.
+	for (; i + ZeroChunk <= count; i += ZeroChunk) {
+		if (getMagnitudeBits(values + i, ZeroChunk) != 0)
+			return false;
+	}
+
+	return getMagnitudeBits(values + i, count - i) == 0;
+}
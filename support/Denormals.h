@@ -0,0 +1,75 @@
+#ifndef _DENORMALS_H
+#define _DENORMALS_H
+
+#include <cstddef>
+#include <cstdint>
+
+#if defined(__SSE__) || defined(_M_X64)
+#include <xmmintrin.h>
+#define SIRENS_DENORMALS_MXCSR
+#elif defined(__aarch64__)
+#define SIRENS_DENORMALS_FPCR
+#endif
+
+/*
+	Scoped flush-to-zero for the plugins' process() and the segmenter.
+
+	Quiet passages bring spectra, filterbank energies and Kalman covariances down into subnormal numbers, which many
+	processors handle one or two orders of magnitude more slowly than normal ones. While a DenormalGuard exists, they are
+	treated as zero: on x86 it sets FTZ (subnormal results are flushed to zero) and DAZ (subnormal inputs are read as
+	zero) in MXCSR, and on 64-bit ARM the FZ bit in FPCR, which does both. The destructor puts back whatever mode the
+	host had, so code outside the guarded scope is unaffected.
+
+	Only SSE and NEON arithmetic is affected; the x87 arithmetic of a 32-bit x86 build without SSE math is not.
+*/
+class DenormalGuard {
+private:
+	uint64_t saved;
+	bool changed;
+
+#if defined(SIRENS_DENORMALS_MXCSR)
+	static const unsigned int Flags = 0x8040;	// FTZ | DAZ.
+#elif defined(SIRENS_DENORMALS_FPCR)
+	static const uint64_t Flags = uint64_t(1) << 24;	// FZ.
+#endif
+
+public:
+	DenormalGuard() : saved(0), changed(false) {
+#if defined(SIRENS_DENORMALS_MXCSR)
+		saved = _mm_getcsr();
+
+		if ((saved & Flags) != Flags) {
+			_mm_setcsr(unsigned(saved) | Flags);
+			changed = true;
+		}
+#elif defined(SIRENS_DENORMALS_FPCR)
+		__asm__ __volatile__("mrs %0, fpcr" : "=r"(saved));
+
+		if ((saved & Flags) != Flags) {
+			__asm__ __volatile__("msr fpcr, %0" : : "r"(saved | Flags));
+			changed = true;
+		}
+#endif
+	}
+
+	~DenormalGuard() {
+		if (!changed)
+			return;
+
+#if defined(SIRENS_DENORMALS_MXCSR)
+		_mm_setcsr(unsigned(saved));
+#elif defined(SIRENS_DENORMALS_FPCR)
+		__asm__ __volatile__("msr fpcr, %0" : : "r"(saved));
+#endif
+	}
+
+	DenormalGuard(const DenormalGuard&) = delete;
+	DenormalGuard& operator=(const DenormalGuard&) = delete;
+};
+
+// Whether all count values are exactly zero (of either sign), so a plugin can return its precomputed output for
+// silence. Values are checked a chunk at a time and the check stops at the first nonzero chunk, so an ordinary block
+// costs only a few loads.
+bool isZeroBlock(const float* values, size_t count);
+
+#endif
@@ -0,0 +1,48 @@
+#include "EnergyPyramid.h"
+
+using namespace std;
+
+void EnergyPyramid::clear() {
+	levels.clear();
+}
+
+void EnergyPyramid::addValue(double value) {
+	if (levels.empty())
+		levels.push_back(vector<double>());
+
+	levels[0].push_back(value);
+
+	// Complete every pair this value finishes, all the way up.
+	for (size_t level = 0; levels[level].size() % 2 == 0; level++) {
+		if (level + 1 == levels.size())
+			levels.push_back(vector<double>());
+
+		const vector<double>& children = levels[level];
+		levels[level + 1].push_back(children[children.size() - 2] + children[children.size() - 1]);
+	}
+}
+
+size_t EnergyPyramid::getSize() const {
+	return levels.empty() ? 0 : levels[0].size();
+}
+
+double EnergyPyramid::getSum(size_t begin, size_t end) const {
+	if (end > getSize())
+		end = getSize();
+
+	double sum = 0;
+
+	// Take the odd values off either end of the range, then move up a level where the rest pair up.
+	for (size_t level = 0; begin < end; level++) {
+		if (begin % 2 == 1)
+			sum += levels[level][begin++];
+
+		if (end % 2 == 1)
+			sum += levels[level][--end];
+
+		begin /= 2;
+		end /= 2;
+	}
+
+	return sum;
+}
@@ -0,0 +1,30 @@
+#ifndef _ENERGYPYRAMID_H
+#define _ENERGYPYRAMID_H
+
+#include <cstddef>
+#include <vector>
+
+/*
+	Binary sum pyramid over a growing sequence of per-frame energies (Loudness).
+
+	Level 0 holds one value per frame and each value of level i + 1 is the sum of a pair in level i.
+	Parents are added as soon as both children exist, so building the pyramid costs O(1) amortized per
+	frame and about twice the memory of the frames themselves. The sum over any range of frames then
+	takes O(log n) additions, however long the recording.
+*/
+class EnergyPyramid {
+private:
+	std::vector<std::vector<double> > levels;
+
+public:
+	void clear();
+	void addValue(double value);
+
+	// Number of frames added.
+	size_t getSize() const;
+
+	// Sum of frames [begin, end), clipped to the frames added.
+	double getSum(size_t begin, size_t end) const;
+};
+
+#endif
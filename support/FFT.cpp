@@ -0,0 +1,84 @@
+#include "FFT.h"
+
+#include <cmath>
+using namespace std;
+
+FFT::FFT(size_t fft_size) {
+	size = fft_size;
+	
+	real = new float[size];
+	imaginary = new float[size];
+	cosines = new float[size / 2 + 1];
+	sines = new float[size / 2 + 1];
+	reversed = new size_t[size];
+	
+	double pi = 2 * asin(1.0);
+	
+	for (size_t i = 0; i < size / 2 + 1; i++) {
+		cosines[i] = cos(2 * pi * i / double(size));
+		sines[i] = -sin(2 * pi * i / double(size));
+	}
+	
+	int bits = 0;
+	
+	while ((size_t(1) << bits) < size)
+		bits ++;
+	
+	for (size_t i = 0; i < size; i++) {
+		reversed[i] = 0;
+		
+		for (int bit = 0; bit < bits; bit++) {
+			if (i & (size_t(1) << bit))
+				reversed[i] |= size_t(1) << (bits - 1 - bit);
+		}
+	}
+}
+
+FFT::~FFT() {
+	delete [] real;
+	delete [] imaginary;
+	delete [] cosines;
+	delete [] sines;
+	delete [] reversed;
+}
+
+size_t FFT::getSize() {
+	return size;
+}
+
+void FFT::magnitudes(const float* input, float* output) {
+	for (size_t i = 0; i < size; i++) {
+		real[reversed[i]] = input[i];
+		imaginary[reversed[i]] = 0;
+	}
+	
+	for (size_t length = 2; length <= size; length *= 2) {
+		size_t half = length / 2;
+		size_t stride = size / length;
+		
+		for (size_t start = 0; start < size; start += length) {
+			for (size_t k = 0; k < half; k++) {
+				float c = cosines[k * stride];
+				float s = sines[k * stride];
+				
+				size_t even = start + k;
+				size_t odd = even + half;
+				
+				float odd_real = real[odd] * c - imaginary[odd] * s;
+				float odd_imaginary = real[odd] * s + imaginary[odd] * c;
+				
+				real[odd] = real[even] - odd_real;
+				imaginary[odd] = imaginary[even] - odd_imaginary;
+				real[even] += odd_real;
+				imaginary[even] += odd_imaginary;
+			}
+		}
+	}
+	
+	for (size_t i = 0; i < size / 2 + 1; i++)
+		output[i] = sqrt(real[i] * real[i] + imaginary[i] * imaginary[i]);
+}
+
+bool FFT::isPowerOfTwo(size_t value) {
+	return value > 0 && (value & (value - 1)) == 0;
+}
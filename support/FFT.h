@@ -0,0 +1,29 @@
+#ifndef _FFT_H
+#define _FFT_H
+
+#include <cstddef>
+
+// In-place iterative radix-2 FFT for plugins that do their own analysis rather than taking the host's spectrum.
+class FFT {
+private:
+	size_t size;
+	
+	float* real;
+	float* imaginary;
+	float* cosines;
+	float* sines;
+	size_t* reversed;
+	
+public:
+	FFT(size_t fft_size);
+	~FFT();
+	
+	size_t getSize();
+	
+	// Magnitudes of bins 0 .. size / 2 of the transform of size real samples.
+	void magnitudes(const float* input, float* output);
+	
+	static bool isPowerOfTwo(size_t value);
+};
+
+#endif
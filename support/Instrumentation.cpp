@@ -0,0 +1,130 @@
+#include "Instrumentation.h"
+
+#include <cstdlib>
+#include <fstream>
+using namespace std;
+
+InstrumentationCounter::InstrumentationCounter(string counter_name) {
+	name = counter_name;
+	reset();
+}
+
+void InstrumentationCounter::recordTime(unsigned long long duration) {
+	int bucket = 0;
+	
+	while (bucket < HistogramBuckets - 1 && (duration >> (bucket + 1)) > 0)
+		bucket ++;
+	
+	calls ++;
+	nanoseconds += duration;
+	histogram[bucket] ++;
+}
+
+void InstrumentationCounter::add(unsigned long long value) {
+	total += value;
+}
+
+void InstrumentationCounter::setPeak(unsigned long long value) {
+	unsigned long long current = peak.load();
+	
+	while (value > current && !peak.compare_exchange_weak(current, value));
+}
+
+void InstrumentationCounter::reset() {
+	calls = 0;
+	nanoseconds = 0;
+	total = 0;
+	peak = 0;
+	
+	for (int i = 0; i < HistogramBuckets; i++)
+		histogram[i] = 0;
+}
+
+// These are never freed, so counters can still be dumped while static objects are being destroyed.
+mutex& Instrumentation::getMutex() {
+	static mutex* instrumentation_mutex = new mutex();
+	return *instrumentation_mutex;
+}
+
+map<string, InstrumentationCounter*>& Instrumentation::getCounters() {
+	static map<string, InstrumentationCounter*>* counters = new map<string, InstrumentationCounter*>();
+	return *counters;
+}
+
+InstrumentationCounter* Instrumentation::getCounter(const string& name) {
+	lock_guard<mutex> lock(getMutex());
+	map<string, InstrumentationCounter*>& counters = getCounters();
+	
+	map<string, InstrumentationCounter*>::iterator item = counters.find(name);
+	
+	if (item != counters.end())
+		return item->second;
+	
+	InstrumentationCounter* counter = new InstrumentationCounter(name);
+	counters[name] = counter;
+	return counter;
+}
+
+vector<string> Instrumentation::getCounterNames() {
+	lock_guard<mutex> lock(getMutex());
+	map<string, InstrumentationCounter*>& counters = getCounters();
+	
+	vector<string> names;
+	
+	for (map<string, InstrumentationCounter*>::iterator item = counters.begin(); item != counters.end(); item++)
+		names.push_back(item->first);
+	
+	return names;
+}
+
+void Instrumentation::reset() {
+	lock_guard<mutex> lock(getMutex());
+	map<string, InstrumentationCounter*>& counters = getCounters();
+	
+	for (map<string, InstrumentationCounter*>::iterator item = counters.begin(); item != counters.end(); item++)
+		item->second->reset();
+}
+
+// One line per counter: name, calls, total ns, mean ns, total, peak, then the nonzero histogram buckets as log2(ns):count.
+void Instrumentation::dump(ostream& stream) {
+	lock_guard<mutex> lock(getMutex());
+	map<string, InstrumentationCounter*>& counters = getCounters();
+	
+	for (map<string, InstrumentationCounter*>::iterator item = counters.begin(); item != counters.end(); item++) {
+		InstrumentationCounter* counter = item->second;
+		unsigned long long calls = counter->calls;
+		unsigned long long nanoseconds = counter->nanoseconds;
+		
+		stream << counter->name
+			<< "\tcalls=" << calls
+			<< "\tns=" << nanoseconds
+			<< "\tmean_ns=" << (calls > 0 ? nanoseconds / calls : 0)
+			<< "\ttotal=" << counter->total
+			<< "\tpeak=" << counter->peak
+			<< "\thistogram=";
+		
+		for (int i = 0; i < InstrumentationCounter::HistogramBuckets; i++) {
+			if (counter->histogram[i] > 0)
+				stream << i << ":" << counter->histogram[i] << " ";
+		}
+		
+		stream << endl;
+	}
+}
+
+#ifdef SIRENS_INSTRUMENTATION
+// Dumps all counters to $SIRENS_INSTRUMENTATION_FILE when the library is unloaded.
+class InstrumentationDumper {
+public:
+	~InstrumentationDumper() {
+		const char* path = getenv("SIRENS_INSTRUMENTATION_FILE");
+		
+		if (path != NULL) {
+			ofstream file(path, ios::app);
+			Instrumentation::dump(file);
+		}
+	}
+};
+
+static InstrumentationDumper instrumentationDumper;
+#endif
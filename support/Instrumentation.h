@@ -0,0 +1,98 @@
+#ifndef _INSTRUMENTATION_H
+#define _INSTRUMENTATION_H
+
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+/*
+	Hot-path instrumentation.
+	
+	Compiled in only when SIRENS_INSTRUMENTATION is defined (see the Makefile); otherwise the macros
+	below expand to nothing and there is no cost. Each named counter records how many times it was hit,
+	the total time spent (with a log2 histogram of nanoseconds per call), a running total of values
+	added to it (e.g. bytes touched or Kalman updates), and the peak value it has been given.
+	
+	Counters can be queried at runtime with Instrumentation::getCounter / getCounterNames, or dumped as
+	text with Instrumentation::dump. If the SIRENS_INSTRUMENTATION_FILE environment variable is set,
+	all counters are dumped to that file when the library is unloaded.
+*/
+
+class InstrumentationCounter {
+public:
+	static const int HistogramBuckets = 40;
+	
+	InstrumentationCounter(std::string counter_name);
+	
+	std::string name;
+	std::atomic<unsigned long long> calls;			// Times the counter was hit.
+	std::atomic<unsigned long long> nanoseconds;	// Total time spent in timed scopes.
+	std::atomic<unsigned long long> total;			// Sum of values added (bytes, updates, etc.)
+	std::atomic<unsigned long long> peak;			// Largest value seen by setPeak.
+	std::atomic<unsigned long long> histogram[HistogramBuckets];	// Calls taking [2^i, 2^(i + 1)) nanoseconds.
+	
+	void recordTime(unsigned long long duration);
+	void add(unsigned long long value);
+	void setPeak(unsigned long long value);
+	void reset();
+};
+
+class Instrumentation {
+private:
+	static std::mutex& getMutex();
+	static std::map<std::string, InstrumentationCounter*>& getCounters();
+	
+public:
+	// Find or create a counter. The returned counter lives as long as the library.
+	static InstrumentationCounter* getCounter(const std::string& name);
+	static std::vector<std::string> getCounterNames();
+	
+	static void reset();
+	static void dump(std::ostream& stream);
+};
+
+// Times a scope and attributes it (and optionally bytes touched) to a counter.
+class InstrumentationTimer {
+private:
+	InstrumentationCounter* counter;
+	std::chrono::steady_clock::time_point start;
+	
+public:
+	InstrumentationTimer(InstrumentationCounter* timer_counter, unsigned long long bytes = 0) {
+		counter = timer_counter;
+		counter->add(bytes);
+		start = std::chrono::steady_clock::now();
+	}
+	
+	~InstrumentationTimer() {
+		counter->recordTime(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count());
+	}
+};
+
+#define SIRENS_INSTRUMENTATION_JOIN2(a, b) a##b
+#define SIRENS_INSTRUMENTATION_JOIN(a, b) SIRENS_INSTRUMENTATION_JOIN2(a, b)
+
+#ifdef SIRENS_INSTRUMENTATION
+	// Time the rest of the enclosing scope, attributing bytes to the counter.
+	#define SIRENS_TIME_SCOPE(name, bytes) \
+		static InstrumentationCounter* SIRENS_INSTRUMENTATION_JOIN(instrumentation_counter_, __LINE__) = Instrumentation::getCounter(name); \
+		InstrumentationTimer SIRENS_INSTRUMENTATION_JOIN(instrumentation_timer_, __LINE__)(SIRENS_INSTRUMENTATION_JOIN(instrumentation_counter_, __LINE__), (bytes))
+	
+	// Add a value to a counter's total.
+	#define SIRENS_COUNT(name, value) \
+		do { static InstrumentationCounter* counter = Instrumentation::getCounter(name); counter->add(value); } while (0)
+	
+	// Keep the largest value given to a counter.
+	#define SIRENS_PEAK(name, value) \
+		do { static InstrumentationCounter* counter = Instrumentation::getCounter(name); counter->setPeak(value); } while (0)
+#else
+	#define SIRENS_TIME_SCOPE(name, bytes)
+	#define SIRENS_COUNT(name, value) do { } while (0)
+	#define SIRENS_PEAK(name, value) do { } while (0)
+#endif
+
+#endif
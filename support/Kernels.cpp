@@ -0,0 +1,1279 @@
+#include "Kernels.h"
+#include "FastMath.h"
+
+#include <cfloat>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+using namespace std;
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define SIRENS_KERNELS_X86
+
+// Some GCC releases warn about the deliberately undefined registers inside their own AVX-512 intrinsics.
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wuninitialized"
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#include <immintrin.h>
+#pragma GCC diagnostic pop
+#endif
+
+#if defined(__aarch64__) && defined(__ARM_NEON)
+#define SIRENS_KERNELS_NEON
+#include <arm_neon.h>
+#endif
+
+// Combine per-lane accumulators into statistics, after adding the bins past the last full vector into lane 0.
+static void finishReduction(const float* spectrum, const float* weights, const float* moments, size_t begin, size_t end, float* max, float* sum, float* power, float* moment, int lanes, SpectrumStatistics& statistics) {
+	for (size_t i = begin; i < end; i++) {
+		float bin = spectrum[i];
+
+		max[0] = max[0] > bin ? max[0] : bin;
+		sum[0] += bin;
+
+		if (weights) {
+			power[0] += bin * bin * weights[i];
+			moment[0] += bin * bin * moments[i];
+		}
+	}
+
+	statistics.max = 0;
+	statistics.sum = 0;
+	statistics.weightedPower = 0;
+	statistics.weightedMoment = 0;
+
+	for (int lane = 0; lane < lanes; lane++) {
+		statistics.max = statistics.max > max[lane] ? statistics.max : max[lane];
+		statistics.sum += sum[lane];
+		statistics.weightedPower += power[lane];
+		statistics.weightedMoment += moment[lane];
+	}
+}
+
+// Scalar.
+
+static double sumOfSquaresScalar(const float* samples, size_t count) {
+	double sum = 0;
+
+	for (size_t i = 0; i < count; i++)
+		sum += samples[i] * samples[i];
+
+	return sum;
+}
+
+static float dotProductScalar(const float* a, const float* b, size_t count) {
+	float sum = 0;
+
+	for (size_t i = 0; i < count; i++)
+		sum += a[i] * b[i];
+
+	return sum;
+}
+
+static void reduceSpectrumScalar(const float* spectrum, const float* weights, const float* moments, size_t count, SpectrumStatistics& statistics) {
+	const int lanes = 4;
+
+	float max[lanes] = {0, 0, 0, 0};
+	float sum[lanes] = {0, 0, 0, 0};
+	float power[lanes] = {0, 0, 0, 0};
+	float moment[lanes] = {0, 0, 0, 0};
+
+	size_t vector_end = count - count % lanes;
+
+	// Independent accumulators per lane, so the compiler can keep them in vector registers.
+	if (weights) {
+		for (size_t i = 0; i < vector_end; i += lanes) {
+			for (int lane = 0; lane < lanes; lane++) {
+				float bin = spectrum[i + lane];
+				float bin_power = bin * bin;
+
+				max[lane] = max[lane] > bin ? max[lane] : bin;
+				sum[lane] += bin;
+				power[lane] += bin_power * weights[i + lane];
+				moment[lane] += bin_power * moments[i + lane];
+			}
+		}
+	} else {
+		for (size_t i = 0; i < vector_end; i += lanes) {
+			for (int lane = 0; lane < lanes; lane++) {
+				float bin = spectrum[i + lane];
+
+				max[lane] = max[lane] > bin ? max[lane] : bin;
+				sum[lane] += bin;
+			}
+		}
+	}
+
+	finishReduction(spectrum, weights, moments, vector_end, count, max, sum, power, moment, lanes, statistics);
+}
+
+static size_t findPeaksScalar(const float* spectrum, size_t begin, size_t end, size_t radius, int* indices) {
+	size_t count = 0;
+
+	for (size_t k = begin; k < end; k++) {
+		float maxel = 0;
+
+		for (size_t i = k - radius; i <= k + radius; i++) {
+			if (maxel < spectrum[i])
+				maxel = spectrum[i];
+		}
+
+		if (spectrum[k] >= maxel)
+			indices[count++] = int(k);
+	}
+
+	return count;
+}
+
+static void decimateHalfbandScalar(const float* input, const float* coefficients, size_t taps, float* output, size_t count) {
+	for (size_t i = 0; i < count; i++) {
+		const float* center = input + 2 * i;
+		float sum = 0.5f * center[0];
+
+		for (size_t t = 0; t < taps; t++)
+			sum += coefficients[t] * (center[-1 - 2 * ptrdiff_t(t)] + center[1 + 2 * t]);
+
+		output[i] = sum;
+	}
+}
+
+static void naturalLogScalar(const float* x, float* y, size_t count) {
+	for (size_t i = 0; i < count; i++)
+		y[i] = fastLog(x[i]);
+}
+
+static void exponentialScalar(const float* x, float* y, size_t count) {
+	for (size_t i = 0; i < count; i++)
+		y[i] = fastExp(x[i]);
+}
+
+static void filterLanesScalar(const float* prior, float* posterior, const float* y, const float* r, const float* q, const float* alpha, float* residual, float* error, size_t lanes) {
+	for (size_t k = 0; k < lanes; k++) {
+		float x0 = prior[k], x1 = prior[lanes + k];
+		float p00 = prior[2 * lanes + k], p01 = prior[3 * lanes + k], p10 = prior[4 * lanes + k], p11 = prior[5 * lanes + k];
+		float a = alpha[k], b = 1 - a;
+
+		// Prediction and its covariance.
+		float x_1 = b * x0 + a * x1;
+		float p_00 = p00 + q[k];
+		float p_10 = b * p_00 + a * p10;
+		float p_11 = b * b * p_00 + a * (2 * b * p01 + a * p11);
+
+		// Lowpass filter error, residual variance, and Kalman gain.
+		float err = y[k] - x_1;
+		float s = p_11 + r[k];
+		float k0 = p_10 / s;
+		float k1 = p_11 / s;
+		float r_s = r[k] / s;
+
+		posterior[k] = x0 + k0 * err;
+		posterior[lanes + k] = x_1 + k1 * err;
+		posterior[2 * lanes + k] = (p_00 * (a * a * p11 + r[k]) - a * a * p10 * p10) / s;
+		posterior[3 * lanes + k] = p_10 * r_s;
+		posterior[4 * lanes + k] = p_10 * r_s;
+		posterior[5 * lanes + k] = p_11 * r_s;
+
+		residual[k] = s;
+		error[k] = err * err / s;
+	}
+}
+
+// Going down from the last combination, each is read before it is overwritten.
+static void combineCostsScalar(float* combined, size_t combinations, const float* logs, const float* errors, size_t lanes) {
+	for (size_t k = 0; k < lanes; k++) {
+		float cost[3];
+
+		for (size_t m = 0; m < 3; m++)
+			cost[m] = 0.5f * (logs[m * lanes + k] + errors[m * lanes + k]);
+
+		for (size_t c = combinations; c-- > 0;) {
+			float previous = combined[c * lanes + k];
+
+			for (size_t m = 3; m-- > 0;)
+				combined[(3 * c + m) * lanes + k] = previous + cost[m];
+		}
+	}
+}
+
+static void minPlusLanesScalar(const float* old_costs, const int* states, const float* combined, const int* combinations, const float* probabilities, size_t count, size_t lanes, float* minimum_cost, int* minimum_state) {
+	for (size_t k = 0; k < lanes; k++) {
+		float minimum = INFINITY;
+		int state = 0;
+
+		for (size_t i = 0; i < count; i++) {
+			float cost = old_costs[states[i] * lanes + k] + combined[combinations[i] * lanes + k] - probabilities[i * lanes + k];
+
+			if (cost < minimum) {
+				minimum = cost;
+				state = states[i];
+			}
+		}
+
+		minimum_cost[k] = minimum;
+		minimum_state[k] = state;
+	}
+}
+
+// With SIRENS_EXACT_MATH, every table uses the scalar math kernels, which then call the C library.
+#ifdef SIRENS_EXACT_MATH
+#define SIRENS_MATH_KERNELS(isa) naturalLogScalar, exponentialScalar
+#else
+#define SIRENS_MATH_KERNELS(isa) naturalLog##isa, exponential##isa
+#endif
+
+static const KernelTable ScalarKernels = {"scalar", sumOfSquaresScalar, dotProductScalar, reduceSpectrumScalar, findPeaksScalar, decimateHalfbandScalar, SIRENS_MATH_KERNELS(Scalar), filterLanesScalar, combineCostsScalar, minPlusLanesScalar};
+
+#ifdef SIRENS_KERNELS_X86
+
+// Append k + lane for each bit set in mask.
+static inline size_t appendPeaks(unsigned int mask, size_t k, int* indices, size_t count) {
+	while (mask != 0) {
+		indices[count++] = int(k + __builtin_ctz(mask));
+		mask &= mask - 1;
+	}
+
+	return count;
+}
+
+// SSE2.
+
+__attribute__((target("sse2")))
+static double sumOfSquaresSse2(const float* samples, size_t count) {
+	__m128d low = _mm_setzero_pd();
+	__m128d high = _mm_setzero_pd();
+	size_t i = 0;
+
+	for (; i + 4 <= count; i += 4) {
+		__m128 x = _mm_loadu_ps(samples + i);
+		__m128 square = _mm_mul_ps(x, x);
+
+		low = _mm_add_pd(low, _mm_cvtps_pd(square));
+		high = _mm_add_pd(high, _mm_cvtps_pd(_mm_movehl_ps(square, square)));
+	}
+
+	double lanes[2];
+	_mm_storeu_pd(lanes, _mm_add_pd(low, high));
+
+	return lanes[0] + lanes[1] + sumOfSquaresScalar(samples + i, count - i);
+}
+
+__attribute__((target("sse2")))
+static float dotProductSse2(const float* a, const float* b, size_t count) {
+	__m128 sum = _mm_setzero_ps();
+	size_t i = 0;
+
+	for (; i + 4 <= count; i += 4)
+		sum = _mm_add_ps(sum, _mm_mul_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i)));
+
+	float lanes[4];
+	_mm_storeu_ps(lanes, sum);
+
+	return (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]) + dotProductScalar(a + i, b + i, count - i);
+}
+
+__attribute__((target("sse2")))
+static void reduceSpectrumSse2(const float* spectrum, const float* weights, const float* moments, size_t count, SpectrumStatistics& statistics) {
+	__m128 max = _mm_setzero_ps();
+	__m128 sum = _mm_setzero_ps();
+	__m128 power = _mm_setzero_ps();
+	__m128 moment = _mm_setzero_ps();
+	size_t i = 0;
+
+	if (weights) {
+		for (; i + 4 <= count; i += 4) {
+			__m128 bin = _mm_loadu_ps(spectrum + i);
+			__m128 bin_power = _mm_mul_ps(bin, bin);
+
+			max = _mm_max_ps(max, bin);
+			sum = _mm_add_ps(sum, bin);
+			power = _mm_add_ps(power, _mm_mul_ps(bin_power, _mm_loadu_ps(weights + i)));
+			moment = _mm_add_ps(moment, _mm_mul_ps(bin_power, _mm_loadu_ps(moments + i)));
+		}
+	} else {
+		for (; i + 4 <= count; i += 4) {
+			__m128 bin = _mm_loadu_ps(spectrum + i);
+
+			max = _mm_max_ps(max, bin);
+			sum = _mm_add_ps(sum, bin);
+		}
+	}
+
+	float max_lanes[4], sum_lanes[4], power_lanes[4], moment_lanes[4];
+	_mm_storeu_ps(max_lanes, max);
+	_mm_storeu_ps(sum_lanes, sum);
+	_mm_storeu_ps(power_lanes, power);
+	_mm_storeu_ps(moment_lanes, moment);
+
+	finishReduction(spectrum, weights, moments, i, count, max_lanes, sum_lanes, power_lanes, moment_lanes, 4, statistics);
+}
+
+__attribute__((target("sse2")))
+static size_t findPeaksSse2(const float* spectrum, size_t begin, size_t end, size_t radius, int* indices) {
+	size_t count = 0;
+	size_t k = begin;
+
+	for (; k + 4 <= end; k += 4) {
+		__m128 maxel = _mm_setzero_ps();
+
+		for (size_t i = k - radius; i <= k + radius; i++)
+			maxel = _mm_max_ps(maxel, _mm_loadu_ps(spectrum + i));
+
+		count = appendPeaks(_mm_movemask_ps(_mm_cmpge_ps(_mm_loadu_ps(spectrum + k), maxel)), k, indices, count);
+	}
+
+	return count + findPeaksScalar(spectrum, k, end, radius, indices + count);
+}
+
+// Every other value, starting with x[0], of the 8 at x.
+__attribute__((target("sse2")))
+static inline __m128 loadEvenSse2(const float* x) {
+	return _mm_shuffle_ps(_mm_loadu_ps(x), _mm_loadu_ps(x + 4), _MM_SHUFFLE(2, 0, 2, 0));
+}
+
+__attribute__((target("sse2")))
+static void decimateHalfbandSse2(const float* input, const float* coefficients, size_t taps, float* output, size_t count) {
+	const __m128 half = _mm_set1_ps(0.5f);
+	size_t i = 0;
+
+	for (; i + 4 <= count; i += 4) {
+		const float* center = input + 2 * i;
+		__m128 sum = _mm_mul_ps(half, loadEvenSse2(center));
+
+		for (size_t t = 0; t < taps; t++) {
+			__m128 pair = _mm_add_ps(loadEvenSse2(center - 1 - 2 * ptrdiff_t(t)), loadEvenSse2(center + 1 + 2 * t));
+			sum = _mm_add_ps(sum, _mm_mul_ps(_mm_set1_ps(coefficients[t]), pair));
+		}
+
+		_mm_storeu_ps(output + i, sum);
+	}
+
+	decimateHalfbandScalar(input + 2 * i, coefficients, taps, output + i, count - i);
+}
+
+#ifndef SIRENS_EXACT_MATH
+
+__attribute__((target("sse2")))
+static inline __m128 logSse2(__m128 x) {
+	using namespace FastMath;
+
+	__m128 invalid = _mm_cmple_ps(x, _mm_setzero_ps());
+	__m128i bits = _mm_castps_si128(_mm_max_ps(x, _mm_set1_ps(FLT_MIN)));
+
+	// x = m * 2^e with m in [sqrt(0.5), sqrt(2)).
+	__m128 e = _mm_cvtepi32_ps(_mm_sub_epi32(_mm_srli_epi32(bits, 23), _mm_set1_epi32(127)));
+	__m128 m = _mm_castsi128_ps(_mm_or_si128(_mm_and_si128(bits, _mm_set1_epi32(0x007fffff)), _mm_set1_epi32(0x3f800000)));
+	__m128 large = _mm_cmpgt_ps(m, _mm_set1_ps(Sqrt2));
+
+	m = _mm_sub_ps(m, _mm_and_ps(large, _mm_mul_ps(m, _mm_set1_ps(0.5f))));
+	e = _mm_add_ps(e, _mm_and_ps(large, _mm_set1_ps(1.0f)));
+
+	__m128 f = _mm_sub_ps(m, _mm_set1_ps(1.0f));
+	__m128 z = _mm_mul_ps(f, f);
+	__m128 p = _mm_set1_ps(LogCoefficients[0]);
+
+	for (int i = 1; i < LogTerms; i++)
+		p = _mm_add_ps(_mm_mul_ps(p, f), _mm_set1_ps(LogCoefficients[i]));
+
+	__m128 y = _mm_sub_ps(_mm_add_ps(_mm_mul_ps(_mm_mul_ps(p, f), z), _mm_mul_ps(_mm_set1_ps(Ln2Low), e)), _mm_mul_ps(_mm_set1_ps(0.5f), z));
+	__m128 result = _mm_add_ps(_mm_add_ps(f, y), _mm_mul_ps(_mm_set1_ps(Ln2High), e));
+
+	return _mm_or_ps(_mm_andnot_ps(invalid, result), _mm_and_ps(invalid, _mm_set1_ps(-INFINITY)));
+}
+
+__attribute__((target("sse2")))
+static inline __m128 expSse2(__m128 x) {
+	using namespace FastMath;
+
+	__m128 underflow = _mm_cmplt_ps(x, _mm_set1_ps(ExpMin));
+	x = _mm_max_ps(_mm_min_ps(x, _mm_set1_ps(ExpMax)), _mm_set1_ps(ExpMin));
+
+	// x = n * ln(2) + r with |r| <= ln(2) / 2.
+	__m128i n = _mm_cvtps_epi32(_mm_mul_ps(x, _mm_set1_ps(Log2e)));
+	__m128 n_float = _mm_cvtepi32_ps(n);
+	__m128 r = _mm_sub_ps(_mm_sub_ps(x, _mm_mul_ps(n_float, _mm_set1_ps(Ln2High))), _mm_mul_ps(n_float, _mm_set1_ps(Ln2Low)));
+	__m128 p = _mm_set1_ps(ExpCoefficients[0]);
+
+	for (int i = 1; i < ExpTerms; i++)
+		p = _mm_add_ps(_mm_mul_ps(p, r), _mm_set1_ps(ExpCoefficients[i]));
+
+	__m128 y = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_mul_ps(p, r), r), r), _mm_set1_ps(1.0f));
+	__m128 scale = _mm_castsi128_ps(_mm_slli_epi32(_mm_add_epi32(n, _mm_set1_epi32(127)), 23));
+
+	return _mm_andnot_ps(underflow, _mm_mul_ps(y, scale));
+}
+
+__attribute__((target("sse2")))
+static void naturalLogSse2(const float* x, float* y, size_t count) {
+	size_t i = 0;
+
+	for (; i + 4 <= count; i += 4)
+		_mm_storeu_ps(y + i, logSse2(_mm_loadu_ps(x + i)));
+
+	naturalLogScalar(x + i, y + i, count - i);
+}
+
+__attribute__((target("sse2")))
+static void exponentialSse2(const float* x, float* y, size_t count) {
+	size_t i = 0;
+
+	for (; i + 4 <= count; i += 4)
+		_mm_storeu_ps(y + i, expSse2(_mm_loadu_ps(x + i)));
+
+	exponentialScalar(x + i, y + i, count - i);
+}
+
+#endif
+
+__attribute__((target("sse2")))
+static void filterLanesSse2(const float* prior, float* posterior, const float* y, const float* r, const float* q, const float* alpha, float* residual, float* error, size_t lanes) {
+	const __m128 one = _mm_set1_ps(1.0f);
+	const __m128 two = _mm_set1_ps(2.0f);
+
+	for (size_t k = 0; k < lanes; k += 4) {
+		__m128 x0 = _mm_loadu_ps(prior + k), x1 = _mm_loadu_ps(prior + lanes + k);
+		__m128 p00 = _mm_loadu_ps(prior + 2 * lanes + k), p01 = _mm_loadu_ps(prior + 3 * lanes + k), p10 = _mm_loadu_ps(prior + 4 * lanes + k), p11 = _mm_loadu_ps(prior + 5 * lanes + k);
+		__m128 a = _mm_loadu_ps(alpha + k), b = _mm_sub_ps(one, a), r_k = _mm_loadu_ps(r + k);
+		__m128 aa = _mm_mul_ps(a, a);
+
+		// Prediction and its covariance.
+		__m128 x_1 = _mm_add_ps(_mm_mul_ps(b, x0), _mm_mul_ps(a, x1));
+		__m128 p_00 = _mm_add_ps(p00, _mm_loadu_ps(q + k));
+		__m128 p_10 = _mm_add_ps(_mm_mul_ps(b, p_00), _mm_mul_ps(a, p10));
+		__m128 p_11 = _mm_add_ps(_mm_mul_ps(_mm_mul_ps(b, b), p_00), _mm_mul_ps(a, _mm_add_ps(_mm_mul_ps(_mm_mul_ps(two, b), p01), _mm_mul_ps(a, p11))));
+
+		// Lowpass filter error, residual variance, and Kalman gain.
+		__m128 err = _mm_sub_ps(_mm_loadu_ps(y + k), x_1);
+		__m128 s = _mm_add_ps(p_11, r_k);
+		__m128 k0 = _mm_div_ps(p_10, s);
+		__m128 k1 = _mm_div_ps(p_11, s);
+		__m128 r_s = _mm_div_ps(r_k, s);
+
+		_mm_storeu_ps(posterior + k, _mm_add_ps(x0, _mm_mul_ps(k0, err)));
+		_mm_storeu_ps(posterior + lanes + k, _mm_add_ps(x_1, _mm_mul_ps(k1, err)));
+		_mm_storeu_ps(posterior + 2 * lanes + k, _mm_div_ps(_mm_sub_ps(_mm_mul_ps(p_00, _mm_add_ps(_mm_mul_ps(aa, p11), r_k)), _mm_mul_ps(_mm_mul_ps(aa, p10), p10)), s));
+		_mm_storeu_ps(posterior + 3 * lanes + k, _mm_mul_ps(p_10, r_s));
+		_mm_storeu_ps(posterior + 4 * lanes + k, _mm_mul_ps(p_10, r_s));
+		_mm_storeu_ps(posterior + 5 * lanes + k, _mm_mul_ps(p_11, r_s));
+
+		_mm_storeu_ps(residual + k, s);
+		_mm_storeu_ps(error + k, _mm_div_ps(_mm_mul_ps(err, err), s));
+	}
+}
+
+__attribute__((target("sse2")))
+static void combineCostsSse2(float* combined, size_t combinations, const float* logs, const float* errors, size_t lanes) {
+	const __m128 half = _mm_set1_ps(0.5f);
+
+	for (size_t k = 0; k < lanes; k += 4) {
+		__m128 cost_0 = _mm_mul_ps(half, _mm_add_ps(_mm_loadu_ps(logs + k), _mm_loadu_ps(errors + k)));
+		__m128 cost_1 = _mm_mul_ps(half, _mm_add_ps(_mm_loadu_ps(logs + lanes + k), _mm_loadu_ps(errors + lanes + k)));
+		__m128 cost_2 = _mm_mul_ps(half, _mm_add_ps(_mm_loadu_ps(logs + 2 * lanes + k), _mm_loadu_ps(errors + 2 * lanes + k)));
+
+		for (size_t c = combinations; c-- > 0;) {
+			__m128 previous = _mm_loadu_ps(combined + c * lanes + k);
+			float* extended = combined + 3 * c * lanes + k;
+
+			_mm_storeu_ps(extended + 2 * lanes, _mm_add_ps(previous, cost_2));
+			_mm_storeu_ps(extended + lanes, _mm_add_ps(previous, cost_1));
+			_mm_storeu_ps(extended, _mm_add_ps(previous, cost_0));
+		}
+	}
+}
+
+// States are compared as floats, so that choosing between them takes the same instructions as choosing between costs.
+__attribute__((target("sse2")))
+static void minPlusLanesSse2(const float* old_costs, const int* states, const float* combined, const int* combinations, const float* probabilities, size_t count, size_t lanes, float* minimum_cost, int* minimum_state) {
+	for (size_t k = 0; k < lanes; k += 4) {
+		__m128 minimum = _mm_set1_ps(INFINITY);
+		__m128 state = _mm_set1_ps(0.0f);
+
+		for (size_t i = 0; i < count; i++) {
+			__m128 cost = _mm_sub_ps(_mm_add_ps(_mm_loadu_ps(old_costs + states[i] * lanes + k), _mm_loadu_ps(combined + combinations[i] * lanes + k)), _mm_loadu_ps(probabilities + i * lanes + k));
+			__m128 better = _mm_cmplt_ps(cost, minimum);
+
+			minimum = _mm_or_ps(_mm_and_ps(better, cost), _mm_andnot_ps(better, minimum));
+			state = _mm_or_ps(_mm_and_ps(better, _mm_set1_ps(float(states[i]))), _mm_andnot_ps(better, state));
+		}
+
+		_mm_storeu_ps(minimum_cost + k, minimum);
+		_mm_storeu_si128((__m128i*) (minimum_state + k), _mm_cvttps_epi32(state));
+	}
+}
+
+static const KernelTable Sse2Kernels = {"sse2", sumOfSquaresSse2, dotProductSse2, reduceSpectrumSse2, findPeaksSse2, decimateHalfbandSse2, SIRENS_MATH_KERNELS(Sse2), filterLanesSse2, combineCostsSse2, minPlusLanesSse2};
+
+// AVX2 and FMA. GCC doesn't always clear the upper halves of the registers before leaving a function, which makes
+// any SSE code that runs afterwards (libm included) much slower, so the functions that return through plain code
+// clear them explicitly.
+
+__attribute__((target("avx2,fma")))
+static double sumOfSquaresAvx2(const float* samples, size_t count) {
+	__m256d low = _mm256_setzero_pd();
+	__m256d high = _mm256_setzero_pd();
+	size_t i = 0;
+
+	for (; i + 8 <= count; i += 8) {
+		__m256 x = _mm256_loadu_ps(samples + i);
+		__m256 square = _mm256_mul_ps(x, x);
+
+		low = _mm256_add_pd(low, _mm256_cvtps_pd(_mm256_castps256_ps128(square)));
+		high = _mm256_add_pd(high, _mm256_cvtps_pd(_mm256_extractf128_ps(square, 1)));
+	}
+
+	double lanes[4];
+	_mm256_storeu_pd(lanes, _mm256_add_pd(low, high));
+
+	return (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]) + sumOfSquaresScalar(samples + i, count - i);
+}
+
+__attribute__((target("avx2,fma")))
+static float dotProductAvx2(const float* a, const float* b, size_t count) {
+	__m256 sum = _mm256_setzero_ps();
+	size_t i = 0;
+
+	for (; i + 8 <= count; i += 8)
+		sum = _mm256_fmadd_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i), sum);
+
+	__m128 half = _mm_add_ps(_mm256_castps256_ps128(sum), _mm256_extractf128_ps(sum, 1));
+	float lanes[4];
+	_mm_storeu_ps(lanes, half);
+
+	return (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]) + dotProductScalar(a + i, b + i, count - i);
+}
+
+__attribute__((target("avx2,fma")))
+static void reduceSpectrumAvx2(const float* spectrum, const float* weights, const float* moments, size_t count, SpectrumStatistics& statistics) {
+	__m256 max = _mm256_setzero_ps();
+	__m256 sum = _mm256_setzero_ps();
+	__m256 power = _mm256_setzero_ps();
+	__m256 moment = _mm256_setzero_ps();
+	size_t i = 0;
+
+	if (weights) {
+		for (; i + 8 <= count; i += 8) {
+			__m256 bin = _mm256_loadu_ps(spectrum + i);
+			__m256 bin_power = _mm256_mul_ps(bin, bin);
+
+			max = _mm256_max_ps(max, bin);
+			sum = _mm256_add_ps(sum, bin);
+			power = _mm256_fmadd_ps(bin_power, _mm256_loadu_ps(weights + i), power);
+			moment = _mm256_fmadd_ps(bin_power, _mm256_loadu_ps(moments + i), moment);
+		}
+	} else {
+		for (; i + 8 <= count; i += 8) {
+			__m256 bin = _mm256_loadu_ps(spectrum + i);
+
+			max = _mm256_max_ps(max, bin);
+			sum = _mm256_add_ps(sum, bin);
+		}
+	}
+
+	float max_lanes[8], sum_lanes[8], power_lanes[8], moment_lanes[8];
+	_mm256_storeu_ps(max_lanes, max);
+	_mm256_storeu_ps(sum_lanes, sum);
+	_mm256_storeu_ps(power_lanes, power);
+	_mm256_storeu_ps(moment_lanes, moment);
+	_mm256_zeroupper();
+
+	finishReduction(spectrum, weights, moments, i, count, max_lanes, sum_lanes, power_lanes, moment_lanes, 8, statistics);
+}
+
+__attribute__((target("avx2,fma")))
+static size_t findPeaksAvx2(const float* spectrum, size_t begin, size_t end, size_t radius, int* indices) {
+	size_t count = 0;
+	size_t k = begin;
+
+	for (; k + 8 <= end; k += 8) {
+		__m256 maxel = _mm256_setzero_ps();
+
+		for (size_t i = k - radius; i <= k + radius; i++)
+			maxel = _mm256_max_ps(maxel, _mm256_loadu_ps(spectrum + i));
+
+		count = appendPeaks(_mm256_movemask_ps(_mm256_cmp_ps(_mm256_loadu_ps(spectrum + k), maxel, _CMP_GE_OQ)), k, indices, count);
+	}
+
+	_mm256_zeroupper();
+
+	return count + findPeaksSse2(spectrum, k, end, radius, indices + count);
+}
+
+// Every other value, starting with x[0], of the 16 at x.
+__attribute__((target("avx2,fma")))
+static inline __m256 loadEvenAvx2(const float* x) {
+	__m256 pairs = _mm256_shuffle_ps(_mm256_loadu_ps(x), _mm256_loadu_ps(x + 8), _MM_SHUFFLE(2, 0, 2, 0));
+	return _mm256_castpd_ps(_mm256_permute4x64_pd(_mm256_castps_pd(pairs), _MM_SHUFFLE(3, 1, 2, 0)));
+}
+
+__attribute__((target("avx2,fma")))
+static void decimateHalfbandAvx2(const float* input, const float* coefficients, size_t taps, float* output, size_t count) {
+	const __m256 half = _mm256_set1_ps(0.5f);
+	size_t i = 0;
+
+	for (; i + 8 <= count; i += 8) {
+		const float* center = input + 2 * i;
+		__m256 sum = _mm256_mul_ps(half, loadEvenAvx2(center));
+
+		for (size_t t = 0; t < taps; t++) {
+			__m256 pair = _mm256_add_ps(loadEvenAvx2(center - 1 - 2 * ptrdiff_t(t)), loadEvenAvx2(center + 1 + 2 * t));
+			sum = _mm256_fmadd_ps(_mm256_set1_ps(coefficients[t]), pair, sum);
+		}
+
+		_mm256_storeu_ps(output + i, sum);
+	}
+
+	_mm256_zeroupper();
+	decimateHalfbandSse2(input + 2 * i, coefficients, taps, output + i, count - i);
+}
+
+#ifndef SIRENS_EXACT_MATH
+
+__attribute__((target("avx2,fma")))
+static inline __m256 logAvx2(__m256 x) {
+	using namespace FastMath;
+
+	__m256 invalid = _mm256_cmp_ps(x, _mm256_setzero_ps(), _CMP_LE_OQ);
+	__m256i bits = _mm256_castps_si256(_mm256_max_ps(x, _mm256_set1_ps(FLT_MIN)));
+
+	// x = m * 2^e with m in [sqrt(0.5), sqrt(2)).
+	__m256 e = _mm256_cvtepi32_ps(_mm256_sub_epi32(_mm256_srli_epi32(bits, 23), _mm256_set1_epi32(127)));
+	__m256 m = _mm256_castsi256_ps(_mm256_or_si256(_mm256_and_si256(bits, _mm256_set1_epi32(0x007fffff)), _mm256_set1_epi32(0x3f800000)));
+	__m256 large = _mm256_cmp_ps(m, _mm256_set1_ps(Sqrt2), _CMP_GT_OQ);
+
+	m = _mm256_blendv_ps(m, _mm256_mul_ps(m, _mm256_set1_ps(0.5f)), large);
+	e = _mm256_add_ps(e, _mm256_and_ps(large, _mm256_set1_ps(1.0f)));
+
+	__m256 f = _mm256_sub_ps(m, _mm256_set1_ps(1.0f));
+	__m256 z = _mm256_mul_ps(f, f);
+	__m256 p = _mm256_set1_ps(LogCoefficients[0]);
+
+	for (int i = 1; i < LogTerms; i++)
+		p = _mm256_fmadd_ps(p, f, _mm256_set1_ps(LogCoefficients[i]));
+
+	__m256 y = _mm256_sub_ps(_mm256_fmadd_ps(_mm256_mul_ps(p, f), z, _mm256_mul_ps(_mm256_set1_ps(Ln2Low), e)), _mm256_mul_ps(_mm256_set1_ps(0.5f), z));
+	__m256 result = _mm256_fmadd_ps(_mm256_set1_ps(Ln2High), e, _mm256_add_ps(f, y));
+
+	return _mm256_blendv_ps(result, _mm256_set1_ps(-INFINITY), invalid);
+}
+
+__attribute__((target("avx2,fma")))
+static inline __m256 expAvx2(__m256 x) {
+	using namespace FastMath;
+
+	__m256 underflow = _mm256_cmp_ps(x, _mm256_set1_ps(ExpMin), _CMP_LT_OQ);
+	x = _mm256_max_ps(_mm256_min_ps(x, _mm256_set1_ps(ExpMax)), _mm256_set1_ps(ExpMin));
+
+	// x = n * ln(2) + r with |r| <= ln(2) / 2.
+	__m256i n = _mm256_cvtps_epi32(_mm256_mul_ps(x, _mm256_set1_ps(Log2e)));
+	__m256 n_float = _mm256_cvtepi32_ps(n);
+	__m256 r = _mm256_fnmadd_ps(n_float, _mm256_set1_ps(Ln2Low), _mm256_fnmadd_ps(n_float, _mm256_set1_ps(Ln2High), x));
+	__m256 p = _mm256_set1_ps(ExpCoefficients[0]);
+
+	for (int i = 1; i < ExpTerms; i++)
+		p = _mm256_fmadd_ps(p, r, _mm256_set1_ps(ExpCoefficients[i]));
+
+	__m256 y = _mm256_add_ps(_mm256_fmadd_ps(_mm256_mul_ps(p, r), r, r), _mm256_set1_ps(1.0f));
+	__m256 scale = _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_add_epi32(n, _mm256_set1_epi32(127)), 23));
+
+	return _mm256_andnot_ps(underflow, _mm256_mul_ps(y, scale));
+}
+
+__attribute__((target("avx2,fma")))
+static void naturalLogAvx2(const float* x, float* y, size_t count) {
+	size_t i = 0;
+
+	for (; i + 8 <= count; i += 8)
+		_mm256_storeu_ps(y + i, logAvx2(_mm256_loadu_ps(x + i)));
+
+	_mm256_zeroupper();
+	naturalLogScalar(x + i, y + i, count - i);
+}
+
+__attribute__((target("avx2,fma")))
+static void exponentialAvx2(const float* x, float* y, size_t count) {
+	size_t i = 0;
+
+	for (; i + 8 <= count; i += 8)
+		_mm256_storeu_ps(y + i, expAvx2(_mm256_loadu_ps(x + i)));
+
+	_mm256_zeroupper();
+	exponentialScalar(x + i, y + i, count - i);
+}
+
+#endif
+
+__attribute__((target("avx2,fma")))
+static void filterLanesAvx2(const float* prior, float* posterior, const float* y, const float* r, const float* q, const float* alpha, float* residual, float* error, size_t lanes) {
+	const __m256 one = _mm256_set1_ps(1.0f);
+	const __m256 two = _mm256_set1_ps(2.0f);
+
+	for (size_t k = 0; k < lanes; k += 8) {
+		__m256 x0 = _mm256_loadu_ps(prior + k), x1 = _mm256_loadu_ps(prior + lanes + k);
+		__m256 p00 = _mm256_loadu_ps(prior + 2 * lanes + k), p01 = _mm256_loadu_ps(prior + 3 * lanes + k), p10 = _mm256_loadu_ps(prior + 4 * lanes + k), p11 = _mm256_loadu_ps(prior + 5 * lanes + k);
+		__m256 a = _mm256_loadu_ps(alpha + k), b = _mm256_sub_ps(one, a), r_k = _mm256_loadu_ps(r + k);
+		__m256 aa = _mm256_mul_ps(a, a);
+
+		// Prediction and its covariance.
+		__m256 x_1 = _mm256_add_ps(_mm256_mul_ps(b, x0), _mm256_mul_ps(a, x1));
+		__m256 p_00 = _mm256_add_ps(p00, _mm256_loadu_ps(q + k));
+		__m256 p_10 = _mm256_add_ps(_mm256_mul_ps(b, p_00), _mm256_mul_ps(a, p10));
+		__m256 p_11 = _mm256_add_ps(_mm256_mul_ps(_mm256_mul_ps(b, b), p_00), _mm256_mul_ps(a, _mm256_add_ps(_mm256_mul_ps(_mm256_mul_ps(two, b), p01), _mm256_mul_ps(a, p11))));
+
+		// Lowpass filter error, residual variance, and Kalman gain.
+		__m256 err = _mm256_sub_ps(_mm256_loadu_ps(y + k), x_1);
+		__m256 s = _mm256_add_ps(p_11, r_k);
+		__m256 k0 = _mm256_div_ps(p_10, s);
+		__m256 k1 = _mm256_div_ps(p_11, s);
+		__m256 r_s = _mm256_div_ps(r_k, s);
+
+		_mm256_storeu_ps(posterior + k, _mm256_add_ps(x0, _mm256_mul_ps(k0, err)));
+		_mm256_storeu_ps(posterior + lanes + k, _mm256_add_ps(x_1, _mm256_mul_ps(k1, err)));
+		_mm256_storeu_ps(posterior + 2 * lanes + k, _mm256_div_ps(_mm256_sub_ps(_mm256_mul_ps(p_00, _mm256_add_ps(_mm256_mul_ps(aa, p11), r_k)), _mm256_mul_ps(_mm256_mul_ps(aa, p10), p10)), s));
+		_mm256_storeu_ps(posterior + 3 * lanes + k, _mm256_mul_ps(p_10, r_s));
+		_mm256_storeu_ps(posterior + 4 * lanes + k, _mm256_mul_ps(p_10, r_s));
+		_mm256_storeu_ps(posterior + 5 * lanes + k, _mm256_mul_ps(p_11, r_s));
+
+		_mm256_storeu_ps(residual + k, s);
+		_mm256_storeu_ps(error + k, _mm256_div_ps(_mm256_mul_ps(err, err), s));
+	}
+
+	_mm256_zeroupper();
+}
+
+__attribute__((target("avx2,fma")))
+static void combineCostsAvx2(float* combined, size_t combinations, const float* logs, const float* errors, size_t lanes) {
+	const __m256 half = _mm256_set1_ps(0.5f);
+
+	for (size_t k = 0; k < lanes; k += 8) {
+		__m256 cost_0 = _mm256_mul_ps(half, _mm256_add_ps(_mm256_loadu_ps(logs + k), _mm256_loadu_ps(errors + k)));
+		__m256 cost_1 = _mm256_mul_ps(half, _mm256_add_ps(_mm256_loadu_ps(logs + lanes + k), _mm256_loadu_ps(errors + lanes + k)));
+		__m256 cost_2 = _mm256_mul_ps(half, _mm256_add_ps(_mm256_loadu_ps(logs + 2 * lanes + k), _mm256_loadu_ps(errors + 2 * lanes + k)));
+
+		for (size_t c = combinations; c-- > 0;) {
+			__m256 previous = _mm256_loadu_ps(combined + c * lanes + k);
+			float* extended = combined + 3 * c * lanes + k;
+
+			_mm256_storeu_ps(extended + 2 * lanes, _mm256_add_ps(previous, cost_2));
+			_mm256_storeu_ps(extended + lanes, _mm256_add_ps(previous, cost_1));
+			_mm256_storeu_ps(extended, _mm256_add_ps(previous, cost_0));
+		}
+	}
+
+	_mm256_zeroupper();
+}
+
+// States are compared as floats, so that choosing between them takes the same instructions as choosing between costs.
+__attribute__((target("avx2,fma")))
+static void minPlusLanesAvx2(const float* old_costs, const int* states, const float* combined, const int* combinations, const float* probabilities, size_t count, size_t lanes, float* minimum_cost, int* minimum_state) {
+	for (size_t k = 0; k < lanes; k += 8) {
+		__m256 minimum = _mm256_set1_ps(INFINITY);
+		__m256 state = _mm256_set1_ps(0.0f);
+
+		for (size_t i = 0; i < count; i++) {
+			__m256 cost = _mm256_sub_ps(_mm256_add_ps(_mm256_loadu_ps(old_costs + states[i] * lanes + k), _mm256_loadu_ps(combined + combinations[i] * lanes + k)), _mm256_loadu_ps(probabilities + i * lanes + k));
+			__m256 better = _mm256_cmp_ps(cost, minimum, _CMP_LT_OQ);
+
+			minimum = _mm256_blendv_ps(minimum, cost, better);
+			state = _mm256_blendv_ps(state, _mm256_set1_ps(float(states[i])), better);
+		}
+
+		_mm256_storeu_ps(minimum_cost + k, minimum);
+		_mm256_storeu_si256((__m256i*) (minimum_state + k), _mm256_cvttps_epi32(state));
+	}
+
+	_mm256_zeroupper();
+}
+
+static const KernelTable Avx2Kernels = {"avx2", sumOfSquaresAvx2, dotProductAvx2, reduceSpectrumAvx2, findPeaksAvx2, decimateHalfbandAvx2, SIRENS_MATH_KERNELS(Avx2), filterLanesAvx2, combineCostsAvx2, minPlusLanesAvx2};
+
+// AVX-512. Partial vectors at the end are handled with masked loads.
+
+__attribute__((target("avx512f")))
+static inline __mmask16 getTailMask(size_t remaining) {
+	return remaining >= 16 ? __mmask16(0xffff) : __mmask16((1u << remaining) - 1);
+}
+
+__attribute__((target("avx512f")))
+static double sumOfSquaresAvx512(const float* samples, size_t count) {
+	__m512d low = _mm512_setzero_pd();
+	__m512d high = _mm512_setzero_pd();
+	size_t i = 0;
+
+	for (; i + 16 <= count; i += 16) {
+		__m256 x_low = _mm256_loadu_ps(samples + i);
+		__m256 x_high = _mm256_loadu_ps(samples + i + 8);
+
+		low = _mm512_add_pd(low, _mm512_cvtps_pd(_mm256_mul_ps(x_low, x_low)));
+		high = _mm512_add_pd(high, _mm512_cvtps_pd(_mm256_mul_ps(x_high, x_high)));
+	}
+
+	return _mm512_reduce_add_pd(_mm512_add_pd(low, high)) + sumOfSquaresScalar(samples + i, count - i);
+}
+
+__attribute__((target("avx512f")))
+static float dotProductAvx512(const float* a, const float* b, size_t count) {
+	__m512 sum = _mm512_setzero_ps();
+
+	for (size_t i = 0; i < count; i += 16) {
+		__mmask16 mask = getTailMask(count - i);
+		sum = _mm512_fmadd_ps(_mm512_maskz_loadu_ps(mask, a + i), _mm512_maskz_loadu_ps(mask, b + i), sum);
+	}
+
+	return _mm512_reduce_add_ps(sum);
+}
+
+__attribute__((target("avx512f")))
+static void reduceSpectrumAvx512(const float* spectrum, const float* weights, const float* moments, size_t count, SpectrumStatistics& statistics) {
+	// Zero is a safe fill for the masked lanes: the max starts at zero anyway.
+	__m512 max = _mm512_setzero_ps();
+	__m512 sum = _mm512_setzero_ps();
+	__m512 power = _mm512_setzero_ps();
+	__m512 moment = _mm512_setzero_ps();
+
+	if (weights) {
+		for (size_t i = 0; i < count; i += 16) {
+			__mmask16 mask = getTailMask(count - i);
+			__m512 bin = _mm512_maskz_loadu_ps(mask, spectrum + i);
+			__m512 bin_power = _mm512_mul_ps(bin, bin);
+
+			max = _mm512_max_ps(max, bin);
+			sum = _mm512_add_ps(sum, bin);
+			power = _mm512_fmadd_ps(bin_power, _mm512_maskz_loadu_ps(mask, weights + i), power);
+			moment = _mm512_fmadd_ps(bin_power, _mm512_maskz_loadu_ps(mask, moments + i), moment);
+		}
+	} else {
+		for (size_t i = 0; i < count; i += 16) {
+			__m512 bin = _mm512_maskz_loadu_ps(getTailMask(count - i), spectrum + i);
+
+			max = _mm512_max_ps(max, bin);
+			sum = _mm512_add_ps(sum, bin);
+		}
+	}
+
+	statistics.max = _mm512_reduce_max_ps(max);
+	statistics.sum = _mm512_reduce_add_ps(sum);
+	statistics.weightedPower = _mm512_reduce_add_ps(power);
+	statistics.weightedMoment = _mm512_reduce_add_ps(moment);
+}
+
+__attribute__((target("avx512f")))
+static size_t findPeaksAvx512(const float* spectrum, size_t begin, size_t end, size_t radius, int* indices) {
+	size_t count = 0;
+	size_t k = begin;
+
+	for (; k + 16 <= end; k += 16) {
+		__m512 maxel = _mm512_setzero_ps();
+
+		for (size_t i = k - radius; i <= k + radius; i++)
+			maxel = _mm512_max_ps(maxel, _mm512_loadu_ps(spectrum + i));
+
+		count = appendPeaks(_mm512_cmp_ps_mask(_mm512_loadu_ps(spectrum + k), maxel, _CMP_GE_OQ), k, indices, count);
+	}
+
+	_mm256_zeroupper();
+
+	return count + findPeaksAvx2(spectrum, k, end, radius, indices + count);
+}
+
+// Every other value, starting with x[0], of the 32 at x.
+__attribute__((target("avx512f")))
+static inline __m512 loadEvenAvx512(const float* x, __m512i evens) {
+	return _mm512_permutex2var_ps(_mm512_loadu_ps(x), evens, _mm512_loadu_ps(x + 16));
+}
+
+__attribute__((target("avx512f")))
+static void decimateHalfbandAvx512(const float* input, const float* coefficients, size_t taps, float* output, size_t count) {
+	const __m512 half = _mm512_set1_ps(0.5f);
+	const __m512i evens = _mm512_set_epi32(30, 28, 26, 24, 22, 20, 18, 16, 14, 12, 10, 8, 6, 4, 2, 0);
+	size_t i = 0;
+
+	for (; i + 16 <= count; i += 16) {
+		const float* center = input + 2 * i;
+		__m512 sum = _mm512_mul_ps(half, loadEvenAvx512(center, evens));
+
+		for (size_t t = 0; t < taps; t++) {
+			__m512 pair = _mm512_add_ps(loadEvenAvx512(center - 1 - 2 * ptrdiff_t(t), evens), loadEvenAvx512(center + 1 + 2 * t, evens));
+			sum = _mm512_fmadd_ps(_mm512_set1_ps(coefficients[t]), pair, sum);
+		}
+
+		_mm512_storeu_ps(output + i, sum);
+	}
+
+	_mm256_zeroupper();
+	decimateHalfbandAvx2(input + 2 * i, coefficients, taps, output + i, count - i);
+}
+
+#ifndef SIRENS_EXACT_MATH
+
+__attribute__((target("avx512f")))
+static inline __m512 logAvx512(__m512 x) {
+	using namespace FastMath;
+
+	__mmask16 invalid = _mm512_cmp_ps_mask(x, _mm512_setzero_ps(), _CMP_LE_OQ);
+	__m512i bits = _mm512_castps_si512(_mm512_max_ps(x, _mm512_set1_ps(FLT_MIN)));
+
+	// x = m * 2^e with m in [sqrt(0.5), sqrt(2)).
+	__m512 e = _mm512_cvtepi32_ps(_mm512_sub_epi32(_mm512_srli_epi32(bits, 23), _mm512_set1_epi32(127)));
+	__m512 m = _mm512_castsi512_ps(_mm512_or_si512(_mm512_and_si512(bits, _mm512_set1_epi32(0x007fffff)), _mm512_set1_epi32(0x3f800000)));
+	__mmask16 large = _mm512_cmp_ps_mask(m, _mm512_set1_ps(Sqrt2), _CMP_GT_OQ);
+
+	m = _mm512_mask_mul_ps(m, large, m, _mm512_set1_ps(0.5f));
+	e = _mm512_mask_add_ps(e, large, e, _mm512_set1_ps(1.0f));
+
+	__m512 f = _mm512_sub_ps(m, _mm512_set1_ps(1.0f));
+	__m512 z = _mm512_mul_ps(f, f);
+	__m512 p = _mm512_set1_ps(LogCoefficients[0]);
+
+	for (int i = 1; i < LogTerms; i++)
+		p = _mm512_fmadd_ps(p, f, _mm512_set1_ps(LogCoefficients[i]));
+
+	__m512 y = _mm512_sub_ps(_mm512_fmadd_ps(_mm512_mul_ps(p, f), z, _mm512_mul_ps(_mm512_set1_ps(Ln2Low), e)), _mm512_mul_ps(_mm512_set1_ps(0.5f), z));
+	__m512 result = _mm512_fmadd_ps(_mm512_set1_ps(Ln2High), e, _mm512_add_ps(f, y));
+
+	return _mm512_mask_blend_ps(invalid, result, _mm512_set1_ps(-INFINITY));
+}
+
+__attribute__((target("avx512f")))
+static inline __m512 expAvx512(__m512 x) {
+	using namespace FastMath;
+
+	__mmask16 underflow = _mm512_cmp_ps_mask(x, _mm512_set1_ps(ExpMin), _CMP_LT_OQ);
+	x = _mm512_max_ps(_mm512_min_ps(x, _mm512_set1_ps(ExpMax)), _mm512_set1_ps(ExpMin));
+
+	// x = n * ln(2) + r with |r| <= ln(2) / 2.
+	__m512i n = _mm512_cvtps_epi32(_mm512_mul_ps(x, _mm512_set1_ps(Log2e)));
+	__m512 n_float = _mm512_cvtepi32_ps(n);
+	__m512 r = _mm512_fnmadd_ps(n_float, _mm512_set1_ps(Ln2Low), _mm512_fnmadd_ps(n_float, _mm512_set1_ps(Ln2High), x));
+	__m512 p = _mm512_set1_ps(ExpCoefficients[0]);
+
+	for (int i = 1; i < ExpTerms; i++)
+		p = _mm512_fmadd_ps(p, r, _mm512_set1_ps(ExpCoefficients[i]));
+
+	__m512 y = _mm512_add_ps(_mm512_fmadd_ps(_mm512_mul_ps(p, r), r, r), _mm512_set1_ps(1.0f));
+	__m512 scale = _mm512_castsi512_ps(_mm512_slli_epi32(_mm512_add_epi32(n, _mm512_set1_epi32(127)), 23));
+
+	return _mm512_maskz_mul_ps(__mmask16(~underflow), y, scale);
+}
+
+__attribute__((target("avx512f")))
+static void naturalLogAvx512(const float* x, float* y, size_t count) {
+	for (size_t i = 0; i < count; i += 16) {
+		__mmask16 mask = getTailMask(count - i);
+		_mm512_mask_storeu_ps(y + i, mask, logAvx512(_mm512_maskz_loadu_ps(mask, x + i)));
+	}
+}
+
+__attribute__((target("avx512f")))
+static void exponentialAvx512(const float* x, float* y, size_t count) {
+	for (size_t i = 0; i < count; i += 16) {
+		__mmask16 mask = getTailMask(count - i);
+		_mm512_mask_storeu_ps(y + i, mask, expAvx512(_mm512_maskz_loadu_ps(mask, x + i)));
+	}
+}
+
+#endif
+
+// The sweep's 8 lanes fill an AVX2 vector, so its lane kernels are the AVX2 ones.
+static const KernelTable Avx512Kernels = {"avx512", sumOfSquaresAvx512, dotProductAvx512, reduceSpectrumAvx512, findPeaksAvx512, decimateHalfbandAvx512, SIRENS_MATH_KERNELS(Avx512), filterLanesAvx2, combineCostsAvx2, minPlusLanesAvx2};
+
+#endif
+
+#ifdef SIRENS_KERNELS_NEON
+
+// NEON (64-bit ARM, where it is always present.)
+
+static double sumOfSquaresNeon(const float* samples, size_t count) {
+	float64x2_t low = vdupq_n_f64(0);
+	float64x2_t high = vdupq_n_f64(0);
+	size_t i = 0;
+
+	for (; i + 4 <= count; i += 4) {
+		float32x4_t x = vld1q_f32(samples + i);
+		float32x4_t square = vmulq_f32(x, x);
+
+		low = vaddq_f64(low, vcvt_f64_f32(vget_low_f32(square)));
+		high = vaddq_f64(high, vcvt_high_f64_f32(square));
+	}
+
+	return vaddvq_f64(vaddq_f64(low, high)) + sumOfSquaresScalar(samples + i, count - i);
+}
+
+static float dotProductNeon(const float* a, const float* b, size_t count) {
+	float32x4_t sum = vdupq_n_f32(0);
+	size_t i = 0;
+
+	for (; i + 4 <= count; i += 4)
+		sum = vfmaq_f32(sum, vld1q_f32(a + i), vld1q_f32(b + i));
+
+	return vaddvq_f32(sum) + dotProductScalar(a + i, b + i, count - i);
+}
+
+static void reduceSpectrumNeon(const float* spectrum, const float* weights, const float* moments, size_t count, SpectrumStatistics& statistics) {
+	float32x4_t max = vdupq_n_f32(0);
+	float32x4_t sum = vdupq_n_f32(0);
+	float32x4_t power = vdupq_n_f32(0);
+	float32x4_t moment = vdupq_n_f32(0);
+	size_t i = 0;
+
+	if (weights) {
+		for (; i + 4 <= count; i += 4) {
+			float32x4_t bin = vld1q_f32(spectrum + i);
+			float32x4_t bin_power = vmulq_f32(bin, bin);
+
+			max = vmaxq_f32(max, bin);
+			sum = vaddq_f32(sum, bin);
+			power = vfmaq_f32(power, bin_power, vld1q_f32(weights + i));
+			moment = vfmaq_f32(moment, bin_power, vld1q_f32(moments + i));
+		}
+	} else {
+		for (; i + 4 <= count; i += 4) {
+			float32x4_t bin = vld1q_f32(spectrum + i);
+
+			max = vmaxq_f32(max, bin);
+			sum = vaddq_f32(sum, bin);
+		}
+	}
+
+	float max_lanes[4], sum_lanes[4], power_lanes[4], moment_lanes[4];
+	vst1q_f32(max_lanes, max);
+	vst1q_f32(sum_lanes, sum);
+	vst1q_f32(power_lanes, power);
+	vst1q_f32(moment_lanes, moment);
+
+	finishReduction(spectrum, weights, moments, i, count, max_lanes, sum_lanes, power_lanes, moment_lanes, 4, statistics);
+}
+
+static size_t findPeaksNeon(const float* spectrum, size_t begin, size_t end, size_t radius, int* indices) {
+	size_t count = 0;
+	size_t k = begin;
+
+	for (; k + 4 <= end; k += 4) {
+		float32x4_t maxel = vdupq_n_f32(0);
+
+		for (size_t i = k - radius; i <= k + radius; i++)
+			maxel = vmaxq_f32(maxel, vld1q_f32(spectrum + i));
+
+		uint32x4_t peaks = vcgeq_f32(vld1q_f32(spectrum + k), maxel);
+
+		if (vgetq_lane_u32(peaks, 0)) indices[count++] = int(k);
+		if (vgetq_lane_u32(peaks, 1)) indices[count++] = int(k + 1);
+		if (vgetq_lane_u32(peaks, 2)) indices[count++] = int(k + 2);
+		if (vgetq_lane_u32(peaks, 3)) indices[count++] = int(k + 3);
+	}
+
+	return count + findPeaksScalar(spectrum, k, end, radius, indices + count);
+}
+
+static void decimateHalfbandNeon(const float* input, const float* coefficients, size_t taps, float* output, size_t count) {
+	size_t i = 0;
+
+	// vld2q_f32(x).val[0] is every other value, starting with x[0], of the 8 at x.
+	for (; i + 4 <= count; i += 4) {
+		const float* center = input + 2 * i;
+		float32x4_t sum = vmulq_n_f32(vld2q_f32(center).val[0], 0.5f);
+
+		for (size_t t = 0; t < taps; t++) {
+			float32x4_t pair = vaddq_f32(vld2q_f32(center - 1 - 2 * ptrdiff_t(t)).val[0], vld2q_f32(center + 1 + 2 * t).val[0]);
+			sum = vfmaq_n_f32(sum, pair, coefficients[t]);
+		}
+
+		vst1q_f32(output + i, sum);
+	}
+
+	decimateHalfbandScalar(input + 2 * i, coefficients, taps, output + i, count - i);
+}
+
+#ifndef SIRENS_EXACT_MATH
+
+static inline float32x4_t logNeon(float32x4_t x) {
+	using namespace FastMath;
+
+	uint32x4_t invalid = vcleq_f32(x, vdupq_n_f32(0));
+	uint32x4_t bits = vreinterpretq_u32_f32(vmaxq_f32(x, vdupq_n_f32(FLT_MIN)));
+
+	// x = m * 2^e with m in [sqrt(0.5), sqrt(2)).
+	float32x4_t e = vcvtq_f32_s32(vsubq_s32(vreinterpretq_s32_u32(vshrq_n_u32(bits, 23)), vdupq_n_s32(127)));
+	float32x4_t m = vreinterpretq_f32_u32(vorrq_u32(vandq_u32(bits, vdupq_n_u32(0x007fffff)), vdupq_n_u32(0x3f800000)));
+	uint32x4_t large = vcgtq_f32(m, vdupq_n_f32(Sqrt2));
+
+	m = vbslq_f32(large, vmulq_n_f32(m, 0.5f), m);
+	e = vbslq_f32(large, vaddq_f32(e, vdupq_n_f32(1)), e);
+
+	float32x4_t f = vsubq_f32(m, vdupq_n_f32(1));
+	float32x4_t z = vmulq_f32(f, f);
+	float32x4_t p = vdupq_n_f32(LogCoefficients[0]);
+
+	for (int i = 1; i < LogTerms; i++)
+		p = vfmaq_f32(vdupq_n_f32(LogCoefficients[i]), p, f);
+
+	float32x4_t y = vsubq_f32(vfmaq_f32(vmulq_n_f32(e, Ln2Low), vmulq_f32(p, f), z), vmulq_n_f32(z, 0.5f));
+	float32x4_t result = vfmaq_n_f32(vaddq_f32(f, y), e, Ln2High);
+
+	return vbslq_f32(invalid, vdupq_n_f32(-INFINITY), result);
+}
+
+static inline float32x4_t expNeon(float32x4_t x) {
+	using namespace FastMath;
+
+	uint32x4_t underflow = vcltq_f32(x, vdupq_n_f32(ExpMin));
+	x = vmaxq_f32(vminq_f32(x, vdupq_n_f32(ExpMax)), vdupq_n_f32(ExpMin));
+
+	// x = n * ln(2) + r with |r| <= ln(2) / 2.
+	int32x4_t n = vcvtnq_s32_f32(vmulq_n_f32(x, Log2e));
+	float32x4_t n_float = vcvtq_f32_s32(n);
+	float32x4_t r = vfmsq_n_f32(vfmsq_n_f32(x, n_float, Ln2High), n_float, Ln2Low);
+	float32x4_t p = vdupq_n_f32(ExpCoefficients[0]);
+
+	for (int i = 1; i < ExpTerms; i++)
+		p = vfmaq_f32(vdupq_n_f32(ExpCoefficients[i]), p, r);
+
+	float32x4_t y = vaddq_f32(vfmaq_f32(r, vmulq_f32(p, r), r), vdupq_n_f32(1));
+	float32x4_t scale = vreinterpretq_f32_s32(vshlq_n_s32(vaddq_s32(n, vdupq_n_s32(127)), 23));
+
+	return vbslq_f32(underflow, vdupq_n_f32(0), vmulq_f32(y, scale));
+}
+
+static void naturalLogNeon(const float* x, float* y, size_t count) {
+	size_t i = 0;
+
+	for (; i + 4 <= count; i += 4)
+		vst1q_f32(y + i, logNeon(vld1q_f32(x + i)));
+
+	naturalLogScalar(x + i, y + i, count - i);
+}
+
+static void exponentialNeon(const float* x, float* y, size_t count) {
+	size_t i = 0;
+
+	for (; i + 4 <= count; i += 4)
+		vst1q_f32(y + i, expNeon(vld1q_f32(x + i)));
+
+	exponentialScalar(x + i, y + i, count - i);
+}
+
+#endif
+
+static void filterLanesNeon(const float* prior, float* posterior, const float* y, const float* r, const float* q, const float* alpha, float* residual, float* error, size_t lanes) {
+	const float32x4_t one = vdupq_n_f32(1.0f);
+	const float32x4_t two = vdupq_n_f32(2.0f);
+
+	for (size_t k = 0; k < lanes; k += 4) {
+		float32x4_t x0 = vld1q_f32(prior + k), x1 = vld1q_f32(prior + lanes + k);
+		float32x4_t p00 = vld1q_f32(prior + 2 * lanes + k), p01 = vld1q_f32(prior + 3 * lanes + k), p10 = vld1q_f32(prior + 4 * lanes + k), p11 = vld1q_f32(prior + 5 * lanes + k);
+		float32x4_t a = vld1q_f32(alpha + k), b = vsubq_f32(one, a), r_k = vld1q_f32(r + k);
+		float32x4_t aa = vmulq_f32(a, a);
+
+		// Prediction and its covariance.
+		float32x4_t x_1 = vaddq_f32(vmulq_f32(b, x0), vmulq_f32(a, x1));
+		float32x4_t p_00 = vaddq_f32(p00, vld1q_f32(q + k));
+		float32x4_t p_10 = vaddq_f32(vmulq_f32(b, p_00), vmulq_f32(a, p10));
+		float32x4_t p_11 = vaddq_f32(vmulq_f32(vmulq_f32(b, b), p_00), vmulq_f32(a, vaddq_f32(vmulq_f32(vmulq_f32(two, b), p01), vmulq_f32(a, p11))));
+
+		// Lowpass filter error, residual variance, and Kalman gain.
+		float32x4_t err = vsubq_f32(vld1q_f32(y + k), x_1);
+		float32x4_t s = vaddq_f32(p_11, r_k);
+		float32x4_t k0 = vdivq_f32(p_10, s);
+		float32x4_t k1 = vdivq_f32(p_11, s);
+		float32x4_t r_s = vdivq_f32(r_k, s);
+
+		vst1q_f32(posterior + k, vaddq_f32(x0, vmulq_f32(k0, err)));
+		vst1q_f32(posterior + lanes + k, vaddq_f32(x_1, vmulq_f32(k1, err)));
+		vst1q_f32(posterior + 2 * lanes + k, vdivq_f32(vsubq_f32(vmulq_f32(p_00, vaddq_f32(vmulq_f32(aa, p11), r_k)), vmulq_f32(vmulq_f32(aa, p10), p10)), s));
+		vst1q_f32(posterior + 3 * lanes + k, vmulq_f32(p_10, r_s));
+		vst1q_f32(posterior + 4 * lanes + k, vmulq_f32(p_10, r_s));
+		vst1q_f32(posterior + 5 * lanes + k, vmulq_f32(p_11, r_s));
+
+		vst1q_f32(residual + k, s);
+		vst1q_f32(error + k, vdivq_f32(vmulq_f32(err, err), s));
+	}
+}
+
+static void combineCostsNeon(float* combined, size_t combinations, const float* logs, const float* errors, size_t lanes) {
+	const float32x4_t half = vdupq_n_f32(0.5f);
+
+	for (size_t k = 0; k < lanes; k += 4) {
+		float32x4_t cost_0 = vmulq_f32(half, vaddq_f32(vld1q_f32(logs + k), vld1q_f32(errors + k)));
+		float32x4_t cost_1 = vmulq_f32(half, vaddq_f32(vld1q_f32(logs + lanes + k), vld1q_f32(errors + lanes + k)));
+		float32x4_t cost_2 = vmulq_f32(half, vaddq_f32(vld1q_f32(logs + 2 * lanes + k), vld1q_f32(errors + 2 * lanes + k)));
+
+		for (size_t c = combinations; c-- > 0;) {
+			float32x4_t previous = vld1q_f32(combined + c * lanes + k);
+			float* extended = combined + 3 * c * lanes + k;
+
+			vst1q_f32(extended + 2 * lanes, vaddq_f32(previous, cost_2));
+			vst1q_f32(extended + lanes, vaddq_f32(previous, cost_1));
+			vst1q_f32(extended, vaddq_f32(previous, cost_0));
+		}
+	}
+}
+
+// States are compared as floats, so that choosing between them takes the same instructions as choosing between costs.
+static void minPlusLanesNeon(const float* old_costs, const int* states, const float* combined, const int* combinations, const float* probabilities, size_t count, size_t lanes, float* minimum_cost, int* minimum_state) {
+	for (size_t k = 0; k < lanes; k += 4) {
+		float32x4_t minimum = vdupq_n_f32(INFINITY);
+		float32x4_t state = vdupq_n_f32(0.0f);
+
+		for (size_t i = 0; i < count; i++) {
+			float32x4_t cost = vsubq_f32(vaddq_f32(vld1q_f32(old_costs + states[i] * lanes + k), vld1q_f32(combined + combinations[i] * lanes + k)), vld1q_f32(probabilities + i * lanes + k));
+			uint32x4_t better = vcltq_f32(cost, minimum);
+
+			minimum = vbslq_f32(better, cost, minimum);
+			state = vbslq_f32(better, vdupq_n_f32(float(states[i])), state);
+		}
+
+		vst1q_f32(minimum_cost + k, minimum);
+		vst1q_s32(minimum_state + k, vcvtq_s32_f32(state));
+	}
+}
+
+static const KernelTable NeonKernels = {"neon", sumOfSquaresNeon, dotProductNeon, reduceSpectrumNeon, findPeaksNeon, decimateHalfbandNeon, SIRENS_MATH_KERNELS(Neon), filterLanesNeon, combineCostsNeon, minPlusLanesNeon};
+
+#endif
+
+// The implementations this processor can run, best first.
+static size_t getSupportedKernels(const KernelTable** tables) {
+	size_t count = 0;
+
+#ifdef SIRENS_KERNELS_X86
+	__builtin_cpu_init();
+
+	if (__builtin_cpu_supports("avx512f"))
+		tables[count++] = &Avx512Kernels;
+
+	if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma"))
+		tables[count++] = &Avx2Kernels;
+
+	if (__builtin_cpu_supports("sse2"))
+		tables[count++] = &Sse2Kernels;
+#endif
+
+#ifdef SIRENS_KERNELS_NEON
+	tables[count++] = &NeonKernels;
+#endif
+
+	tables[count++] = &ScalarKernels;
+	return count;
+}
+
+static const KernelTable& selectKernels() {
+	const KernelTable* tables[5];
+	size_t count = getSupportedKernels(tables);
+
+	const char* requested = getenv("SIRENS_KERNELS");
+
+	if (requested != NULL) {
+		for (size_t i = 0; i < count; i++) {
+			if (strcmp(requested, tables[i]->name) == 0)
+				return *tables[i];
+		}
+	}
+
+	return *tables[0];
+}
+
+const KernelTable& getKernels() {
+	static const KernelTable& kernels = selectKernels();
+	return kernels;
+}
+
+// Make the selection when the library is loaded rather than on the first block.
+static const KernelTable& LoadTimeKernels = getKernels();
@@ -0,0 +1,66 @@
+#ifndef _KERNELS_H
+#define _KERNELS_H
+
+#include "SpectrumReduction.h"
+
+#include <cstddef>
+
+/*
+	Inner loops of the feature plugins, with one implementation per instruction set, selected once when the library
+	is loaded. A single build runs AVX-512 where the processor has it and falls back to AVX2, SSE2 or plain C++ on
+	older ones (NEON on 64-bit ARM).
+
+	The SIMD versions accumulate in more lanes than the scalar ones, so sums can differ from them in the last bits.
+	Setting the SIRENS_KERNELS environment variable to one of the names below (scalar, sse2, avx2, avx512, neon)
+	forces that implementation, if the processor supports it, for comparing results or timing.
+*/
+struct KernelTable {
+	const char* name;
+
+	// Sum of squares of count samples, accumulated in double (BlockEnergy, for Loudness and TemporalSparsity.)
+	double (*sumOfSquares)(const float* samples, size_t count);
+
+	// Sum of a[i] * b[i] (TransientIndex filterbank and DCT.)
+	float (*dotProduct)(const float* a, const float* b, size_t count);
+
+	// Max and sum of count bins, and, if weights isn't NULL, the weighted sums of squares (SpectrumReduction, for
+	// SpectralSparsity and SpectralCentroid.)
+	void (*reduceSpectrum)(const float* spectrum, const float* weights, const float* moments, size_t count, SpectrumStatistics& statistics);
+
+	// Bins k in [begin, end) that are at least as large as every bin within radius of them (and nonnegative),
+	// written to indices in ascending order. Returns their number (Harmonicity peak picking.)
+	size_t (*findPeaks)(const float* spectrum, size_t begin, size_t end, size_t radius, int* indices);
+
+	// output[i] = input[2i] / 2 + the sum over t < taps of coefficients[t] * (input[2i - 1 - 2t] + input[2i + 1 + 2t]),
+	// for i < count: a halfband lowpass filter evaluated only at the samples that decimation by 2 keeps (Harmonicity's
+	// decimated analysis.) input must be readable from input[1 - 2 * taps] to input[2 * (count + taps) - 2].
+	void (*decimateHalfband)(const float* input, const float* coefficients, size_t taps, float* output, size_t count);
+
+	// y[i] = log(x[i]) and y[i] = exp(x[i]), with the accuracy and ranges of fastLog and fastExp (see FastMath.h). y
+	// may be x.
+	void (*naturalLog)(const float* x, float* y, size_t count);
+	void (*exponential)(const float* x, float* y, size_t count);
+
+	// The lane loops of SegmenterSweep's fast mode, which runs lanes independent segmentations side by side. Arrays
+	// hold lanes consecutive values per row, and lanes must be a multiple of 8.
+
+	// One step of Segmenter::KalmanLPF in every lane. prior and posterior hold the means x0 and x1, then the
+	// covariances p00, p01, p10 and p11, one row each. residual gets the residual variance s and error gets err^2 / s,
+	// so that the filter's cost is (log(s) + err^2 / s) / 2. The covariances are updated in forms that stay accurate
+	// in float when q is huge, as it is at a segment's onset.
+	void (*filterLanes)(const float* prior, float* posterior, const float* y, const float* r, const float* q, const float* alpha, float* residual, float* error, size_t lanes);
+
+	// Extend costs summed over some features to one more feature, in place: with cost[m] = (logs[m] + errors[m]) / 2
+	// the feature's cost in mode m (rows m = 0, 1, 2), combined[3c + m] = combined[c] + cost[m] for every row c <
+	// combinations.
+	void (*combineCosts)(float* combined, size_t combinations, const float* logs, const float* errors, size_t lanes);
+
+	// Min-plus over count transitions: minimum_cost gets the least old_costs[states[i]] + combined[combinations[i]] -
+	// probabilities[i] (rows) over i, and minimum_state the first states[i] that reaches it, or 0 if none is finite.
+	void (*minPlusLanes)(const float* old_costs, const int* states, const float* combined, const int* combinations, const float* probabilities, size_t count, size_t lanes, float* minimum_cost, int* minimum_state);
+};
+
+// The implementation selected for this processor.
+const KernelTable& getKernels();
+
+#endif
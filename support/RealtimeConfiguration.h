@@ -0,0 +1,111 @@
+#ifndef _REALTIMECONFIGURATION_H
+#define _REALTIMECONFIGURATION_H
+
+#include <atomic>
+#include <cstddef>
+#include <utility>
+
+/*
+	Double-buffered configuration for plugins whose parameters can change while process() runs on another thread
+	(TransientIndex, TemporalSparsity, Harmonicity).
+
+	The control thread (setParameter) builds a complete new configuration, tables and all, and publishes it with an
+	atomic exchange. The processing thread calls update() at the start of each block, which adopts the newest published
+	configuration, if there is one, and otherwise costs one relaxed load. The configuration it replaces is pushed onto a
+	lock-free list of retired ones, which the control thread frees on its next publish() or collect(). The processing
+	thread never allocates, frees, or waits, and never sees a configuration that is half built or being freed.
+
+	If several configurations are published between two blocks, only the newest is adopted; the others are freed by
+	publish() directly, since the processing thread never saw them.
+*/
+template <typename T>
+class RealtimeConfiguration {
+private:
+	struct Node {
+		T value;
+		Node* next;
+
+		template <typename... Arguments>
+		Node(Arguments&&... arguments) : value(std::forward<Arguments>(arguments)...), next(NULL) {
+		}
+	};
+
+	std::atomic<Node*> pending;		// Published and not yet adopted. Exchanged by both threads.
+	Node* current;					// Adopted. Processing thread only (or either thread when nothing is processing.)
+	std::atomic<Node*> retired;		// Replaced, waiting to be freed. Pushed by the processing thread.
+
+	static void freeList(Node* node) {
+		while (node != NULL) {
+			Node* next = node->next;
+			delete node;
+			node = next;
+		}
+	}
+
+public:
+	RealtimeConfiguration() : pending(NULL), current(NULL), retired(NULL) {
+	}
+
+	~RealtimeConfiguration() {
+		delete pending.load();
+		delete current;
+		freeList(retired.load());
+	}
+
+	RealtimeConfiguration(const RealtimeConfiguration&) = delete;
+	RealtimeConfiguration& operator=(const RealtimeConfiguration&) = delete;
+
+	// Control thread. Build a configuration from the arguments to T's constructor and publish it.
+	template <typename... Arguments>
+	void publish(Arguments&&... arguments) {
+		Node* node = new Node(std::forward<Arguments>(arguments)...);
+
+		delete pending.exchange(node, std::memory_order_acq_rel);
+		collect();
+	}
+
+	// Control thread. Free the configurations the processing thread has replaced.
+	void collect() {
+		freeList(retired.exchange(NULL, std::memory_order_acquire));
+	}
+
+	// Processing thread. Adopt the newest published configuration, and return the current one (NULL if none has been
+	// published yet.)
+	T* update() {
+		if (pending.load(std::memory_order_relaxed) != NULL) {
+			Node* node = pending.exchange(NULL, std::memory_order_acq_rel);
+
+			if (node != NULL) {
+				if (current != NULL) {
+					Node* head = retired.load(std::memory_order_relaxed);
+
+					do {
+						current->next = head;
+					} while (!retired.compare_exchange_weak(head, current, std::memory_order_release, std::memory_order_relaxed));
+				}
+
+				current = node;
+			}
+		}
+
+		return current != NULL ? &current->value : NULL;
+	}
+
+	// When nothing is processing (construction, initialise, reset): publish and adopt at once.
+	template <typename... Arguments>
+	T* replace(Arguments&&... arguments) {
+		publish(std::forward<Arguments>(arguments)...);
+
+		T* value = update();
+		collect();
+
+		return value;
+	}
+
+	// The current configuration, as of the last update().
+	T* get() {
+		return current != NULL ? &current->value : NULL;
+	}
+};
+
+#endif
@@ -0,0 +1,72 @@
+#include "SilenceGate.h"
+
+#include <cmath>
+using namespace std;
+
+SilenceGate::SilenceGate() {
+	enabled = false;
+	setThreshold(-120);
+	reset();
+}
+
+void SilenceGate::setEnabled(bool enabled) {
+	this->enabled.store(enabled, memory_order_relaxed);
+}
+
+bool SilenceGate::isEnabled() const {
+	return enabled.load(memory_order_relaxed);
+}
+
+void SilenceGate::setThreshold(float threshold) {
+	this->threshold.store(threshold, memory_order_relaxed);
+	thresholdPower.store(pow(10.0, threshold / 20.0), memory_order_relaxed);
+}
+
+float SilenceGate::getThreshold() const {
+	return threshold.load(memory_order_relaxed);
+}
+
+void SilenceGate::reset() {
+	blocks = 0;
+	skipped = 0;
+}
+
+bool SilenceGate::isSilent(double mean_square) {
+	if (!enabled.load(memory_order_relaxed))
+		return false;
+
+	blocks ++;
+
+	if (mean_square <= 0 || mean_square < thresholdPower.load(memory_order_relaxed)) {
+		skipped ++;
+		return true;
+	}
+
+	return false;
+}
+
+unsigned long SilenceGate::getBlockCount() const {
+	return blocks;
+}
+
+unsigned long SilenceGate::getSkippedCount() const {
+	return skipped;
+}
+
+float SilenceGate::getSkipRate() const {
+	return blocks > 0 ? float(skipped) / float(blocks) : 0;
+}
+
+double SilenceGate::getSpectrumMeanSquare(const float* magnitudes, size_t bins) {
+	if (bins < 2)
+		return 0;
+
+	// Bins other than DC and Nyquist stand for both their positive and negative frequencies.
+	double sum = 0.5 * (double(magnitudes[0]) * magnitudes[0] + double(magnitudes[bins - 1]) * magnitudes[bins - 1]);
+
+	for (size_t i = 1; i < bins - 1; i++)
+		sum += double(magnitudes[i]) * magnitudes[i];
+
+	double size = 2.0 * (bins - 1);
+	return 2 * sum / (size * size);
+}
@@ -0,0 +1,53 @@
+#ifndef _SILENCEGATE_H
+#define _SILENCEGATE_H
+
+#include <atomic>
+#include <cstddef>
+
+/*
+	Energy gate that lets the expensive features (Harmonicity, TransientIndex) skip near-silent blocks.
+
+	The level is measured on the same scale as the Loudness output, 20 * log10 of the block's mean
+	square, so a threshold can be read straight off a Loudness track. Blocks whose level is below the
+	threshold, or that are entirely zero, are silent. The gate counts the blocks it sees and skips, so
+	the plugins can report the skip rate.
+
+	The settings may be changed from the host's thread while isSilent() runs on the processing thread;
+	they are atomic, and a change applies from the next block.
+*/
+class SilenceGate {
+private:
+	std::atomic<bool> enabled;
+	std::atomic<float> threshold;			// dB, on the Loudness scale.
+	std::atomic<double> thresholdPower;	// Mean square corresponding to threshold.
+
+	unsigned long blocks;
+	unsigned long skipped;
+
+public:
+	SilenceGate();
+
+	void setEnabled(bool enabled);
+	bool isEnabled() const;
+
+	void setThreshold(float threshold);
+	float getThreshold() const;
+
+	// Clear the counts.
+	void reset();
+
+	// Whether a block with this mean square should be skipped. Always false while the gate is disabled.
+	bool isSilent(double mean_square);
+
+	unsigned long getBlockCount() const;
+	unsigned long getSkippedCount() const;
+
+	// Fraction of blocks skipped since the last reset.
+	float getSkipRate() const;
+
+	// Mean square of the time-domain block behind a magnitude spectrum of bins bins (DC to Nyquist), by Parseval's
+	// theorem. It includes the effect of whatever window the host applied.
+	static double getSpectrumMeanSquare(const float* magnitudes, size_t bins);
+};
+
+#endif
@@ -0,0 +1,56 @@
+#include "SpectrumReduction.h"
+#include "Kernels.h"
+
+#include <cmath>
+using namespace std;
+
+SpectrumReduction::SpectrumReduction() {
+	blockSize = 0;
+	barkWeights = NULL;
+	barkMoments = NULL;
+}
+
+SpectrumReduction::~SpectrumReduction() {
+	freeMemory();
+}
+
+void SpectrumReduction::freeMemory() {
+	delete [] barkWeights;
+	delete [] barkMoments;
+	
+	barkWeights = NULL;
+	barkMoments = NULL;
+}
+
+void SpectrumReduction::initialize(size_t block_size, float sample_rate) {
+	freeMemory();
+	
+	blockSize = block_size;
+	
+	if (sample_rate > 0 && blockSize > 1) {
+		barkWeights = new float[blockSize];
+		barkMoments = new float[blockSize];
+		
+		float previous_bark = hz_to_bark(0);
+		
+		barkWeights[0] = 0;
+		barkMoments[0] = 0;
+		
+		for (size_t i = 1; i < blockSize; i++) {
+			float bark = hz_to_bark((sample_rate * i) / float(2 * (blockSize - 1)));
+			
+			barkWeights[i] = bark - previous_bark;
+			barkMoments[i] = barkWeights[i] * bark;
+			
+			previous_bark = bark;
+		}
+	}
+}
+
+void SpectrumReduction::reduce(const float* spectrum, SpectrumStatistics& statistics) {
+	getKernels().reduceSpectrum(spectrum, barkWeights, barkMoments, blockSize, statistics);
+}
+
+float SpectrumReduction::hz_to_bark(float hz) {
+	return 6.0 * asinh(hz / 600.0);
+}
@@ -0,0 +1,42 @@
+#ifndef _SPECTRUMREDUCTION_H
+#define _SPECTRUMREDUCTION_H
+
+#include <cstddef>
+
+// Everything the spectral features need from a block, gathered in one pass over the spectrum.
+struct SpectrumStatistics {
+	float max;				// Largest bin value.
+	float sum;				// Sum of bin values.
+	float weightedPower;	// Sum of squared bins (excluding DC), each weighted by its width in barks.
+	float weightedMoment;	// As above, with each term also multiplied by the bin's frequency in barks.
+};
+
+/*
+	One-pass reduction kernel for spectral features (SpectralSparsity, SpectralCentroid, SpectralShape).
+	
+	The Bark tables are only built if requested, and are stored so that bin i's weight and moment are
+	at index i (zero for DC), which keeps the loop a straight sweep; the sweep itself is the
+	reduceSpectrum kernel (see Kernels.h.)
+*/
+class SpectrumReduction {
+private:
+	size_t blockSize;
+	
+	float* barkWeights;		// Width in barks of each bin.
+	float* barkMoments;		// Width in barks of each bin times its frequency in barks.
+	
+	void freeMemory();
+	
+public:
+	SpectrumReduction();
+	~SpectrumReduction();
+	
+	// Set the number of bins. If sample_rate is nonzero, also build the Bark tables for the Bark-weighted sums.
+	void initialize(size_t block_size, float sample_rate = 0);
+	
+	void reduce(const float* spectrum, SpectrumStatistics& statistics);
+	
+	static float hz_to_bark(float hz);
+};
+
+#endif
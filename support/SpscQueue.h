@@ -0,0 +1,83 @@
+#ifndef _SPSCQUEUE_H
+#define _SPSCQUEUE_H
+
+#include "AlignedMemory.h"
+
+#include <atomic>
+#include <cstddef>
+
+/*
+	Bounded lock-free queue between exactly one producer thread and one consumer thread (see Pipeline).
+
+	Items live in a ring allocated up front, and push() and pop() never block or allocate, so the queue can be used
+	from an audio callback. The producer only writes tail and the consumer only writes head; each is published with
+	release ordering after the item is written or read, and the two are kept on separate cache lines so the threads
+	don't contend for one.
+*/
+template <typename T>
+class SpscQueue {
+private:
+	T* items;
+	size_t capacity;
+	size_t mask;
+
+	char padding0[CacheLineSize];
+	std::atomic<size_t> head;	// Next item to pop. Written by the consumer.
+	char padding1[CacheLineSize];
+	std::atomic<size_t> tail;	// Next slot to push. Written by the producer.
+	char padding2[CacheLineSize];
+
+public:
+	// Room for at least minimum_capacity items (rounded up to a power of two.)
+	SpscQueue(size_t minimum_capacity) : head(0), tail(0) {
+		capacity = 1;
+
+		while (capacity < minimum_capacity)
+			capacity *= 2;
+
+		mask = capacity - 1;
+		items = new T[capacity];
+	}
+
+	~SpscQueue() {
+		delete [] items;
+	}
+
+	SpscQueue(const SpscQueue&) = delete;
+	SpscQueue& operator=(const SpscQueue&) = delete;
+
+	// Producer only. Returns false, leaving the queue unchanged, if it is full.
+	bool push(const T& item) {
+		size_t position = tail.load(std::memory_order_relaxed);
+
+		if (position - head.load(std::memory_order_acquire) == capacity)
+			return false;
+
+		items[position & mask] = item;
+		tail.store(position + 1, std::memory_order_release);
+		return true;
+	}
+
+	// Consumer only. Returns false if the queue is empty.
+	bool pop(T& item) {
+		size_t position = head.load(std::memory_order_relaxed);
+
+		if (position == tail.load(std::memory_order_acquire))
+			return false;
+
+		item = items[position & mask];
+		head.store(position + 1, std::memory_order_release);
+		return true;
+	}
+
+	// Number of items queued. Exact only when called from the producer or consumer with the other idle.
+	size_t getSize() const {
+		return tail.load(std::memory_order_acquire) - head.load(std::memory_order_acquire);
+	}
+
+	size_t getCapacity() const {
+		return capacity;
+	}
+};
+
+#endif